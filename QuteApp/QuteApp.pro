@@ -29,6 +29,12 @@ QCSPWD = "../src"
 SOURCES += "$${QCSPWD}/configlists.cpp" \
     "$${QCSPWD}/console.cpp" \
     "$${QCSPWD}/csoundengine.cpp" \
+    "$${QCSPWD}/controlsmoother.cpp" \
+    "$${QCSPWD}/diskrecorder.cpp" \
+    "$${QCSPWD}/midiclock.cpp" \
+    "$${QCSPWD}/midifile.cpp" \
+    "$${QCSPWD}/midiqueue.cpp" \
+    "$${QCSPWD}/tracer.cpp" \
     "$${QCSPWD}/csoundoptions.cpp" \
     "$${QCSPWD}/curve.cpp" \
     "$${QCSPWD}/dockhelp.cpp" \
@@ -50,6 +56,12 @@ SOURCES += "$${QCSPWD}/configlists.cpp" \
     "$${QCSPWD}/quteknob.cpp" \
     "$${QCSPWD}/qutemeter.cpp" \
     "$${QCSPWD}/qutescope.cpp" \
+    "$${QCSPWD}/scopetrigger.cpp" \
+    "$${QCSPWD}/realfft.cpp" \
+    "$${QCSPWD}/spectrumworker.cpp" \
+    "$${QCSPWD}/qutespectrum.cpp" \
+    "$${QCSPWD}/qutespectrogram.cpp" \
+    "$${QCSPWD}/tablepyramid.cpp" \
     "$${QCSPWD}/quteslider.cpp" \
     "$${QCSPWD}/qutespinbox.cpp" \
     "$${QCSPWD}/qutetext.cpp" \
@@ -68,6 +80,13 @@ SOURCES += "$${QCSPWD}/configlists.cpp" \
 HEADERS += "$${QCSPWD}/configlists.h" \
     "$${QCSPWD}/console.h" \
     "$${QCSPWD}/csoundengine.h" \
+    "$${QCSPWD}/controlsmoother.h" \
+    "$${QCSPWD}/diskrecorder.h" \
+    "$${QCSPWD}/hostinput.h" \
+    "$${QCSPWD}/midiclock.h" \
+    "$${QCSPWD}/midifile.h" \
+    "$${QCSPWD}/midiqueue.h" \
+    "$${QCSPWD}/tracer.h" \
     "$${QCSPWD}/csoundoptions.h" \
     "$${QCSPWD}/curve.h" \
     "$${QCSPWD}/dockhelp.h" \
@@ -89,6 +108,14 @@ HEADERS += "$${QCSPWD}/configlists.h" \
     "$${QCSPWD}/quteknob.h" \
     "$${QCSPWD}/qutemeter.h" \
     "$${QCSPWD}/qutescope.h" \
+    "$${QCSPWD}/scopetrigger.h" \
+    "$${QCSPWD}/realfft.h" \
+    "$${QCSPWD}/spectrumworker.h" \
+    "$${QCSPWD}/qutespectrum.h" \
+    "$${QCSPWD}/qutespectrogram.h" \
+    "$${QCSPWD}/tablepyramid.h" \
+    "$${QCSPWD}/graphbuffer.h" \
+    "$${QCSPWD}/tablechanges.h" \
     "$${QCSPWD}/quteslider.h" \
     "$${QCSPWD}/qutespinbox.h" \
     "$${QCSPWD}/qutetext.h" \
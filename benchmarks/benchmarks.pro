@@ -0,0 +1,48 @@
+################################################################################
+# Micro-benchmarks for CsoundQt hot paths (QtTest QBENCHMARK based).
+# Build from the top level source directory with the same options you use
+# for CsoundQt itself, e.g.:
+#   qmake benchmarks/benchmarks.pro CONFIG+=rtmidi
+#   make
+#   ./bin/qcsbench -o results.xml,xml
+#   QT_QPA_PLATFORM=offscreen ./bin/qcsbench -panel file.csd
+# See BUILDING.md for the available output formats.
+################################################################################
+
+# Reuse the full application configuration (dependency detection, defines,
+# sources). Paths in the application project are relative to the top level
+# directory, so they are rebased here.
+include(../qcs.pro)
+
+QCS_ROOT = $$clean_path($$PWD/..)
+
+defineReplace(qcsRebase) {
+	files = $$1
+	rebased =
+	for(f, files) {
+		rebased += $$absolute_path($$f, $$QCS_ROOT)
+	}
+	return($$rebased)
+}
+
+SOURCES = $$qcsRebase($$SOURCES)
+HEADERS = $$qcsRebase($$HEADERS)
+FORMS = $$qcsRebase($$FORMS)
+RESOURCES = $$qcsRebase($$RESOURCES)
+INCLUDEPATH += $$QCS_ROOT/src
+
+# The benchmark provides its own main()
+SOURCES -= $$QCS_ROOT/src/main.cpp
+SOURCES += $$PWD/qcsbench.cpp \
+	$$PWD/panelbench.cpp
+HEADERS += $$PWD/panelbench.h
+
+QT += testlib
+CONFIG += testcase console
+CONFIG -= app_bundle
+
+TRANSLATIONS =
+INSTALLS =
+QMAKE_POST_LINK =
+
+TARGET = qcsbench
@@ -0,0 +1,457 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#include "panelbench.h"
+#include "widgetlayout.h"
+#include "qutescope.h"
+#include "qutegraph.h"
+
+#include <QApplication>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+
+// Allocation counting. With glibc every heap allocation (including Qt
+// container storage, which does not go through operator new) is counted by
+// interposing malloc. Elsewhere only operator new is counted.
+static std::atomic<quint64> allocationCount(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(p, size);
+}
+}
+#else
+void *operator new(std::size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void *p = std::malloc(size > 0 ? size : 1);
+	if (p == 0) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	std::free(p);
+}
+#endif
+
+#define PANELBENCH_SR 44100
+#define PANELBENCH_KSMPS 64
+#define PANELBENCH_FFTSIZE 512
+#define PANELBENCH_TABLESIZE 4096
+
+PanelBench::PanelBench(QObject *parent) : QObject(parent)
+{
+	m_layout = 0;
+	m_scopes = 0;
+	m_graphs = 0;
+	m_fps = 30;
+	m_valueRate = 1000;
+	m_frames = 600;
+	m_warmup = 30;
+	m_counting = false;
+	m_paintEvents = 0;
+
+	// No engine: the scopes read what feedValues() writes, like csThread does
+	m_ud.csEngine = 0;
+	m_ud.csound = 0;
+	m_ud.perfThread = 0;
+	m_ud.wl = 0;
+	m_ud.numChnls = 2;
+	m_ud.sampleRate = PANELBENCH_SR;
+	m_ud.outputBufferSize = PANELBENCH_KSMPS;
+	m_ud.zerodBFS = 1.0;
+	m_spout.resize(PANELBENCH_KSMPS * m_ud.numChnls);
+	qApp->installEventFilter(this);
+}
+
+PanelBench::~PanelBench()
+{
+	qApp->removeEventFilter(this);
+	delete m_layout;
+}
+
+bool PanelBench::loadPanel(QString fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		qWarning() << "PanelBench::loadPanel can't open" << fileName;
+		return false;
+	}
+	QString text = QString::fromUtf8(file.readAll());
+	int start = text.indexOf("<bsbPanel");
+	int end = text.indexOf("</bsbPanel>");
+	if (start < 0 || end < 0) {
+		qWarning() << "PanelBench::loadPanel no widget panel in" << fileName;
+		return false;
+	}
+	QString xml = text.mid(start, end - start + 11);
+	QDomDocument doc;
+	if (!doc.setContent(xml)) {  // Avoid the message box in loadXmlWidgets
+		qWarning() << "PanelBench::loadPanel error parsing panel in" << fileName;
+		return false;
+	}
+	m_fileName = fileName;
+	m_layout = new WidgetLayout(0);
+	m_layout->setOpenProperties(false);
+	connect(m_layout, SIGNAL(registerScope(QuteScope*)),
+			this, SLOT(registerScope(QuteScope*)));
+	connect(m_layout, SIGNAL(registerGraph(QuteGraph*)),
+			this, SLOT(registerGraph(QuteGraph*)));
+	m_layout->loadXmlWidgets(xml);
+	foreach (QuteWidget *widget, m_layout->getWidgets()) {
+		if (!widget->getChannelName().isEmpty()
+				&& !m_channels.contains(widget->getChannelName())) {
+			m_channels << widget->getChannelName();
+		}
+		if (!widget->getChannel2Name().isEmpty()
+				&& !m_channels.contains(widget->getChannel2Name())) {
+			m_channels << widget->getChannel2Name();
+		}
+	}
+	if (m_graphs > 0) {
+		createCurves();
+	}
+	QRect r = m_layout->childrenRect();
+	m_layout->resize(qMax(r.right(), 100), qMax(r.bottom(), 100));
+	m_layout->show();
+	QCoreApplication::sendPostedEvents();
+	return true;
+}
+
+void PanelBench::registerScope(QuteScope *scope)
+{
+	scope->setUd(&m_ud);
+	m_scopes++;
+}
+
+void PanelBench::registerGraph(QuteGraph * /*graph*/)
+{
+	m_graphs++;
+}
+
+// An ftable and an fft display, as created by ftgen and dispfft
+void PanelBench::createCurves()
+{
+	m_windats.resize(2);
+	m_curveData.resize(2);
+	m_curveData[0].resize(PANELBENCH_TABLESIZE);
+	for (int i = 0; i < PANELBENCH_TABLESIZE; i++) {
+		m_curveData[0][i] = sin(2 * M_PI * i / PANELBENCH_TABLESIZE);
+	}
+	m_curveData[1].resize(PANELBENCH_FFTSIZE);
+	const char *captions[] = {"ftable 1:", "fft 1: asig"};
+	for (int i = 0; i < 2; i++) {
+		WINDAT *windat = &m_windats[i];
+		memset(windat, 0, sizeof(WINDAT));
+		windat->fdata = m_curveData[i].data();
+		windat->npts = m_curveData[i].size();
+		strncpy(windat->caption, captions[i], CAPSIZE - 1);
+		windat->polarity = i == 0 ? BIPOL : POSPOL;
+		windat->max = 1.0;
+		windat->min = i == 0 ? -1.0 : 0.0;
+		windat->absmax = 1.0;
+		windat->oabsmax = 1.0;
+		m_layout->appendCurve(windat);
+	}
+}
+
+void PanelBench::feedValues(int frame)
+{
+	// Control values, at m_valueRate updates per second for every channel
+	int updates = qMax(1, m_valueRate / m_fps);
+	for (int n = 0; n < updates; n++) {
+		double phase = (frame * updates + n) / (double) (m_fps * updates);
+		for (int i = 0; i < m_channels.size(); i++) {
+			m_layout->setValue(m_channels[i], 0.5 + 0.5 * sin(2 * M_PI * (phase + i * 0.01)));
+		}
+	}
+	// Audio for the scopes, one frame worth of k-cycles
+	if (m_scopes > 0) {
+		int blocks = PANELBENCH_SR / PANELBENCH_KSMPS / m_fps;
+		for (int b = 0; b < blocks; b++) {
+			long t = ((long) frame * blocks + b) * PANELBENCH_KSMPS;
+			for (int i = 0; i < PANELBENCH_KSMPS; i++) {
+				for (int c = 0; c < m_ud.numChnls; c++) {
+					m_spout[i * m_ud.numChnls + c] = 0.8 * sin(2 * M_PI * 220.0 * (t + i) / PANELBENCH_SR);
+				}
+			}
+			m_ud.audioOutputBuffer.putManyScaled(m_spout.data(), m_spout.size(), 1.0);
+		}
+	}
+	// A moving peak for the fft display
+	if (m_graphs > 0) {
+		QVector<MYFLT> &fft = m_curveData[1];
+		int peak = frame % fft.size();
+		for (int i = 0; i < fft.size(); i++) {
+			fft[i] = 1.0 / (1.0 + qAbs(i - peak));
+		}
+		m_layout->updateCurve(&m_windats[1]);
+	}
+}
+
+void PanelBench::run()
+{
+	QElapsedTimer timer;
+	m_frameTimes.clear();
+	m_feedTimes.clear();
+	m_framePaints.clear();
+	m_frameAllocations.clear();
+	m_paintsByClass.clear();
+	for (int frame = 0; frame < m_warmup + m_frames; frame++) {
+		bool measure = frame >= m_warmup;
+		timer.start();
+		feedValues(frame);
+		qint64 feedTime = timer.nsecsElapsed();
+
+		m_paintEvents = 0;
+		m_counting = measure;
+		quint64 allocations = allocationCount.load();
+		timer.start();
+		m_layout->updateFrame();
+		// Deliver the layout and update requests, i.e. the actual repaints,
+		// without running timers (the layout's own update timer stays idle)
+		QCoreApplication::sendPostedEvents();
+		qint64 frameTime = timer.nsecsElapsed();
+		allocations = allocationCount.load() - allocations;
+		m_counting = false;
+		if (measure) {
+			m_frameTimes << frameTime;
+			m_feedTimes << feedTime;
+			m_framePaints << m_paintEvents;
+			m_frameAllocations << allocations;
+		}
+	}
+}
+
+bool PanelBench::eventFilter(QObject *object, QEvent *event)
+{
+	if (m_counting && event->type() == QEvent::Paint) {
+		m_paintEvents++;
+		m_paintsByClass[object->metaObject()->className()]++;
+	}
+	return false;
+}
+
+template <typename T>
+static T percentile(QVector<T> sorted, double p)
+{
+	if (sorted.isEmpty()) {
+		return 0;
+	}
+	int index = qBound(0, (int) ceil(p * sorted.size()) - 1, sorted.size() - 1);
+	return sorted[index];
+}
+
+template <typename T>
+static QJsonObject distribution(QVector<T> values, double scale)
+{
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	foreach (T v, values) {
+		sum += v;
+	}
+	QJsonObject o;
+	o["min"] = values.isEmpty() ? 0 : values.first() * scale;
+	o["median"] = percentile(values, 0.5) * scale;
+	o["p95"] = percentile(values, 0.95) * scale;
+	o["p99"] = percentile(values, 0.99) * scale;
+	o["max"] = values.isEmpty() ? 0 : values.last() * scale;
+	o["mean"] = values.isEmpty() ? 0 : sum / values.size() * scale;
+	return o;
+}
+
+static QJsonObject results(const QVector<qint64> &frameTimes, const QVector<qint64> &feedTimes,
+						   const QVector<int> &paints, const QVector<quint64> &allocations)
+{
+	QJsonObject o;
+	o["frame_ms"] = distribution(frameTimes, 1e-6);
+	o["feed_ms"] = distribution(feedTimes, 1e-6);
+	o["paints_per_frame"] = distribution(paints, 1.0);
+	o["allocations_per_frame"] = distribution(allocations, 1.0);
+	return o;
+}
+
+QString PanelBench::report()
+{
+	QJsonObject r = results(m_frameTimes, m_feedTimes, m_framePaints, m_frameAllocations);
+	QString text;
+	QTextStream s(&text);
+	s << "Panel: " << m_fileName << "\n";
+	s << "Widgets: " << m_layout->getWidgets().size() << "  channels: " << m_channels.size()
+	  << "  scopes: " << m_scopes << "  graphs: " << m_graphs << "\n";
+	s << "Frames: " << m_frameTimes.size() << " at " << m_fps << " fps, "
+	  << m_valueRate << " value updates/s per channel\n\n";
+	s << QString("%1 %2 %3 %4 %5 %6 %7\n").arg("", -22).arg("min", 10).arg("median", 10)
+		 .arg("p95", 10).arg("p99", 10).arg("max", 10).arg("mean", 10);
+	QStringList rows;
+	rows << "frame_ms" << "feed_ms" << "paints_per_frame" << "allocations_per_frame";
+	foreach (QString row, rows) {
+		QJsonObject d = r[row].toObject();
+		s << QString("%1 %2 %3 %4 %5 %6 %7\n").arg(row, -22)
+			 .arg(d["min"].toDouble(), 10, 'f', 3).arg(d["median"].toDouble(), 10, 'f', 3)
+			 .arg(d["p95"].toDouble(), 10, 'f', 3).arg(d["p99"].toDouble(), 10, 'f', 3)
+			 .arg(d["max"].toDouble(), 10, 'f', 3).arg(d["mean"].toDouble(), 10, 'f', 3);
+	}
+	s << "\nPaint events by class:\n";
+	QHashIterator<QString, int> it(m_paintsByClass);
+	while (it.hasNext()) {
+		it.next();
+		s << "  " << it.key() << ": " << it.value() << "\n";
+	}
+	return text;
+}
+
+bool PanelBench::writeJson(QString fileName)
+{
+	QJsonObject o = results(m_frameTimes, m_feedTimes, m_framePaints, m_frameAllocations);
+	o["panel"] = m_fileName;
+	o["widgets"] = m_layout->getWidgets().size();
+	o["channels"] = m_channels.size();
+	o["scopes"] = m_scopes;
+	o["graphs"] = m_graphs;
+	o["fps"] = m_fps;
+	o["value_rate"] = m_valueRate;
+	o["frames"] = m_frameTimes.size();
+	QJsonObject byClass;
+	QHashIterator<QString, int> it(m_paintsByClass);
+	while (it.hasNext()) {
+		it.next();
+		byClass[it.key()] = it.value();
+	}
+	o["paints_by_class"] = byClass;
+	QJsonArray frames;
+	for (int i = 0; i < m_frameTimes.size(); i++) {
+		frames.append(m_frameTimes[i] * 1e-6);
+	}
+	o["frame_times_ms"] = frames;
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) {
+		qWarning() << "PanelBench::writeJson can't write" << fileName;
+		return false;
+	}
+	file.write(QJsonDocument(o).toJson());
+	return true;
+}
+
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext &context,
+								const QString &msg)
+{
+	// Keep the report readable: the refresh paths print debug messages
+	Q_UNUSED(context);
+	if (type != QtDebugMsg && type != QtInfoMsg) {
+		fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+	}
+}
+
+int PanelBench::exec(QStringList args)
+{
+	QString fileName, jsonFile;
+	PanelBench bench;
+	for (int i = 1; i < args.size(); i++) {
+		QString arg = args[i];
+		QString next = i + 1 < args.size() ? args[i + 1] : QString();
+		if (arg == "-panel") {
+			fileName = next;
+			i++;
+		}
+		else if (arg == "-fps") {
+			bench.setFrameRate(qMax(1, next.toInt()));
+			i++;
+		}
+		else if (arg == "-rate") {
+			bench.setValueRate(qMax(1, next.toInt()));
+			i++;
+		}
+		else if (arg == "-frames") {
+			bench.setFrames(qMax(1, next.toInt()));
+			i++;
+		}
+		else if (arg == "-json") {
+			jsonFile = next;
+			i++;
+		}
+		else if (arg == "-verbose") {
+			continue;
+		}
+		else {
+			fprintf(stderr, "Unknown option %s\n", arg.toLocal8Bit().constData());
+			fprintf(stderr, "Usage: qcsbench -panel file.csd [-fps 30] [-rate 1000] "
+					"[-frames 600] [-json results.json] [-verbose]\n");
+			return 1;
+		}
+	}
+	if (!args.contains("-verbose")) {
+		qInstallMessageHandler(quietMessageHandler);
+	}
+	if (!bench.loadPanel(fileName)) {
+		return 1;
+	}
+	bench.run();
+	QTextStream(stdout) << bench.report();
+	if (!jsonFile.isEmpty() && !bench.writeJson(jsonFile)) {
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,98 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#ifndef PANELBENCH_H
+#define PANELBENCH_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+#include "csoundengine.h"  // For CsoundUserData
+
+class WidgetLayout;
+class QuteScope;
+class QuteGraph;
+
+//
+// Frame time benchmark for a complete widget panel. The panel of a csd is
+// loaded into a WidgetLayout and every channel is fed synthetic values (as
+// the engine would through WidgetLayout::setValue), scopes get a synthetic
+// audio stream and graphs a moving spectrum. Each frame runs the same
+// refresh as the layout's update timer and then delivers the resulting
+// paint events. Works with QT_QPA_PLATFORM=offscreen.
+//
+class PanelBench : public QObject
+{
+	Q_OBJECT
+public:
+	PanelBench(QObject *parent = 0);
+	~PanelBench();
+
+	bool loadPanel(QString fileName);
+	void setFrameRate(int fps) { m_fps = fps; }
+	void setValueRate(int rate) { m_valueRate = rate; }
+	void setFrames(int frames) { m_frames = frames; }
+	void run();
+	QString report();
+	bool writeJson(QString fileName);
+
+	// Entry point for "qcsbench -panel file.csd [options]"
+	static int exec(QStringList args);
+
+protected:
+	virtual bool eventFilter(QObject *object, QEvent *event);
+
+private slots:
+	void registerScope(QuteScope *scope);
+	void registerGraph(QuteGraph *graph);
+
+private:
+	void feedValues(int frame);
+	void createCurves();
+
+	WidgetLayout *m_layout;
+	CsoundUserData m_ud;
+	QString m_fileName;
+	QStringList m_channels;
+	int m_scopes;
+	int m_graphs;
+	QVector<WINDAT> m_windats;
+	QVector<QVector<MYFLT> > m_curveData;
+	QVector<MYFLT> m_spout;
+
+	int m_fps;
+	int m_valueRate;
+	int m_frames;
+	int m_warmup;
+
+	bool m_counting;
+	int m_paintEvents;
+	QHash<QString, int> m_paintsByClass;
+
+	QVector<qint64> m_frameTimes;  // nanoseconds
+	QVector<qint64> m_feedTimes;   // nanoseconds
+	QVector<int> m_framePaints;
+	QVector<quint64> m_frameAllocations;
+};
+
+#endif // PANELBENCH_H
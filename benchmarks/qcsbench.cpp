@@ -0,0 +1,345 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+// Micro-benchmarks for the paths that run on every k-cycle or every GUI
+// refresh. Run with -o results.xml,xml (or -csv) for machine readable output,
+// or with -panel file.csd for the panel frame time benchmark (panelbench.h),
+// see BUILDING.md.
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QGraphicsScene>
+#include <cmath>
+
+#include "types.h"
+#include "csoundengine.h"
+#include "widgetlayout.h"
+#include "highlighter.h"
+#include "opentryparser.h"
+#include "qutescope.h"
+#include "console.h"
+#include "panelbench.h"
+
+// Builds a <bsbPanel> with count sliders on channels chan0...chanN
+static QString makePanelXml(int count)
+{
+	QString xml;
+	QXmlStreamWriter s(&xml);
+	s.writeStartElement("bsbPanel");
+	for (int i = 0; i < count; i++) {
+		s.writeStartElement("bsbObject");
+		s.writeAttribute("type", "BSBVSlider");
+		s.writeAttribute("version", QCS_CURRENT_XML_VERSION);
+		s.writeTextElement("objectName", QString("chan%1").arg(i));
+		s.writeTextElement("x", QString::number((i % 50) * 22));
+		s.writeTextElement("y", QString::number((i / 50) * 104));
+		s.writeTextElement("width", "20");
+		s.writeTextElement("height", "100");
+		s.writeTextElement("uuid", QUuid::createUuid().toString());
+		s.writeTextElement("visible", "true");
+		s.writeTextElement("midichan", QString::number(i % 16 + 1));
+		s.writeTextElement("midicc", QString::number(i % 128));
+		s.writeTextElement("minimum", "0.00000000");
+		s.writeTextElement("maximum", "1.00000000");
+		s.writeTextElement("value", "0.00000000");
+		s.writeTextElement("mode", "lin");
+		s.writeStartElement("mouseControl");
+		s.writeAttribute("act", "jump");
+		s.writeCharacters("continuous");
+		s.writeEndElement();
+		s.writeTextElement("resolution", "-1.00000000");
+		s.writeStartElement("randomizable");
+		s.writeAttribute("group", "0");
+		s.writeCharacters("false");
+		s.writeEndElement();
+		s.writeEndElement();
+	}
+	s.writeEndElement();
+	return xml;
+}
+
+// A csd with lines orchestra lines, using the usual mix of opcodes,
+// variables, comments and strings
+static QString makeCsd(int lines)
+{
+	QStringList body;
+	body << "<CsoundSynthesizer>" << "<CsOptions>" << "-odac" << "</CsOptions>"
+		 << "<CsInstruments>" << "sr = 44100" << "ksmps = 64" << "nchnls = 2"
+		 << "0dbfs = 1";
+	int instr = 1;
+	while (body.size() < lines - 6) {
+		body << QString("instr %1 ; generated").arg(instr++);
+		body << "kfreq chnget \"freq\"";
+		body << "aenv linsegr 0, 0.01, 1, 0.2, 0  /* envelope */";
+		body << "asig vco2 0.5*aenv, kfreq, 2, 0.5";
+		body << "afilt moogladder asig, kfreq*4, 0.3";
+		body << "gaRev = gaRev + afilt*0.2";
+		body << "outs afilt, afilt";
+		body << "endin";
+	}
+	body << "</CsInstruments>" << "<CsScore>" << "i 1 0 3600" << "</CsScore>"
+		 << "</CsoundSynthesizer>";
+	return body.join("\n");
+}
+
+class QcsBench : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+
+	void ringBufferPut_data();
+	void ringBufferPut();
+	void ringBufferCopy();
+
+	void channelLookup_data();
+	void channelLookup();
+	void channelSet_data();
+	void channelSet();
+
+	void highlighter_data();
+	void highlighter();
+
+	void opcodeLookup();
+
+	void scopeUpdate_data();
+	void scopeUpdate();
+
+	void consoleAppend_data();
+	void consoleAppend();
+
+private:
+	OpEntryParser *m_opcodeTree;
+};
+
+void QcsBench::initTestCase()
+{
+	m_opcodeTree = new OpEntryParser(":/opcodes.xml");
+}
+
+void QcsBench::cleanupTestCase()
+{
+	delete m_opcodeTree;
+}
+
+void QcsBench::ringBufferPut_data()
+{
+	QTest::addColumn<int>("ksmps");
+	QTest::addColumn<int>("nchnls");
+	QTest::newRow("ksmps=16 stereo") << 16 << 2;
+	QTest::newRow("ksmps=64 stereo") << 64 << 2;
+	QTest::newRow("ksmps=256 8ch") << 256 << 8;
+}
+
+void QcsBench::ringBufferPut()
+{
+	QFETCH(int, ksmps);
+	QFETCH(int, nchnls);
+	RingBuffer buffer;
+	QVector<MYFLT> spout(ksmps * nchnls, 0.5);
+	QBENCHMARK {
+		buffer.putManyScaled(spout.data(), spout.size(), 1.0);
+	}
+}
+
+void QcsBench::ringBufferCopy()
+{
+	RingBuffer buffer;
+	QVector<MYFLT> spout(128, 0.5);
+	QVector<MYFLT> out(128);
+	QBENCHMARK {
+		buffer.putManyScaled(spout.data(), spout.size(), 1.0);
+		buffer.putManyScaled(spout.data(), spout.size(), 1.0);
+		buffer.copyAvailableBuffer(out.data(), out.size());
+	}
+}
+
+void QcsBench::channelLookup_data()
+{
+	QTest::addColumn<int>("widgets");
+	QTest::newRow("100 widgets") << 100;
+	QTest::newRow("1000 widgets") << 1000;
+}
+
+// This is what the engine does for every input channel on every k-cycle
+void QcsBench::channelLookup()
+{
+	QFETCH(int, widgets);
+	WidgetLayout layout(0);
+	layout.setOpenProperties(false);
+	layout.loadXmlWidgets(makePanelXml(widgets));
+	QStringList channels;
+	for (int i = 0; i < widgets; i++) {
+		channels << QString("chan%1").arg(i);
+	}
+	double sum = 0;
+	QBENCHMARK {
+		foreach (QString channel, channels) {
+			sum += layout.getValueForChannel(channel);
+		}
+	}
+	QCOMPARE(sum, 0.0);
+}
+
+void QcsBench::channelSet_data()
+{
+	channelLookup_data();
+}
+
+void QcsBench::channelSet()
+{
+	QFETCH(int, widgets);
+	WidgetLayout layout(0);
+	layout.setOpenProperties(false);
+	layout.loadXmlWidgets(makePanelXml(widgets));
+	QStringList channels;
+	for (int i = 0; i < widgets; i++) {
+		channels << QString("chan%1").arg(i);
+	}
+	double value = 0;
+	QBENCHMARK {
+		value = value > 0.5 ? 0 : value + 0.01;
+		foreach (QString channel, channels) {
+			layout.setValue(channel, value);
+		}
+	}
+}
+
+void QcsBench::highlighter_data()
+{
+	QTest::addColumn<int>("lines");
+	QTest::newRow("10k lines") << 10000;
+	QTest::newRow("100k lines") << 100000;
+}
+
+void QcsBench::highlighter()
+{
+	QFETCH(int, lines);
+	QTextDocument doc;
+	doc.setPlainText(makeCsd(lines));
+	Highlighter highlighter(&doc);
+	highlighter.setOpcodeNameList(m_opcodeTree->opcodeNameList());
+	highlighter.setColorVariables(true);
+	QBENCHMARK {
+		highlighter.rehighlight();
+	}
+}
+
+void QcsBench::opcodeLookup()
+{
+	QStringList words;
+	words << "oscili" << "vco2" << "moogladder" << "chnget" << "outs" << "kfreq"
+		  << "aenv" << "linsegr" << "foo" << "gaRev" << "pvsanal" << "reverbsc";
+	int found = 0;
+	QBENCHMARK {
+		foreach (QString word, words) {
+			if (m_opcodeTree->isOpcode(word)) {
+				found++;
+				m_opcodeTree->getSyntax(word);
+			}
+			m_opcodeTree->getPossibleSyntax(word);
+		}
+	}
+	QVERIFY(found > 0);
+}
+
+void QcsBench::scopeUpdate_data()
+{
+	QTest::addColumn<int>("channel");
+	QTest::addColumn<double>("zoomx");
+	QTest::addColumn<int>("trigger");
+	QTest::newRow("ch1 zoom1") << 1 << 1.0 << (int) ScopeTrigger::Free;
+	QTest::newRow("ch1 zoom4") << 1 << 4.0 << (int) ScopeTrigger::Free;
+	QTest::newRow("ch1 zoom16") << 1 << 16.0 << (int) ScopeTrigger::Free;
+	QTest::newRow("all zoom1") << -1 << 1.0 << (int) ScopeTrigger::Free;
+	QTest::newRow("ch1 zoom1 triggered") << 1 << 1.0 << (int) ScopeTrigger::Normal;
+}
+
+void QcsBench::scopeUpdate()
+{
+	QFETCH(int, channel);
+	QFETCH(double, zoomx);
+	QFETCH(int, trigger);
+	// No engine: the benchmark feeds the buffer itself, as csThread would
+	CsoundUserData ud;
+	ud.csEngine = 0;
+	ud.numChnls = 2;
+	ud.sampleRate = 44100;
+	ud.outputBufferSize = 64;
+	QGraphicsScene scene;
+	ScopeWidget view(0);
+	view.setScene(&scene);
+	QReadWriteLock lock;
+	ScopeParams params(&ud, &scene, &view, &lock, 400, 200);
+	ScopeData scope(&params);
+	scope.setTrigger(trigger, ScopeTrigger::Rising, 0.0, 0.01, 0.0, 0.1, true);
+	scope.show();
+	QVector<MYFLT> spout(ud.outputBufferSize * ud.numChnls);
+	for (int i = 0; i < spout.size(); i++) {
+		spout[i] = sin(i * 0.1);
+	}
+	// One GUI frame worth of audio at 30 fps and 44.1 kHz
+	int blocks = 44100 / 30 / ud.outputBufferSize;
+	QBENCHMARK {
+		for (int i = 0; i < blocks; i++) {
+			ud.audioOutputBuffer.putManyScaled(spout.data(), spout.size(), 1.0);
+		}
+		scope.updateData(channel, zoomx, 1.0, false);
+	}
+}
+
+void QcsBench::consoleAppend_data()
+{
+	QTest::addColumn<int>("messages");
+	QTest::newRow("1k messages") << 1000;
+	QTest::newRow("10k messages") << 10000;
+}
+
+void QcsBench::consoleAppend()
+{
+	QFETCH(int, messages);
+	Console console(0);
+	QStringList lines;
+	for (int i = 0; i < messages; i++) {
+		lines << QString("B %1.000 .. %2.000 T %2.000 TT %2.000 M:  0.50000  0.50000\n")
+				 .arg(i).arg(i + 1);
+	}
+	QBENCHMARK {
+		console.reset();
+		foreach (QString line, lines) {
+			console.appendMessage(line);
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	QApplication app(argc, argv);
+	if (app.arguments().contains("-panel")) {
+		return PanelBench::exec(app.arguments());
+	}
+	QcsBench bench;
+	return QTest::qExec(&bench, argc, argv);
+}
+
+#include "qcsbench.moc"
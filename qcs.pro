@@ -17,7 +17,6 @@
 # CONFIG+=build32    To build floats version
 # CONFIG+=pythonqt   To build with PythonQt support
 # CONFIG+=rtmidi     To build with RtMidi support
-# CONFIG+=record_support
 # CONFIG+=debugger
 # To support HTML5 via the <html> element in the csd using the Qt WebEngine
 # (preferably use Qt 5.8 or later):
@@ -108,10 +107,8 @@ win32-msvc2013:include (qcs-win32.pro)
 win32-msvc2015:include (qcs-win32.pro)
 win32-msvc2017:include (qcs-win32.pro)
 
-# Requires Csound >= 6.04
 record_support|perfThread_build {
-    DEFINES += PERFTHREAD_RECORD
-    message("Building recording support.")
+    message("No need to specify CONFIG+=record_support anymore as recording is always built.")
 }
 
 !csound5 {
@@ -13,6 +13,7 @@ Rectangle {
     property bool checked: false
     property bool enabled: true
     property bool blackKey: false
+    property int velocity: -1 // -1 for the keyboard's velocity
     property int numkeys: root.numOctaves * 7 + 1
 
     function mouseOn() {
@@ -36,6 +37,7 @@ Rectangle {
         enabled: key.enabled
         onPressed: {
             root.mouseHeld = true
+            key.velocity = -1
             mouseOn()
         }
         onReleased: {
@@ -47,6 +49,7 @@ Rectangle {
         onEntered: {
 //            console.log("Entered")
             if (root.mouseHeld) {
+                key.velocity = -1
                 mouseOn()
             }
         }
@@ -56,10 +59,27 @@ Rectangle {
             }
         }
     }
+    // Touch screens, where the velocity can come from the pressure
+    MultiPointTouchArea {
+        anchors.fill: parent
+        enabled: key.enabled
+        mouseEnabled: false
+        maximumTouchPoints: 1
+        onPressed: {
+            key.velocity = root.pressureVelocity(touchPoints[0].pressure)
+            mouseOn()
+        }
+        onReleased: {
+            if (key.checked) {
+                mouseOff()
+            }
+        }
+    }
+
     onCheckedChanged: {
         var notenum = blackKey ? index + 0.5:index
         if (checked) {
-            root.turnon(notenum)
+            root.turnon(notenum, velocity)
         } else {
             root.turnoff(notenum)
         }
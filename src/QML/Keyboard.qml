@@ -6,9 +6,9 @@ Rectangle {
     property int numOctaves: 2
     property bool latch: false
 
-    signal turnon(real notenum);
+    signal turnon(real notenum, int velocity);
     signal turnoff(real notenum);
-    signal genNote(variant on, variant note);
+    signal genNote(variant on, variant note, variant velocity);
     property bool mouseHeld: false
 
     function indextomidi(notenum) {
@@ -18,14 +18,22 @@ Rectangle {
         return octave*12 + note
     }
 
+    // Devices without pressure report 0 or 1, those use the keyboard's velocity
+    function pressureVelocity(pressure) {
+        if (pressure <= 0 || pressure >= 1) {
+            return -1
+        }
+        return Math.max(1, Math.round(pressure * 127))
+    }
+
     onTurnon: {
         var midinum = indextomidi(notenum)
-        genNote(1, midinum)
+        genNote(1, midinum, velocity)
         //console.log("TURNON: ", notenum);
     }
     onTurnoff: {
         var midinum = indextomidi(notenum)
-        genNote(0, midinum)
+        genNote(0, midinum, -1)
     }
 
     // Set keyboard mapping to play from computer Keyboard
@@ -38,9 +46,11 @@ Rectangle {
         var whiteIndex = whiteKeys.indexOf(key); // -1 if not found;
         var blackIndex = blackKeys.indexOf(key);
         if (whiteIndex>=0) {
+            keyDrawer.itemAt(whiteIndex).velocity = -1;
             keyDrawer.itemAt(whiteIndex).checked =  pressed;
         }
         if (blackIndex>=0) {
+            blackkeyDrawer.itemAt(blackIndex).velocity = -1;
             blackkeyDrawer.itemAt(blackIndex).checked =  pressed;
         }
     }
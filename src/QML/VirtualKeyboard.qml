@@ -10,9 +10,6 @@ ColumnLayout {
     property int channel: controls.channel
     property int velocity: controls.velocity
 
-    signal genNote(variant on, variant note, variant channel, variant velocity);
-    signal newCCvalue(int channel, int cc, int value)
-
     Row {
         spacing: 5
         Repeater {
@@ -23,7 +20,7 @@ ColumnLayout {
                 ccNumber: index+1
                 onCcValueChanged: {
                     //console.log("CC:", channel, ccNumber, value)
-                    newCCvalue(channel, ccNumber, value )
+                    virtualMidi.controlChange(channel, ccNumber, value)
                 }
                 Keys.forwardTo: keyboard
             }
@@ -43,7 +40,25 @@ ColumnLayout {
         numOctaves: controls.numOctaves
         id: keyboard
         onGenNote: {
-            layout.genNote(on, note + (12*layout.octave), layout.channel, layout.velocity)
+            // Sent directly to the engine (see VirtualMidiInput)
+            if (on) {
+                virtualMidi.noteOn(layout.channel, note + (12*layout.octave),
+                                   velocity > 0 ? velocity : layout.velocity)
+            } else {
+                virtualMidi.noteOff(layout.channel, note + (12*layout.octave))
+            }
         }
     }
+
+    Text {
+        id: latencyText
+        text: virtualMidi.latencyText()
+    }
+
+    Timer {
+        interval: 250
+        running: layout.visible
+        repeat: true
+        onTriggered: latencyText.text = virtualMidi.latencyText()
+    }
 }
@@ -25,6 +25,7 @@
 #include "widgetlayout.h"
 #include "documentview.h"
 #include "csoundengine.h"
+#include "diskrecorder.h"
 #include "qutecsound.h"
 #include "qutebutton.h"
 #include "console.h"
@@ -272,16 +273,9 @@ void BaseDocument::stop()
     QDEBUG << "Stopped OK";
 }
 
-int BaseDocument::record(int format)
+int BaseDocument::record(int format, int fileType)
 {
-#ifdef PERFTHREAD_RECORD
-	return m_csEngine->startRecording(format, "output.wav");
-#else
-    (void) format;
-    QMessageBox::warning(NULL, tr("Recording not possible"),
-                         tr("This version of CsoundQt was not built with recording support."));
-	return 0;
-#endif
+	return m_csEngine->startRecording(format, "output" + DiskRecorder::extension(fileType));
 }
 
 void BaseDocument::stopRecording()
@@ -70,7 +70,7 @@ public slots:
 	virtual int play(CsoundOptions *options);
 	void pause();
 	void stop();
-	int record(int mode); // 0=16 bit int  1=32 bit int  2=float
+	int record(int format, int fileType); // See DiskRecorder::SampleFormat and FileType
 	void stopRecording();
 	//    void playParent(); // Triggered from button, ask parent for options
 	//    void renderParent();
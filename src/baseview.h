@@ -116,6 +116,7 @@ public:
 	AppProperties getAppProperties();
 
 	void clearUndoRedoStack();
+	qint64 highlighterMemoryUsage() { return m_highlighter.memoryUsage(); }
 
 	QString getBasicText();  // What Csound needs (no widgets, misc text, etc.)
 
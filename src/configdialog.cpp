@@ -271,6 +271,8 @@ ConfigDialog::ConfigDialog(CsoundQt *parent, Options *options, ConfigLists *conf
 	simultaneousCheckBox->setChecked(m_options->simultaneousRun);
 
 	sampleFormatComboBox->setCurrentIndex(m_options->sampleFormat);
+	recordFileTypeComboBox->setCurrentIndex(m_options->recordFileType);
+	recordPrerollSpinBox->setValue(m_options->recordPreroll);
 	debugPortSpinBox->setValue(m_options->debugPort);
 
 	CsdocdirLineEdit->setText(m_options->csdocdir);
@@ -498,6 +500,8 @@ void ConfigDialog::accept()
 	m_options->simultaneousRun = simultaneousCheckBox->isChecked();
 
 	m_options->sampleFormat = sampleFormatComboBox->currentIndex();
+	m_options->recordFileType = recordFileTypeComboBox->currentIndex();
+	m_options->recordPreroll = recordPrerollSpinBox->value();
 
 	m_options->csdocdir = CsdocdirLineEdit->text();
 	m_options->opcodedirActive = OpcodedirCheckBox->isChecked();
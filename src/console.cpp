@@ -136,6 +136,16 @@ void Console::reset()
 	error = false;
 }
 
+qint64 Console::memoryUsage()
+{
+	qint64 bytes = document()->characterCount() * sizeof(QChar);
+	bytes += messageLine.capacity() * sizeof(QChar);
+	foreach (const QString &text, errorTexts) {
+		bytes += text.capacity() * sizeof(QChar);
+	}
+	return bytes;
+}
+
 void Console::scrollToEnd()
 {
 	moveCursor(QTextCursor::End);
@@ -38,6 +38,7 @@ public:
 	virtual void setColors(QColor textColor, QColor bgColor);
 	void scrollToEnd();
 	void setKeyRepeatMode(bool repeat);
+	qint64 memoryUsage(); // Approximate bytes held by the console text
 	//     void refresh();
 
 	QList<int> errorLines;
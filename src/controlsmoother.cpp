@@ -0,0 +1,136 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "controlsmoother.h"
+
+#include <cmath>
+
+QString ControlSmoother::modeName(int mode)
+{
+	switch (mode) {
+	case Linear:
+		return "linear";
+	case OnePole:
+		return "onepole";
+	default:
+		return "none";
+	}
+}
+
+int ControlSmoother::modeFromName(QString name)
+{
+	if (name == "linear") {
+		return Linear;
+	}
+	else if (name == "onepole") {
+		return OnePole;
+	}
+	return None;
+}
+
+void ControlSmoother::clear()
+{
+	m_channels.clear();
+	m_index.clear();
+	m_active.clear();
+}
+
+void ControlSmoother::addChannel(QString channel, MYFLT *value, int mode, double timeMs,
+								 MYFLT initialValue)
+{
+	if (mode == None || channel.isEmpty() || m_index.contains(channel)) {
+		return;
+	}
+	Channel c;
+	c.value = value;
+	c.mode = mode;
+	double cycles = timeMs * 0.001 * m_controlRate;
+	c.steps = qMax(1, (int) (cycles + 0.5));
+	// Reaches about 63% of the way to the target after timeMs
+	c.coefficient = cycles > 0 ? (MYFLT) std::exp(-1.0 / cycles) : 0;
+	c.current = c.target = initialValue;
+	c.increment = 0;
+	c.remaining = 0;
+	c.active = false;
+	*value = initialValue;
+	m_index.insert(channel, m_channels.size());
+	m_channels.append(c);
+	m_active.reserve(m_channels.size()); // So process() never allocates
+}
+
+bool ControlSmoother::setTarget(const QString &channel, MYFLT target)
+{
+	QHash<QString, int>::const_iterator it = m_index.constFind(channel);
+	if (it == m_index.constEnd()) {
+		return false;
+	}
+	Channel &c = m_channels[it.value()];
+	c.target = target;
+	c.remaining = c.steps;
+	c.increment = (target - c.current) / c.steps;
+	if (!c.active) {
+		c.active = true;
+		m_active.append(it.value());
+	}
+	return true;
+}
+
+bool ControlSmoother::currentValue(const QString &channel, MYFLT *value)
+{
+	QHash<QString, int>::const_iterator it = m_index.constFind(channel);
+	if (it == m_index.constEnd()) {
+		return false;
+	}
+	*value = m_channels[it.value()].current;
+	return true;
+}
+
+void ControlSmoother::process()
+{
+	int i = 0;
+	while (i < m_active.size()) {
+		Channel &c = m_channels[m_active[i]];
+		bool done;
+		if (c.mode == Linear) {
+			c.remaining--;
+			done = c.remaining <= 0;
+			c.current = done ? c.target : c.current + c.increment;
+		}
+		else {
+			c.current = c.target + (c.current - c.target) * c.coefficient;
+			// Stop once the remaining distance can't be heard
+			done = std::fabs(c.current - c.target) <= 1e-6 * qMax((MYFLT) 1, (MYFLT) std::fabs(c.target));
+			if (done) {
+				c.current = c.target;
+			}
+		}
+		*c.value = c.current;
+		if (done) {
+			c.active = false;
+			m_active[i] = m_active.last();
+			m_active.removeLast();
+		}
+		else {
+			i++;
+		}
+	}
+}
@@ -0,0 +1,87 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef CONTROLSMOOTHER_H
+#define CONTROLSMOOTHER_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+
+#include "types.h"
+
+//
+// Smooths widget values on their way to Csound input channels, so that
+// instruments don't need port or tonek to avoid zipper noise. The policy is
+// set per widget and the channels are set up before the performance starts.
+// While running, new values only set a target (setTarget()), and process()
+// moves each channel toward its target once per k-cycle. Step sizes depend
+// on the control rate, not on how often the widget values are read.
+//
+class ControlSmoother
+{
+public:
+	enum Mode {  // Stored with the widgets, don't change the values
+		None = 0,
+		Linear = 1,  // Ramp reaching the target after time
+		OnePole = 2  // Exponential approach, time is the time constant
+	};
+
+	ControlSmoother() : m_controlRate(0) {}
+
+	static QString modeName(int mode);
+	static int modeFromName(QString name);
+
+	// Called while Csound is stopped
+	void clear();
+	void setControlRate(double controlRate) { m_controlRate = controlRate; }
+	// value is the channel pointer, which is set to initialValue. The first
+	// policy set for a channel is kept
+	void addChannel(QString channel, MYFLT *value, int mode, double timeMs,
+					MYFLT initialValue);
+	bool isEmpty() { return m_channels.isEmpty(); }
+
+	// Called from the performance thread
+	bool setTarget(const QString &channel, MYFLT target); // False if channel isn't smoothed
+	bool currentValue(const QString &channel, MYFLT *value);
+	void process();
+
+private:
+	struct Channel {
+		MYFLT *value;
+		int mode;
+		int steps;    // k-cycles for a linear ramp
+		MYFLT coefficient; // For one pole
+		MYFLT current;
+		MYFLT target;
+		MYFLT increment;
+		int remaining;
+		bool active;
+	};
+
+	QVector<Channel> m_channels;
+	QHash<QString, int> m_index;
+	QVector<int> m_active; // Channels moving toward their target
+	double m_controlRate;
+};
+
+#endif // CONTROLSMOOTHER_H
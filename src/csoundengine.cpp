@@ -40,22 +40,40 @@
 #include "qutescope.h"  // Needed for passing the ud to the scope for display data
 #include "qutegraph.h"  // Needed for passing the ud to the graph for display data
 #include "midihandler.h"
+#include "tracer.h"
+#include "diskrecorder.h"
 
 #define QDEBUG qDebug() << __FUNCTION__ << ":"
 
 CsoundEngine::CsoundEngine(ConfigLists *configlists) :
-    m_options(configlists)
+    m_options(configlists),
+    m_midiOutQueue(QCS_MIDI_SMALL_LONG_DATA_SIZE),
+    m_virtualMidiQueue(QCS_MIDI_SMALL_LONG_DATA_SIZE)
 {
     QMutexLocker locker(&m_playMutex);
     ud = new CsoundUserData();
     ud->csEngine = this;
     ud->csound = nullptr;
     ud->perfThread = nullptr;
+    ud->recorder = nullptr;
     ud->flags = QCS_NO_FLAGS;
-    ud->mouseValues.resize(6); // For _MouseX _MouseY _MouseRelX _MouseRelY _MouseBut1 and _MouseBut2 channels
+    ud->hostInput = &m_hostInput;
+    ud->controlSmoother = &m_controlSmoother;
+    m_lastKeyPressed = -1;
     ud->wl = nullptr;
-    ud->midiBuffer = nullptr;
-    ud->virtualMidiBuffer = nullptr;
+    ud->midiHandler = nullptr;
+    ud->midiQueue = &m_midiQueue;
+    ud->midiOutQueue = &m_midiOutQueue;
+    m_scriptMidiReader = m_midiQueue.reader();
+    ud->midiTimeOrigin = -1;
+    ud->midiOutDropped = 0;
+    ud->midiLatency = 0;
+    ud->virtualMidiQueue = &m_virtualMidiQueue;
+    ud->virtualMidiLatency = 0;
+    ud->virtualMidiOutputLatency = 0;
+    ud->midiFilePlayer = &m_midiFilePlayer;
+    ud->midiClockSender = nullptr;
+    ud->tableChanges = &m_tableChanges;
     ud->playMutex = &m_playMutex;
 #ifdef QCS_PYTHONQT
     ud->m_pythonCallback = "";
@@ -64,10 +82,6 @@ CsoundEngine::CsoundEngine(ConfigLists *configlists) :
     m_recording = false;
 #ifndef QCS_DESTROY_CSOUND
     ud->csound=csoundCreate( (void *) ud);
-#ifdef CSOUND6
-    ud->midiBuffer = csoundCreateCircularBuffer(ud->csound, 1024, sizeof(unsigned char));
-    Q_ASSERT(ud->midiBuffer);
-#endif
 #endif
     eventQueue.resize(QCS_MAX_EVENTS);
     eventTimeStamps.resize(QCS_MAX_EVENTS);
@@ -88,8 +102,11 @@ CsoundEngine::~CsoundEngine()
     ud->runDispatcher = false;
     m_msgUpdateThread.waitForFinished(); // Join the message thread
     stop();
+    setMidiHandler(nullptr);
+    if (ud->wl != nullptr) {
+        ud->wl->stopAnalysis(); // Analysis threads must not outlive ud
+    }
 #ifndef QCS_DESTROY_CSOUND
-    csoundDestroyCircularBuffer(ud->csound, ud->midiBuffer);
     csoundDestroy(ud->csound);
 #endif
     delete ud;
@@ -153,31 +170,47 @@ void CsoundEngine::inputValueCallback(CSOUND *csound,
         strncpy(string, newValue.toLocal8Bit(), maxlen);
     }
     else {  // Not a string channel
-        //FIXME check if mouse tracking is active, and move this from here
         if (name == "_MouseX") {
-            *value = (MYFLT) ud->mouseValues[0];
+            *value = (MYFLT) ud->hostInput->x();
         }
         else if (name == "_MouseY") {
-            *value = (MYFLT) ud->mouseValues[1];
+            *value = (MYFLT) ud->hostInput->y();
         }
         else if(name == "_MouseRelX") {
-            *value = (MYFLT) ud->mouseValues[2];
+            *value = (MYFLT) ud->hostInput->relX();
         }
         else if(name == "_MouseRelY") {
-            *value = (MYFLT) ud->mouseValues[3];
+            *value = (MYFLT) ud->hostInput->relY();
         }
         else if(name == "_MouseBut1") {
-            *value = (MYFLT) ud->mouseValues[4];
+            *value = ud->hostInput->button(HostInput::LeftButton) ? 1 : 0;
         }
         else if(name == "_MouseBut2") {
-            *value = (MYFLT) ud->mouseValues[5];
+            *value = ud->hostInput->button(HostInput::RightButton) ? 1 : 0;
         }
-        else {
+        else if (!ud->controlSmoother->currentValue(name, value)) {
             *value = (MYFLT) ud->wl->getValueForChannel(name);
         }
     }
 }
 #else
+// Nominal time of the current k-cycle in MidiQueue::now() time, counted in
+// samples from the start of the performance. Audio is computed in bursts up
+// to an output buffer (midiLatency) ahead, the origin follows the wall clock
+// when the audio runs later or earlier than that (start up, xruns, drift).
+// Only called from the performance thread.
+static qint64 kcycleTime(CSOUND *csound, CsoundUserData *ud)
+{
+    qint64 now = MidiQueue::now();
+    qint64 elapsed = (qint64) (csoundGetCurrentTimeSamples(csound) * 1e9 / ud->sampleRate);
+    qint64 time = ud->midiTimeOrigin + elapsed;
+    if (ud->midiTimeOrigin < 0 || time > now + ud->midiLatency || time < now - ud->midiLatency) {
+        ud->midiTimeOrigin = now - elapsed;
+        time = now;
+    }
+    return time;
+}
+
 void CsoundEngine::outputValueCallback (CSOUND *csound,
                                         const char *channelName,
                                         void *channelValuePtr,
@@ -185,6 +218,7 @@ void CsoundEngine::outputValueCallback (CSOUND *csound,
 {
     // Called by the csound running engine when 'outvalue' opcode is used
     // To pass data from Csound to CsoundQt
+    QCS_TRACE_SCOPE("outputValueCallback");
     CsoundUserData *ud = (CsoundUserData *) csoundGetHostData(csound);
     if (channelType == &CS_VAR_TYPE_S) {
         ud->csEngine->passOutString(channelName, (const char *) channelValuePtr);
@@ -203,6 +237,7 @@ void CsoundEngine::inputValueCallback (CSOUND *csound,
 {
     // Called by the csound running engine when 'invalue' opcode is used
     // To pass data from CsoundQt to Csound
+    QCS_TRACE_SCOPE("inputValueCallback");
     CsoundUserData *ud = (CsoundUserData *) csoundGetHostData(csound);
     if (channelType == &CS_VAR_TYPE_S) { // channel is a string channel
         char *string = (char *) channelValuePtr;
@@ -216,32 +251,75 @@ void CsoundEngine::inputValueCallback (CSOUND *csound,
         }
     }
     else if (channelType == &CS_VAR_TYPE_K) {  // Not a string channel
-        //FIXME check if mouse tracking is active, and move this from here
+        // Host input is read from the GUI's last state, without locking
         MYFLT *value = (MYFLT *) channelValuePtr;
-        if(!strcmp(channelName, "_Mouse")) {
+        HostInput *input = ud->hostInput;
+        if (!strncmp(channelName, "_Mouse", 6)) {
             const char *suffix = &channelName[6];
             if (!strcmp(suffix, "X")) {
-                *value = (MYFLT) ud->mouseValues[0];
+                *value = (MYFLT) input->x();
             }
             else if (!strcmp(suffix, "Y")) {
-                *value = (MYFLT) ud->mouseValues[1];
+                *value = (MYFLT) input->y();
             }
             else if(!strcmp(suffix, "RelX")) {
-                *value = (MYFLT) ud->mouseValues[2];
+                *value = (MYFLT) input->relX();
             }
             else if(!strcmp(suffix, "RelY")) {
-                *value = (MYFLT) ud->mouseValues[3];
+                *value = (MYFLT) input->relY();
             }
             else if(!strcmp(suffix, "But1")) {
-                *value = (MYFLT) ud->mouseValues[4];
+                *value = input->button(HostInput::LeftButton) ? 1 : 0;
             }
             else if(!strcmp(suffix, "But2")) {
-                *value = (MYFLT) ud->mouseValues[5];
+                *value = input->button(HostInput::RightButton) ? 1 : 0;
+            }
+            else {
+                *value = (MYFLT) ud->wl->getValueForChannel(channelName);
+            }
+        }
+        else if (!strncmp(channelName, "_Key", 4)) {
+            const char *suffix = &channelName[4];
+            if (!strcmp(suffix, "Last")) {
+                *value = (MYFLT) input->lastKey();
+            }
+            else if (!strcmp(suffix, "Down")) {
+                *value = input->keyDown() ? 1 : 0;
+            }
+            else if (!strcmp(suffix, "Modifiers")) {
+                *value = (MYFLT) input->modifiers();
+            }
+            else {
+                *value = (MYFLT) ud->wl->getValueForChannel(channelName);
+            }
+        }
+        else if (!strncmp(channelName, "_MidiClock", 10)) {
+            // Received clock at the time this k-cycle is heard
+            MidiClock *clock = MidiClock::instance();
+            const char *suffix = &channelName[10];
+            qint64 time = kcycleTime(csound, ud) + ud->midiLatency;
+            if (!strcmp(suffix, "Tempo")) {
+                *value = (MYFLT) clock->tempo(time);
+            }
+            else if (!strcmp(suffix, "Beat")) {
+                *value = (MYFLT) clock->beat(time);
+            }
+            else if (!strcmp(suffix, "Running")) {
+                *value = clock->isRunning(time) ? 1 : 0;
+            }
+            else if (!strcmp(suffix, "Locked")) {
+                *value = clock->isLocked(time) ? 1 : 0;
+            }
+            else {
+                *value = (MYFLT) ud->wl->getValueForChannel(channelName);
             }
         }
         else {
-            // QString name(channelName);
-            *value = (MYFLT) ud->wl->getValueForChannel(channelName);
+            // Smoothed widgets pass their current value, not the widget's
+            if (ud->controlSmoother->isEmpty()
+                    || !ud->controlSmoother->currentValue(QString(channelName), value)) {
+                *value = (MYFLT) ud->wl->getValueForChannel(channelName);
+            }
         }
     } else {
         QDEBUG << "Unsupported type";
@@ -252,7 +330,6 @@ int CsoundEngine::midiInOpenCb(CSOUND *csound, void **ud, const char *devName)
 {
     CsoundUserData *userData = (CsoundUserData *) csoundGetHostData(csound);
     Q_UNUSED(devName);
-    Q_ASSERT(userData->midiBuffer);
     if (userData) {
         *ud = userData;
     } else {
@@ -264,12 +341,52 @@ int CsoundEngine::midiInOpenCb(CSOUND *csound, void **ud, const char *devName)
 
 int CsoundEngine::midiReadCb(CSOUND *csound, void *ud_, unsigned char *buf, int nBytes)
 {
+    QCS_TRACE_SCOPE("midiReadCb");
     CsoundUserData *ud = (CsoundUserData *) ud_;
-    Q_UNUSED(csound);
-    int count, countVirtual;
-    count = csoundReadCircularBuffer(ud->csound, ud->midiBuffer, buf, nBytes);
-    countVirtual = csoundReadCircularBuffer(ud->csound, ud->virtualMidiBuffer, buf + count, nBytes - count);
-    return count + countVirtual;
+    // Events are passed when this k-cycle is midiLatency past their arrival,
+    // so they keep their spacing instead of bunching up at the start of each
+    // audio buffer
+    qint64 time = kcycleTime(csound, ud);
+    qint64 deadline = time - ud->midiLatency;
+    int count = 0;
+    MidiEvent event;
+    while (ud->midiQueue->peek(ud->midiReader, event) && event.time <= deadline) {
+        if (event.size > nBytes) { // Can never fit in Csound's buffer
+            ud->midiQueue->next(ud->midiReader);
+            continue;
+        }
+        if (event.size > nBytes - count) {
+            break; // Next k-cycle
+        }
+        if (ud->midiQueue->copyData(event, buf + count)) {
+            count += event.size;
+        }
+        ud->midiQueue->next(ud->midiReader);
+    }
+    // Virtual input is played live, so it is passed at once
+    qint64 now = -1;
+    while (ud->virtualMidiQueue->peek(ud->virtualMidiReader, event)) {
+        if (event.size > nBytes) {
+            ud->virtualMidiQueue->next(ud->virtualMidiReader);
+            continue;
+        }
+        if (event.size > nBytes - count) {
+            break;
+        }
+        if (ud->virtualMidiQueue->copyData(event, buf + count)) {
+            count += event.size;
+            if (now < 0) {
+                now = MidiQueue::now();
+            }
+            ud->virtualMidiLatency.store(now - event.time, std::memory_order_relaxed);
+            ud->virtualMidiOutputLatency.store(time + ud->midiLatency - event.time,
+                                               std::memory_order_relaxed);
+        }
+        ud->virtualMidiQueue->next(ud->virtualMidiReader);
+    }
+    count += ud->midiFilePlayer->read(csoundGetCurrentTimeSamples(csound), csoundGetKsmps(csound),
+                                      ud->sampleRate, buf + count, nBytes - count);
+    return count;
 }
 
 int CsoundEngine::midiInCloseCb(CSOUND *csound, void *ud)
@@ -283,7 +400,6 @@ int CsoundEngine::midiOutOpenCb(CSOUND *csound, void **ud, const char *devName)
 {
     CsoundUserData *userData = (CsoundUserData *) csoundGetHostData(csound);
     Q_UNUSED(devName);
-    Q_ASSERT(userData->midiBuffer);
     if (userData) {
         *ud = userData;
     } else {
@@ -296,21 +412,29 @@ int CsoundEngine::midiOutOpenCb(CSOUND *csound, void **ud, const char *devName)
 
 int CsoundEngine::midiWriteCb(CSOUND *csound, void *ud_, const unsigned char *buf, int nBytes)
 {
+    QCS_TRACE_SCOPE("midiWriteCb");
     CsoundUserData *userData = (CsoundUserData *) ud_;
-    std::vector<unsigned char> message;
-    Q_UNUSED(csound);
-    message.push_back(*buf++);
-    nBytes--;
-    while (nBytes--) {
-        if (*buf & 0x80) {
-            userData->midiHandler->sendMidiOut(&message);
-            message.clear();
+    if (userData->midiHandler == nullptr) {
+        return 0;
+    }
+    // Queued for the MIDI out thread, to be sent when this k-cycle is heard
+    qint64 time = kcycleTime(csound, userData) + userData->midiLatency;
+    int start = 0;
+    while (start < nBytes) {
+        // A message runs to the next status byte. SysEx includes its 0xF7
+        int end = start + 1;
+        while (end < nBytes && !(buf[end] & 0x80)) {
+            end++;
         }
-        message.push_back(*buf++);
-    }
-    if (message.size() > 0) {
-        userData->midiHandler->sendMidiOut(&message);
+        if (buf[start] == 0xF0 && end < nBytes && buf[end] == 0xF7) {
+            end++;
+        }
+        if (!userData->midiOutQueue->push(buf + start, end - start, time)) {
+            userData->midiOutDropped++; // Longer than the queue can hold
+        }
+        start = end;
     }
+    userData->midiHandler->wakeMidiOut();
     return 0;
 }
 
@@ -329,21 +453,41 @@ const char *CsoundEngine::midiErrorStringCb(int)
 
 void CsoundEngine::queueMidiIn(std::vector< unsigned char > *message)
 {
-    if (ud->midiBuffer) {
-        csoundWriteCircularBuffer(ud->csound, ud->midiBuffer, message->data(), message->size()* sizeof(unsigned char));
-    }
+    m_midiQueue.push(message->data(), (int) message->size(), MidiQueue::now());
 }
 
 void CsoundEngine::queueVirtualMidiIn(std::vector< unsigned char > &message)
 {
-    if (ud->virtualMidiBuffer) {
-        csoundWriteCircularBuffer(ud->csound, ud->virtualMidiBuffer, message.data(), message.size()* sizeof(unsigned char));
-    }
+    queueVirtualMidiIn(message.data(), (int) message.size());
+}
+
+void CsoundEngine::queueVirtualMidiIn(const unsigned char *data, int size)
+{
+    // The performance thread reads without locking, the lock only keeps
+    // one producer at a time
+    QMutexLocker locker(&m_virtualMidiMutex);
+    m_virtualMidiQueue.push(data, size, MidiQueue::now());
 }
 
 void CsoundEngine::sendMidiOut(QVector<unsigned char> &message)
 {
-    (void) message;
+    if (ud->midiHandler != nullptr) {
+        std::vector<unsigned char> out(message.begin(), message.end());
+        ud->midiHandler->sendMidiOut(&out);
+    }
+}
+
+QList<QByteArray> CsoundEngine::readMidiIn(MidiQueue::Reader &reader)
+{
+    QList<QByteArray> messages;
+    MidiEvent event;
+    while (m_midiQueue.read(reader, event)) {
+        QByteArray message(event.size, 0);
+        if (m_midiQueue.copyData(event, (unsigned char *) message.data())) {
+            messages << message;
+        }
+    }
+    return messages;
 }
 
 #endif
@@ -386,16 +530,14 @@ int CsoundEngine::keyEventCallback(void *userData,
     CsoundUserData *ud = (CsoundUserData *) userData;
     //  WidgetLayout *wl = (WidgetLayout *) ud->wl;
     int *value = (int *) p;
-	int key = ud->csEngine->popKeyPressEvent();
-	if (key >= 0) {
-		*value = key;
-		qDebug()  << "Pressed: " << key;
+    int key = ud->hostInput->popKeyPress();
+    if (key >= 0) {
+        *value = key;
     }
     else if (type & CSOUND_CALLBACK_KBD_EVENT) {
-        key = ud->csEngine->popKeyReleaseEvent();
+        key = ud->hostInput->popKeyRelease();
         if (key >= 0) {
             *value = key | 0x10000;
-			qDebug()  << "Released: " << key;
         }
     }
     return 0;
@@ -403,9 +545,22 @@ int CsoundEngine::keyEventCallback(void *userData,
 
 void CsoundEngine::csThread(void *data)
 {
+    QCS_TRACE_THREAD("Csound performance");
+    QCS_TRACE_SCOPE("csThread");
     CsoundUserData* udata = (CsoundUserData*)data;
+    MYFLT *outputBuffer = csoundGetSpout(udata->csound);
+    if (udata->recorder) {
+        udata->recorder->process(outputBuffer, udata->outputBufferSize,
+                                 1.0/udata->zerodBFS);
+    }
+    if (udata->midiClockSender
+            && udata->midiClockSender->process(udata->midiOutQueue,
+                                               kcycleTime(udata->csound, udata) + udata->midiLatency,
+                                               udata->outputBufferSize, udata->sampleRate,
+                                               MidiClock::instance()->sendTempo())) {
+        udata->midiHandler->wakeMidiOut();
+    }
     if (!(udata->flags & QCS_NO_COPY_BUFFER)) {
-        MYFLT *outputBuffer = csoundGetSpout(udata->csound);
         long numSamples = udata->outputBufferSize*udata->numChnls;
         udata->audioOutputBuffer.putManyScaled(outputBuffer, numSamples,
                                                1.0/udata->zerodBFS);
@@ -420,6 +575,7 @@ void CsoundEngine::csThread(void *data)
         //        csoundDeleteChannelList(udata->csound, *channelList);
         writeWidgetValues(udata);
         readWidgetValues(udata);
+        udata->controlSmoother->process();
     }
     if (!(udata->flags & QCS_NO_RT_EVENTS)) {
         udata->csEngine->processEventQueue();
@@ -447,6 +603,9 @@ void CsoundEngine::readWidgetValues(CsoundUserData *ud)
         QHash<QString, double>::const_iterator i;
         QHash<QString, double>::const_iterator end = ud->wl->newValues.constEnd();
         for (i = ud->wl->newValues.constBegin(); i != end; ++i) {
+            if (ud->controlSmoother->setTarget(i.key(), (MYFLT) i.value())) {
+                continue; // Written by the smoother
+            }
             if(csoundGetChannelPtr(ud->csound, &pvalue, i.key().toLocal8Bit().constData(),
                                    CSOUND_INPUT_CHANNEL | CSOUND_CONTROL_CHANNEL) == 0) {
                 *pvalue = (MYFLT) i.value();
@@ -500,6 +659,8 @@ void CsoundEngine::writeWidgetValues(CsoundUserData *ud)
 void CsoundEngine::setWidgetLayout(WidgetLayout *wl)
 {
     ud->wl = wl;
+    wl->setMidiQueue(&m_midiQueue);
+    wl->setHostInput(&m_hostInput);
     //  connect(wl, SIGNAL(destroyed()), this, SLOT(widgetLayoutDestroyed()));
     // Key presses on widget layout and console are passed to the engine
 	connect(wl, SIGNAL(keyPressed(int)),
@@ -519,7 +680,13 @@ void CsoundEngine::setWidgetLayout(WidgetLayout *wl)
 
 void CsoundEngine::setMidiHandler(MidiHandler *mh)
 {
+    if (ud->midiHandler) {
+        ud->midiHandler->removeOutputQueue(&m_midiOutQueue);
+    }
     ud->midiHandler = mh;
+    if (mh) {
+        mh->addOutputQueue(&m_midiOutQueue);
+    }
 }
 
 void CsoundEngine::enableWidgets(bool enable)
@@ -590,16 +757,22 @@ QList <int> CsoundEngine::getAnsiKeySequence(int key)  // convert sepcial keys (
 
 void CsoundEngine::keyPressForCsound(int key)
 {
-    keyMutex.lock();
-	keyPressBuffer << getAnsiKeySequence(key);
-	keyMutex.unlock();
+    QList<int> codes = getAnsiKeySequence(key);
+    foreach (int code, codes) {
+        m_hostInput.pushKeyPress(code);
+    }
+    if (!codes.isEmpty()) {
+        m_hostInput.setLastKey(codes.first(), true);
+        m_lastKeyPressed = key;
+    }
 }
 
 void CsoundEngine::keyReleaseForCsound(int key) // NB! I did not change this to int since seems Csound actually does not use it?
 {
-    keyMutex.lock();
-    keyReleaseBuffer << key;
-    keyMutex.unlock();
+    m_hostInput.pushKeyRelease(key);
+    if (key == m_lastKeyPressed) {
+        m_hostInput.setKeyUp();
+    }
 }
 
 void CsoundEngine::requestCsoundUserData(QuteWidget *widget) {
@@ -633,31 +806,6 @@ void CsoundEngine::evaluate(QString code)
 //  qDebug()  << "Not implemented";
 //}
 
-int CsoundEngine::popKeyPressEvent()
-{
-    int value = -1;
-	if (keyMutex.tryLock()) {
-        if (!keyPressBuffer.isEmpty()) {
-			value = keyPressBuffer.takeFirst();
-		}
-
-        keyMutex.unlock();
-    }
-	return value;
-}
-
-int CsoundEngine::popKeyReleaseEvent()
-{
-    int value = -1;
-    if (keyMutex.tryLock()) {
-        if (!keyReleaseBuffer.isEmpty()) {
-			value = keyReleaseBuffer.takeFirst();
-        }
-        keyMutex.unlock();
-    }
-    return value;
-}
-
 void CsoundEngine::processEventQueue()
 {
     // This function should only be called when Csound is running
@@ -729,31 +877,42 @@ void CsoundEngine::pause()
 
 int CsoundEngine::startRecording(int sampleformat, QString fileName)
 {
-    qDebug("start recording (%i-bit samples): %s",
-           (sampleformat + 2) * 8,
+    if (ud->recorder == nullptr) {
+        qDebug() << "CsoundEngine::startRecording Csound is not running";
+        return -1;
+    }
+    int fileType = fileName.endsWith(".aif", Qt::CaseInsensitive)
+            || fileName.endsWith(".aiff", Qt::CaseInsensitive) ? DiskRecorder::Aiff
+                                                               : DiskRecorder::Wav;
+    qDebug("start recording (format %i, %.0f seconds pre-roll): %s",
+           sampleformat, ud->recorder->prerollSeconds(),
            fileName.toLocal8Bit().constData());
-    // clip instead of wrap when converting floats to ints
-#ifdef PERFTHREAD_RECORD
-    // perfthread record API is only available with csound >= 6.04
-    if (ud->perfThread) {
-        m_recording = true;
-        ud->perfThread->Record(fileName.toLocal8Bit().constData(),
-                               (sampleformat + 2) * 8);
+    if (!ud->recorder->startRecording(fileName, fileType, sampleformat)) {
+        queueMessage(tr("Could not open %1 for recording: %2\n")
+                     .arg(fileName).arg(ud->recorder->errorString()));
+        return -1;
     }
-#endif
+    m_recording = true;
     return 0;
 }
 
 void CsoundEngine::stopRecording()
 {
+    if (!m_recording) {
+        return;
+    }
     m_recording = false;
-
-#ifdef	PERFTHREAD_RECORD
-    if (ud->perfThread) {
-        ud->perfThread->StopRecord();
+    if (ud->recorder == nullptr) {
+        return;
+    }
+    ud->recorder->stopRecording(); // Also reports a writer that stopped on its own
+    if (!ud->recorder->errorString().isEmpty()) {
+        queueMessage(tr("Recording stopped: %1\n").arg(ud->recorder->errorString()));
+    }
+    if (ud->recorder->droppedFrames() > 0) {
+        queueMessage(tr("Recording: %1 frames were dropped because the disk could not keep up\n")
+                     .arg(ud->recorder->droppedFrames()));
     }
-    //qDebug("Recording stopped.");
-#endif
 }
 
 void CsoundEngine::queueEvent(QString eventLine, int delay)
@@ -800,13 +959,6 @@ int CsoundEngine::runCsound()
     }
 #ifdef QCS_DESTROY_CSOUND
     ud->csound=csoundCreate((void *) ud);
-#ifdef CSOUND6
-    ud->midiBuffer = csoundCreateCircularBuffer(ud->csound, 1024, sizeof(unsigned char));
-    Q_ASSERT(ud->midiBuffer);
-    ud->virtualMidiBuffer = csoundCreateCircularBuffer(ud->csound, 1024, sizeof(unsigned char));
-    Q_ASSERT(ud->virtualMidiBuffer);
-    // csoundFlushCircularBuffer(ud->csound, ud->midiBuffer);
-#endif
 #endif
 #ifdef QCS_DEBUGGER
     if(m_debugging) {
@@ -919,15 +1071,34 @@ int CsoundEngine::runCsound()
     ud->sampleRate = csoundGetSr(ud->csound);
     ud->numChnls = csoundGetNchnls(ud->csound);
     ud->outputBufferSize = csoundGetKsmps(ud->csound);
+    // Discard MIDI that arrived while stopped
+    ud->midiReader = m_midiQueue.reader();
+    ud->virtualMidiReader = m_virtualMidiQueue.reader();
+    m_scriptMidiReader = m_midiQueue.reader();
+    m_hostInput.clearKeys(); // Discard keys pressed while stopped
+    m_midiFilePlayer.seek(m_midiFilePlayer.position()); // Follow the new performance's clock
+    ud->midiTimeOrigin = -1;
+    ud->midiOutDropped = 0;
+    ud->midiLatency = (qint64) csoundGetOutputBufferSize(ud->csound) * 1000000000LL / ud->sampleRate;
     if (ud->enableWidgets) {
         setupChannels();
     }
+    delete ud->recorder;
+    ud->recorder = new DiskRecorder(ud->sampleRate, ud->numChnls, m_options.recordPreroll);
     // Do not run the performance thread if the piece is an HTML file,
     // the HTML code must do that.
     if (!m_options.fileName1.endsWith(".html", Qt::CaseInsensitive)) {
         ud->perfThread = new CsoundPerformanceThread(ud->csound);
+        if (ud->midiHandler != nullptr && MidiClock::instance()->sendEnabled()
+                && MidiClock::instance()->claimOutput(this)) {
+            m_midiClockSender.reset();
+            ud->midiClockSender = &m_midiClockSender;
+        }
         ud->perfThread->SetProcessCallback(CsoundEngine::csThread, (void*)ud);
         ud->perfThread->Play();
+        if (ud->wl != nullptr) {
+            ud->wl->startAnalysis();
+        }
     }
     return 0;
 }
@@ -1022,7 +1193,23 @@ void CsoundEngine::cleanupCsound()
         QDEBUG << "csound is null";
         return;
     }
+    if (ud->wl != nullptr) {
+        ud->wl->stopAnalysis();
+    }
     QMutexLocker locker(&csoundMutex);
+    delete ud->recorder; // Finishes the file if still recording
+    ud->recorder = nullptr;
+    if (ud->midiClockSender) { // The performance thread is gone
+        ud->midiClockSender->stop(&m_midiOutQueue, MidiQueue::now());
+        ud->midiHandler->wakeMidiOut();
+        ud->midiClockSender = nullptr;
+        MidiClock::instance()->releaseOutput(this);
+    }
+    if (ud->midiOutDropped > 0) {
+        queueMessage(tr("MIDI out: %1 messages longer than %2 bytes were not sent\n")
+                     .arg(ud->midiOutDropped).arg(m_midiOutQueue.longDataSize()));
+        ud->midiOutDropped = 0;
+    }
     csoundSetIsGraphable(ud->csound, 0);
     csoundSetMakeGraphCallback(ud->csound, nullptr);
     csoundSetDrawGraphCallback(ud->csound, nullptr);
@@ -1051,10 +1238,6 @@ void CsoundEngine::cleanupCsound()
 #endif
 
 #ifdef QCS_DESTROY_CSOUND
-    csoundDestroyCircularBuffer(ud->csound, ud->midiBuffer);
-    ud->midiBuffer = nullptr;
-    csoundDestroyCircularBuffer(ud->csound, ud->virtualMidiBuffer);
-    ud->virtualMidiBuffer = nullptr;
     csoundDestroy(ud->csound);
     ud->csound = nullptr;
 #else
@@ -1145,6 +1328,30 @@ void CsoundEngine::setupChannels()
     }
     csoundDeleteChannelList(ud->csound, channelList);
 
+    // Smoothed channels are created here, so they can be read with invalue too.
+    // The performance thread moves them, so HTML pieces have none and invalue
+    // reads the widgets directly
+    m_controlSmoother.clear();
+    m_controlSmoother.setControlRate(ud->sampleRate / (double) ud->outputBufferSize);
+    if (!m_options.fileName1.endsWith(".html", Qt::CaseInsensitive)) {
+        foreach (QuteWidget *w, widgets) {
+            int mode = w->property("QCS_smoothing").toInt();
+            if (!w->acceptsMidi() || mode == ControlSmoother::None) {
+                continue;
+            }
+            double time = w->property("QCS_smoothtime").toDouble();
+            QString channels[2] = {w->getChannelName(), w->getChannel2Name()};
+            double values[2] = {w->getValue(), w->getValue2()};
+            for (int i = 0; i < 2; i++) {
+                if (!channels[i].isEmpty() && !channels[i].startsWith("_")
+                        && csoundGetChannelPtr(ud->csound, &pvalue, channels[i].toLocal8Bit().constData(),
+                                               CSOUND_INPUT_CHANNEL | CSOUND_CONTROL_CHANNEL) == 0) {
+                    m_controlSmoother.addChannel(channels[i], pvalue, mode, time, (MYFLT) values[i]);
+                }
+            }
+        }
+    }
+
     // Force creation of string channels for _Browse widgets
     foreach (QuteWidget *w, widgets) {
         if (w->getChannelName().startsWith("_Browse")) {
@@ -1158,7 +1365,10 @@ void CsoundEngine::setupChannels()
 void CsoundEngine::messageListDispatcher(void *data)
 {
     CsoundUserData *ud_local = (CsoundUserData *) data;
+    QCS_TRACE_THREAD("Message dispatcher");
     while (ud_local->runDispatcher) {
+        Tracer *tracer = Tracer::instance();
+        qint64 traceStart = tracer->isRunning() ? tracer->now() : -1;
         ud_local->playMutex->lock();
         if (ud_local->perfThread && (ud_local->perfThread->GetStatus() != 0)) {
             // In case score has ended
@@ -1169,9 +1379,6 @@ void CsoundEngine::messageListDispatcher(void *data)
         }
         CSOUND *csound = ud_local->csEngine->getCsound();
         if (csound) {
-            if (ud_local->wl) {
-                ud_local->wl->getMouseValues(&ud_local->mouseValues);
-            }
             int count = csoundGetMessageCnt(csound);
             ud_local->csEngine->m_messageMutex.lock();
             for (int i = 0; i< count; i++) {
@@ -1200,6 +1407,9 @@ void CsoundEngine::messageListDispatcher(void *data)
             ud_local->csEngine->messageQueue << "\nCsoundQt: Message buffer overflow. Messages discarded!\n";
         }
         ud_local->csEngine->m_messageMutex.unlock();
+        if (traceStart >= 0) {  // Not including the sleep
+            tracer->record("messageListDispatcher", traceStart, tracer->now());
+        }
 #ifdef USE_QT5
         QThread::usleep(ud_local->msgRefreshTime);
 #else
@@ -1238,6 +1448,20 @@ void CsoundEngine::flushQueues()
     //	qApp->processEvents();
 }
 
+qint64 CsoundEngine::bufferMemoryUsage()
+{
+    qint64 bytes = ud->audioOutputBuffer.memoryUsage();
+    if (ud->recorder) {
+        bytes += ud->recorder->memoryUsage();
+    }
+    m_messageMutex.lock();
+    foreach (const QString &msg, messageQueue) {
+        bytes += sizeof(void *) + sizeof(QString) + msg.capacity() * sizeof(QChar);
+    }
+    m_messageMutex.unlock();
+    return bytes;
+}
+
 void CsoundEngine::queueMessage(QString message)
 {
     m_messageMutex.lock();
@@ -1254,9 +1478,20 @@ bool CsoundEngine::isRunning()
 
 bool CsoundEngine::isRecording()
 {
+    if (m_recording && (ud->recorder == nullptr || !ud->recorder->isRecording())) {
+        stopRecording(); // The writer stopped after an error
+    }
     return m_recording;
 }
 
+QString CsoundEngine::recordingStatus()
+{
+    if (!isRecording()) {
+        return QString();
+    }
+    return ud->recorder->statusText();
+}
+
 CSOUND *CsoundEngine::getCsound()
 {
     return ud->csound;
@@ -38,6 +38,12 @@
 
 #include "types.h"
 #include "csoundoptions.h"
+#include "midiqueue.h"
+#include "midifile.h"
+#include "midiclock.h"
+#include "hostinput.h"
+#include "controlsmoother.h"
+#include "tablechanges.h"
 #ifdef QCS_PYTHONQT
 #include "pythonconsole.h"
 #endif
@@ -51,6 +57,7 @@ class CsoundEngine;
 class WidgetLayout;
 class MidiHandler;
 class QuteWidget;
+class DiskRecorder;
 
 // Csound 5.10 needs to be destroyed for opcodes like ficlose to flush the output
 // This still necessary for 5.12 and Csound6
@@ -74,8 +81,10 @@ struct CsoundUserData {
 	QMutex *playMutex; //perfThread access Mutex
 	/* performance */
 	bool runDispatcher;
-	QVector<double> mouseValues;
+	HostInput *hostInput; // Keyboard and mouse
+	ControlSmoother *controlSmoother; // Widget values for smoothed input channels
 	RingBuffer audioOutputBuffer;
+	DiskRecorder *recorder; // Fed on every k-cycle while running, for the pre-roll
 	bool enableWidgets; // Whether widget values are processed in the callback
 
 	/* current configuration */
@@ -95,8 +104,19 @@ struct CsoundUserData {
 	QList<QVariant> previousOutputValues;
 	QList<QVariant> previousStringOutputValues;
 
-	void *midiBuffer; //Csound Circular Buffer
-	void *virtualMidiBuffer; //Csound Circular Buffer
+	MidiQueue *midiQueue; // Hardware MIDI in
+	MidiQueue::Reader midiReader;
+	MidiQueue *midiOutQueue; // Drained by the MidiHandler output thread
+	qint64 midiTimeOrigin; // Time of sample 0 for MIDI in, in MidiQueue::now() time
+	int midiOutDropped; // Messages too long for the MIDI out queue, written by the performance thread
+	qint64 midiLatency; // Output buffer duration in nanoseconds, MIDI in and out are delayed by this much to remove jitter
+	MidiQueue *virtualMidiQueue; // Virtual keyboard and scripts, passed on the next k-cycle
+	MidiQueue::Reader virtualMidiReader;
+	std::atomic<qint64> virtualMidiLatency; // Of the last virtual message, until read by Csound (ns)
+	std::atomic<qint64> virtualMidiOutputLatency; // Until its k-cycle is heard (ns)
+	MidiFilePlayer *midiFilePlayer;
+	MidiClockSender *midiClockSender; // Null when this engine doesn't send clock
+	TableChanges *tableChanges; // Table ranges written by the host, for table widgets
 
 #ifdef QCS_PYTHONQT
 	PythonConsole *m_pythonConsole;
@@ -148,8 +168,16 @@ public:
 	static int midiOutCloseCb(CSOUND *csound, void *ud);
 	static const char *midiErrorStringCb(int);
 	void queueMidiIn(std::vector<unsigned char> *message);
+	MidiQueue *midiQueue() { return &m_midiQueue; }
+	MidiFilePlayer *midiFilePlayer() { return &m_midiFilePlayer; }
 	void queueVirtualMidiIn(std::vector<unsigned char> &message);
+	void queueVirtualMidiIn(const unsigned char *data, int size);
+	qint64 virtualMidiLatency() { return ud->virtualMidiLatency.load(std::memory_order_relaxed); }
+	qint64 virtualMidiOutputLatency() { return ud->virtualMidiOutputLatency.load(std::memory_order_relaxed); }
 	void sendMidiOut(QVector<unsigned char> &message);
+	// Messages received since the last call for this reader, for scripts
+	QList<QByteArray> readMidiIn(MidiQueue::Reader &reader);
+	QList<QByteArray> readScriptMidiIn() { return readMidiIn(m_scriptMidiReader); } // Python
 
 	static void makeGraphCallback(CSOUND *csound, WINDAT *windat, const char *name);
 	static void drawGraphCallback(CSOUND *csound, WINDAT *windat);
@@ -173,17 +201,17 @@ public:
 	void registerConsole(ConsoleWidget *c);  // Messages generated by Csound and CsoundQt are passed to the consoles registered here, and nowhere else
 	QList<QPair<int, QString> > getErrorLines();
 	void setConsoleBufferSize(int size);
-	int popKeyPressEvent();
-	int popKeyReleaseEvent();
 
 	void processEventQueue();
 	void passOutValue(QString channelName, double value);
 	void passOutString(QString channelName, QString value);
 	void flushQueues();
 	void queueMessage(QString message);
+	qint64 bufferMemoryUsage(); // Scope buffer and pending messages
 
 	bool isRunning();
 	bool isRecording();
+	QString recordingStatus();
 
 	// To pass to parent document for access from python scripting
 	CSOUND * getCsound();
@@ -251,13 +279,22 @@ private:
 	CsoundUserData *ud;
 
 	CsoundOptions m_options;
+	MidiQueue m_midiQueue;
+	// MIDI out and virtual MIDI seldom carry SysEx, so they get a small long data pool
+	MidiQueue m_midiOutQueue;
+	MidiQueue m_virtualMidiQueue;
+	TableChanges m_tableChanges;
+	QMutex m_virtualMidiMutex; // Virtual MIDI comes from the GUI and the script threads
+	MidiQueue::Reader m_scriptMidiReader;
+	MidiFilePlayer m_midiFilePlayer;
+	MidiClockSender m_midiClockSender;
 
 	int m_consoleBufferSize;
 	QMutex m_messageMutex; // Protection for message queue
 	QStringList messageQueue;  // Messages from Csound execution
-	QMutex keyMutex; // For keys pressed to pass to Csound from console and widget panel
-	QList <int> keyPressBuffer; // protected by keyMutex
-	QList <int> keyReleaseBuffer; // protected by keyMutex
+	HostInput m_hostInput; // Keys from console and widget panel, mouse from widget panel
+	ControlSmoother m_controlSmoother;
+	int m_lastKeyPressed; // As received, to tell when it is released
 
 	bool m_recording;
     // To prevent from starting a Csound instance while another is starting or closing
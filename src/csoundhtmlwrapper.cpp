@@ -70,6 +70,7 @@ void CsoundHtmlWrapper::setCsoundEngine(CsoundEngine *csEngine)
 {
     m_csoundEngine = csEngine;
     if (m_csoundEngine != nullptr) {
+        m_midiReader = m_csoundEngine->midiQueue()->reader();
         auto csound = m_csoundEngine->getCsound();
         if (csound != nullptr) {
             //TODO: Csound crashes later -- not sure why.
@@ -252,6 +253,45 @@ int CsoundHtmlWrapper::perform() {
     return 0;
 }
 
+QVariantList CsoundHtmlWrapper::readMidi() {
+    QVariantList messages;
+    if (!m_csoundEngine) {
+        return messages;
+    }
+    foreach (QByteArray message, m_csoundEngine->readMidiIn(m_midiReader)) {
+        QVariantList bytes;
+        for (int i = 0; i < message.size(); i++) {
+            bytes << (int) (unsigned char) message[i];
+        }
+        messages << QVariant(bytes);
+    }
+    return messages;
+}
+
+void CsoundHtmlWrapper::sendMidi(const QVariantList &message) {
+    if (!m_csoundEngine) {
+        return;
+    }
+    std::vector<unsigned char> bytes;
+    bytes.reserve(message.size());
+    foreach (QVariant byte, message) {
+        bytes.push_back(byte.toInt() & 0xFF);
+    }
+    m_csoundEngine->queueVirtualMidiIn(bytes);
+}
+
+void CsoundHtmlWrapper::sendMidiOut(const QVariantList &message) {
+    if (!m_csoundEngine) {
+        return;
+    }
+    QVector<unsigned char> bytes;
+    bytes.reserve(message.size());
+    foreach (QVariant byte, message) {
+        bytes.append(byte.toInt() & 0xFF);
+    }
+    m_csoundEngine->sendMidiOut(bytes);
+}
+
 int CsoundHtmlWrapper::readScore(const QString &text) {
     if (!m_csoundEngine) {
         return -1;
@@ -396,6 +436,7 @@ void CsoundHtmlWrapper::tableSet(int table_number, int index, double value){
         return;
     }
     csoundTableSet(getCsound(), table_number, index, value);
+    m_csoundEngine->getUserData()->tableChanges->markDirty(table_number, index, index);
 }
 
 
@@ -63,6 +63,10 @@ public slots:
     int isScorePending();
     void message(const QString &text);
     int perform();
+    // MIDI messages are arrays of bytes and can be SysEx
+    QVariantList readMidi(); // Received from the MIDI in port since the last call
+    void sendMidi(const QVariantList &message); // To Csound
+    void sendMidiOut(const QVariantList &message); // To the MIDI out port
     int readScore(const QString &text);
     void reset();
     void rewindScore();
@@ -95,6 +99,7 @@ private:
     QString csoundMessageBuffer;
     CsoundHtmlView *csoundHtmlView;
     CsoundEngine *m_csoundEngine;
+    MidiQueue::Reader m_midiReader;
     QObject *message_callback;
 };
 
@@ -59,6 +59,8 @@ CsoundOptions::CsoundOptions(ConfigLists *configlists) :
 	fileOutputFilename = "";
 
 	sampleFormat = 0;
+	recordFileType = 0;
+	recordPreroll = 10;
 
 	rtUseOptions = true;
 	rtOverrideOptions = false;
@@ -67,7 +67,9 @@ public:
 	bool fileOutputFilenameActive;
 	QString fileOutputFilename;
 
-	int sampleFormat;
+	int sampleFormat; // For the record button, see DiskRecorder::SampleFormat
+	int recordFileType; // 0=wav 1=aiff
+	int recordPreroll; // Seconds of output kept before recording starts, 0 = off
 
 	bool rtUseOptions;
 	bool rtOverrideOptions;
@@ -55,6 +55,7 @@ Curve::Curve(MYFLT *data, size_t size, const QString& caption,
 	m_y_scale = y_scale;
 	m_dotted_divider = dotted_divider;
 	m_original = original;
+	m_version = 1;
 	mutex.unlock();
 }
 
@@ -70,6 +71,7 @@ Curve::Curve(const Curve& curve)
 	m_absmax = curve.m_absmax;
 	m_y_scale = curve.m_y_scale;
 	m_dotted_divider = curve.m_dotted_divider;
+	m_version = curve.m_version;
 	mutex.unlock();
 }
 
@@ -87,6 +89,7 @@ Curve& Curve::operator=(const Curve& curve)
 		m_absmax = curve.m_absmax;
 		m_y_scale = curve.m_y_scale;
 		m_dotted_divider = curve.m_dotted_divider;
+		m_version = curve.m_version;
 	}
 	mutex.unlock();
 	return *this;
@@ -109,10 +112,10 @@ size_t Curve::get_size() const
 //  return m_id;
 //}
 
-// MYFLT *Curve::get_data() const
-// {
-//   return m_data;
-// }
+MYFLT *Curve::get_data() const
+{
+	return m_data;
+}
 
 MYFLT Curve::get_data(int index)
 {
@@ -157,6 +160,11 @@ WINDAT * Curve::getOriginal()
 	return m_original;
 }
 
+quint64 Curve::get_version() const
+{
+	return m_version;
+}
+
 //void Curve::set_id(uintptr_t id)
 //{
 //  m_id = id;
@@ -165,6 +173,7 @@ WINDAT * Curve::getOriginal()
 void Curve::set_data(MYFLT * data)
 {
 	copy(m_size, data);
+	m_version++;
 }
 
 void Curve::set_size(size_t size)
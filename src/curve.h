@@ -44,7 +44,7 @@ public:
 	Curve &operator=(const Curve&);
 	~Curve();
 	//    uintptr_t get_id() const;
-	//     MYFLT *get_data() const;
+	MYFLT *get_data() const;
 	MYFLT get_data(int index);
 	size_t get_size() const;      // number of points
 	QString get_caption() const; // title of curve
@@ -54,6 +54,7 @@ public:
 	MYFLT get_absmax() const;     // abs max of above
 	MYFLT get_y_scale() const;    // Y axis scaling factor
 	WINDAT * getOriginal();
+	quint64 get_version() const;  // incremented each time the data is set
 
 	//    void set_id(uintptr_t id);
 	void set_data(MYFLT * data);
@@ -77,6 +78,7 @@ private:
 	Polarity m_polarity;
 	MYFLT m_max, m_min, m_absmax, m_y_scale;
 	bool m_dotted_divider;
+	quint64 m_version;
 	void copy(size_t, MYFLT *);
 	void destroy();
 
@@ -0,0 +1,375 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#include "diskrecorder.h"
+#include "tracer.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <cmath>
+#include <cstring>
+
+// Writes are kept to multiples of this many frames, which keeps every write
+// after the header a multiple of 4096 bytes for any channel count and format
+#define QCS_RECORD_ALIGN_FRAMES 4096
+
+template <int bytes>
+static inline void putSample(char *out, quint32 value, bool bigEndian)
+{
+	for (int i = 0; i < bytes; i++) {
+		out[bigEndian ? bytes - 1 - i : i] = (char) ((value >> (8 * i)) & 0xFF);
+	}
+}
+
+// Clips instead of wrapping
+static inline quint32 toInt(float x, double fullScale)
+{
+	double value = x * fullScale;
+	if (value > fullScale) {
+		value = fullScale;
+	}
+	else if (value < -fullScale - 1) {
+		value = -fullScale - 1;
+	}
+	return (quint32) (qint32) floor(value + 0.5);
+}
+
+// IEEE 754 80-bit extended, used for the sample rate in AIFF files
+static void writeExtended(QDataStream &s, double value)
+{
+	int exponent = 0;
+	double mantissa = frexp(value, &exponent);
+	s << (quint16) (value > 0 ? exponent - 1 + 16383 : 0);
+	s << (quint64) ldexp(mantissa, 64);
+}
+
+DiskRecorder::DiskRecorder(int sampleRate, int channels, double prerollSeconds, QObject *parent) :
+	QThread(parent), m_sampleRate(sampleRate), m_channels(channels), m_state(Idle),
+	m_writePos(0), m_readPos(0), m_stopPos(0), m_fileType(Wav), m_sampleFormat(Int16),
+	m_bytesPerSample(2), m_bytesWritten(0), m_throughput(0), m_droppedFrames(0), m_maxFill(0)
+{
+	m_prerollFrames = (quint64) (qMax(prerollSeconds, 0.0) * sampleRate);
+	m_headroomFrames = (quint64) QCS_RECORD_HEADROOM * sampleRate;
+	quint64 maxFrames = QCS_RECORD_MAX_RING_BYTES / (qMax(m_channels, 1) * sizeof(float));
+	m_capacity = 1;
+	while (m_capacity < m_prerollFrames + m_headroomFrames && m_capacity * 2 <= maxFrames) {
+		m_capacity <<= 1;
+	}
+	if (m_capacity < m_prerollFrames + m_headroomFrames) {
+		m_headroomFrames = qMin(m_headroomFrames, m_capacity / 2);
+		m_prerollFrames = m_capacity - m_headroomFrames;
+		qDebug() << "DiskRecorder: pre-roll shortened to" << prerollSeconds() << "seconds";
+	}
+	m_ring = new float[m_capacity * m_channels];
+	memset(m_ring, 0, m_capacity * m_channels * sizeof(float));
+	m_block = (char *) qMallocAligned(QCS_RECORD_BLOCK_FRAMES * m_channels * 4,
+									  QCS_RECORD_DATA_OFFSET);
+}
+
+DiskRecorder::~DiskRecorder()
+{
+	stopRecording();
+	delete[] m_ring;
+	qFreeAligned(m_block);
+}
+
+QString DiskRecorder::extension(int fileType)
+{
+	return fileType == Aiff ? QString(".aif") : QString(".wav");
+}
+
+void DiskRecorder::process(const MYFLT *samples, int frames, MYFLT scale)
+{
+	int state = m_state.load(std::memory_order_acquire);
+	if (state == Idle && m_prerollFrames == 0) {
+		return;
+	}
+	quint64 write = m_writePos.load(std::memory_order_relaxed);
+	if (state != Idle) {
+		// While idle the oldest frames are simply overwritten
+		quint64 fill = write - m_readPos.load(std::memory_order_acquire) + frames;
+		if (fill > m_capacity) {
+			if (state == Recording) {
+				m_droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+			}
+			return;
+		}
+		if (fill > m_maxFill.load(std::memory_order_relaxed)) {
+			m_maxFill.store(fill, std::memory_order_relaxed);
+		}
+	}
+	quint64 mask = m_capacity - 1;
+	for (int i = 0; i < frames; i++) {
+		float *frame = m_ring + ((write + i) & mask) * m_channels;
+		for (int chn = 0; chn < m_channels; chn++) {
+			frame[chn] = (float) (samples[i * m_channels + chn] * scale);
+		}
+	}
+	m_writePos.store(write + frames, std::memory_order_release);
+}
+
+bool DiskRecorder::startRecording(QString fileName, int fileType, int sampleFormat)
+{
+	stopRecording();
+	wait(); // The writer may have stopped on its own after an error
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+		m_error = m_file.errorString();
+		qDebug() << "DiskRecorder::startRecording can't open" << fileName << m_error;
+		return false;
+	}
+	m_fileType = fileType;
+	m_sampleFormat = sampleFormat;
+	m_bytesPerSample = sampleFormat == Int16 ? 2 : (sampleFormat == Int24 ? 3 : 4);
+	m_error.clear();
+	m_bytesWritten.store(0);
+	m_throughput.store(0);
+	m_droppedFrames.store(0);
+	m_file.write(header(0));
+
+	// Start with the pre-roll that is already in the ring
+	quint64 write = m_writePos.load(std::memory_order_acquire);
+	quint64 preroll = qMin(write, m_prerollFrames);
+	m_readPos.store(write - preroll, std::memory_order_relaxed);
+	m_maxFill.store(preroll);
+	m_state.store(Recording, std::memory_order_release);
+	start(QThread::HighPriority);
+	return true;
+}
+
+void DiskRecorder::stopRecording()
+{
+	if (m_state.load(std::memory_order_acquire) == Idle) {
+		return;
+	}
+	m_stopPos = m_writePos.load(std::memory_order_acquire);
+	m_state.store(Draining, std::memory_order_release);
+	wait();
+	m_state.store(Idle, std::memory_order_release);
+}
+
+QString DiskRecorder::errorString()
+{
+	// m_error is only written by the writer thread before it goes idle
+	return m_state.load(std::memory_order_acquire) == Idle ? m_error : QString();
+}
+
+double DiskRecorder::bufferFill()
+{
+	if (!isRecording()) {
+		return 0;
+	}
+	quint64 fill = m_writePos.load(std::memory_order_relaxed)
+			- m_readPos.load(std::memory_order_relaxed);
+	return qMin(fill / (double) m_capacity, 1.0);
+}
+
+QString DiskRecorder::statusText()
+{
+	QString error = errorString();
+	if (!error.isEmpty()) {
+		return tr("Recording stopped: %1").arg(error);
+	}
+	return tr("Recording %1: %2 MB, %3 MB/s, buffer %4% (max %5%), %6 frames dropped")
+			.arg(fileName())
+			.arg(bytesWritten() / 1048576.0, 0, 'f', 1)
+			.arg(throughput() / 1048576.0, 0, 'f', 2)
+			.arg(qRound(bufferFill() * 100))
+			.arg(qRound(maxBufferFill() * 100))
+			.arg(droppedFrames());
+}
+
+qint64 DiskRecorder::memoryUsage()
+{
+	return m_capacity * m_channels * sizeof(float)
+			+ QCS_RECORD_BLOCK_FRAMES * m_channels * 4;
+}
+
+void DiskRecorder::run()
+{
+	QCS_TRACE_THREAD("Disk recorder");
+	quint64 minFrames = qBound((quint64) QCS_RECORD_ALIGN_FRAMES, m_headroomFrames / 4,
+							   (quint64) QCS_RECORD_BLOCK_FRAMES);
+	QElapsedTimer timer;
+	timer.start();
+	qint64 lastBytes = 0;
+	while (true) {
+		bool draining = m_state.load(std::memory_order_acquire) == Draining;
+		quint64 end = draining ? m_stopPos : m_writePos.load(std::memory_order_acquire);
+		quint64 read = m_readPos.load(std::memory_order_relaxed);
+		quint64 available = end - read;
+		if (draining && available == 0) {
+			break;
+		}
+		if (available >= minFrames || draining) {
+			int frames = (int) qMin(available, (quint64) QCS_RECORD_BLOCK_FRAMES);
+			if (!draining) {
+				frames -= frames % QCS_RECORD_ALIGN_FRAMES;
+			}
+			qint64 bytes = convert(read, frames);
+			m_readPos.store(read + frames, std::memory_order_release);
+			if (!writeBlock(bytes)) {
+				break;
+			}
+		}
+		else {
+			msleep(10);
+		}
+		if (timer.elapsed() >= 1000) {
+			qint64 written = m_bytesWritten.load(std::memory_order_relaxed);
+			m_throughput.store((written - lastBytes) * 1000.0 / timer.restart(),
+							   std::memory_order_relaxed);
+			lastBytes = written;
+		}
+	}
+	m_file.seek(0);
+	m_file.write(header(m_bytesWritten.load()));
+	m_file.close();
+	if (!m_error.isEmpty()) {
+		qDebug() << "DiskRecorder: recording stopped." << m_error;
+		m_state.store(Idle, std::memory_order_release);
+	}
+}
+
+qint64 DiskRecorder::convert(quint64 position, int frames)
+{
+	QCS_TRACE_SCOPE("DiskRecorder::convert");
+	bool bigEndian = m_fileType == Aiff;
+	quint64 mask = m_capacity - 1;
+	char *out = m_block;
+	for (int i = 0; i < frames; i++) {
+		const float *frame = m_ring + ((position + i) & mask) * m_channels;
+		switch (m_sampleFormat) {
+		case Int16:
+			for (int chn = 0; chn < m_channels; chn++, out += 2) {
+				putSample<2>(out, toInt(frame[chn], 32767.0), bigEndian);
+			}
+			break;
+		case Int24:
+			for (int chn = 0; chn < m_channels; chn++, out += 3) {
+				putSample<3>(out, toInt(frame[chn], 8388607.0), bigEndian);
+			}
+			break;
+		case Int32:
+			for (int chn = 0; chn < m_channels; chn++, out += 4) {
+				putSample<4>(out, toInt(frame[chn], 2147483647.0), bigEndian);
+			}
+			break;
+		default:
+			for (int chn = 0; chn < m_channels; chn++, out += 4) {
+				quint32 value;
+				memcpy(&value, &frame[chn], 4);
+				putSample<4>(out, value, bigEndian);
+			}
+		}
+	}
+	return out - m_block;
+}
+
+bool DiskRecorder::writeBlock(qint64 bytes)
+{
+	QCS_TRACE_SCOPE("DiskRecorder::write");
+	qint64 written = m_bytesWritten.load(std::memory_order_relaxed);
+	if (m_fileType == Aiff && written + bytes > 0xFFFFFFFFLL - QCS_RECORD_DATA_OFFSET) {
+		m_error = tr("AIFF files can't be larger than 4 GB");
+		return false;
+	}
+	if (m_file.write(m_block, bytes) != bytes) {
+		m_error = m_file.errorString();
+		return false;
+	}
+	m_bytesWritten.store(written + bytes, std::memory_order_relaxed);
+	return true;
+}
+
+// The header is always QCS_RECORD_DATA_OFFSET bytes long. It is written with
+// zero sizes when recording starts and rewritten with the final sizes at the end.
+QByteArray DiskRecorder::header(qint64 dataBytes)
+{
+	QByteArray header;
+	QDataStream s(&header, QIODevice::WriteOnly);
+	bool isFloat = m_sampleFormat == Float32;
+	quint16 bits = m_bytesPerSample * 8;
+	quint16 blockAlign = m_bytesPerSample * m_channels;
+	quint64 frames = dataBytes / blockAlign;
+	if (m_fileType == Aiff) {
+		// Floats need AIFF-C
+		s.setByteOrder(QDataStream::BigEndian);
+		s.writeRawData("FORM", 4);
+		s << (quint32) (QCS_RECORD_DATA_OFFSET - 8 + dataBytes);
+		s.writeRawData(isFloat ? "AIFC" : "AIFF", 4);
+		if (isFloat) {
+			s.writeRawData("FVER", 4);
+			s << (quint32) 4 << (quint32) 0xA2805140;
+		}
+		s.writeRawData("COMM", 4);
+		s << (quint32) (isFloat ? 36 : 18);
+		s << (quint16) m_channels << (quint32) frames << bits;
+		writeExtended(s, m_sampleRate);
+		if (isFloat) {
+			s.writeRawData("fl32", 4);
+			s << (quint8) 12;
+			s.writeRawData("32-bit float", 12);
+			s << (quint8) 0; // Pad to even length
+		}
+		s.writeRawData("SSND", 4);
+		quint32 offset = QCS_RECORD_DATA_OFFSET - header.size() - 12;
+		s << (quint32) (8 + offset + dataBytes) << offset << (quint32) 0;
+		s.writeRawData(QByteArray(offset, 0).constData(), offset);
+	}
+	else {
+		// A JUNK chunk pads the header, and holds the 64-bit sizes (ds64)
+		// if the file grows past 4 GB and becomes RF64
+		s.setByteOrder(QDataStream::LittleEndian);
+		bool extensible = m_channels > 2;
+		quint32 fmtSize = extensible ? 40 : (isFloat ? 18 : 16);
+		quint32 junkSize = QCS_RECORD_DATA_OFFSET - 36 - fmtSize;
+		qint64 riffSize = QCS_RECORD_DATA_OFFSET - 8 + dataBytes;
+		bool rf64 = riffSize > 0xFFFFFFFFLL;
+		s.writeRawData(rf64 ? "RF64" : "RIFF", 4);
+		s << (quint32) (rf64 ? 0xFFFFFFFF : riffSize);
+		s.writeRawData("WAVE", 4);
+		s.writeRawData(rf64 ? "ds64" : "JUNK", 4);
+		s << junkSize;
+		quint32 padding = junkSize;
+		if (rf64) {
+			s << (quint64) riffSize << (quint64) dataBytes << frames << (quint32) 0;
+			padding -= 28;
+		}
+		s.writeRawData(QByteArray(padding, 0).constData(), padding);
+		s.writeRawData("fmt ", 4);
+		s << fmtSize << (quint16) (extensible ? 0xFFFE : (isFloat ? 3 : 1));
+		s << (quint16) m_channels << (quint32) m_sampleRate
+		  << (quint32) (m_sampleRate * blockAlign) << blockAlign << bits;
+		if (extensible) {
+			s << (quint16) 22 << bits << (quint32) 0; // No speaker assignment
+			s << (quint16) (isFloat ? 3 : 1);
+			s.writeRawData("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71", 14);
+		}
+		else if (isFloat) {
+			s << (quint16) 0;
+		}
+		s.writeRawData("data", 4);
+		s << (quint32) (rf64 ? 0xFFFFFFFF : dataBytes);
+	}
+	Q_ASSERT(header.size() == QCS_RECORD_DATA_OFFSET);
+	return header;
+}
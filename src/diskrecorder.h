@@ -0,0 +1,127 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#ifndef DISKRECORDER_H
+#define DISKRECORDER_H
+
+#include <QThread>
+#include <QFile>
+#include <atomic>
+
+#include "types.h"
+
+// Frames converted and written to disk at a time
+#define QCS_RECORD_BLOCK_FRAMES 65536
+// Seconds of audio the ring can hold on top of the pre-roll before overflowing
+#define QCS_RECORD_HEADROOM 4
+// Largest ring, allocated on every run. Longer pre-rolls are shortened to fit
+#define QCS_RECORD_MAX_RING_BYTES (128 * 1024 * 1024)
+// Sound data starts at this offset in the file, so that block writes are aligned
+#define QCS_RECORD_DATA_OFFSET 4096
+
+//
+// Records the engine output to a sound file. The performance thread pushes
+// every k-cycle into a lock-free ring (process()) and a writer thread drains
+// it in large blocks, so the disk is never touched from the audio thread.
+// The ring always keeps the last prerollSeconds of audio, which are written
+// at the start of the file when recording starts.
+// If the writer can't keep up, whole k-cycles are dropped and counted.
+//
+class DiskRecorder : public QThread
+{
+	Q_OBJECT
+public:
+	enum FileType {
+		Wav = 0,  // Switches to RF64 when larger than 4 GB
+		Aiff = 1
+	};
+	enum SampleFormat {  // Same order as the "Record sample format" option
+		Int16 = 0,
+		Int24 = 1,
+		Float32 = 2,
+		Int32 = 3
+	};
+
+	// Must be created before the performance thread starts calling process()
+	DiskRecorder(int sampleRate, int channels, double prerollSeconds, QObject *parent = 0);
+	~DiskRecorder();
+
+	static QString extension(int fileType);
+
+	// Called from the performance thread
+	void process(const MYFLT *samples, int frames, MYFLT scale);
+
+	bool startRecording(QString fileName, int fileType, int sampleFormat);
+	void stopRecording(); // Blocks until the ring has been written
+	bool isRecording() { return m_state.load(std::memory_order_relaxed) != Idle; }
+	QString fileName() { return m_file.fileName(); }
+	QString errorString(); // Set when the writer stopped because of an error
+
+	// Monitoring, can be called while recording
+	qint64 bytesWritten() { return m_bytesWritten.load(std::memory_order_relaxed); }
+	double throughput() { return m_throughput.load(std::memory_order_relaxed); } // bytes/second
+	quint64 droppedFrames() { return m_droppedFrames.load(std::memory_order_relaxed); }
+	double bufferFill(); // Part of the ring waiting to be written, 0 to 1
+	double maxBufferFill() { return m_maxFill.load(std::memory_order_relaxed) / (double) m_capacity; }
+	double prerollSeconds() { return m_prerollFrames / (double) m_sampleRate; }
+	QString statusText();
+	qint64 memoryUsage();
+
+protected:
+	virtual void run();
+
+private:
+	enum State {
+		Idle,
+		Recording,
+		Draining
+	};
+
+	QByteArray header(qint64 dataBytes);
+	qint64 convert(quint64 position, int frames);
+	bool writeBlock(qint64 bytes);
+
+	int m_sampleRate;
+	int m_channels;
+	quint64 m_capacity;     // Ring size in frames, power of two
+	quint64 m_prerollFrames;
+	quint64 m_headroomFrames;
+	float *m_ring;
+
+	std::atomic<int> m_state;
+	std::atomic<quint64> m_writePos;  // In frames, only moved by process()
+	std::atomic<quint64> m_readPos;   // In frames, only moved by the writer
+	quint64 m_stopPos;
+
+	QFile m_file;
+	int m_fileType;
+	int m_sampleFormat;
+	int m_bytesPerSample;
+	char *m_block;          // Conversion buffer, aligned
+	QString m_error;
+
+	std::atomic<qint64> m_bytesWritten; // Sound data only
+	std::atomic<double> m_throughput;
+	std::atomic<quint64> m_droppedFrames;
+	std::atomic<quint64> m_maxFill;
+};
+
+#endif // DISKRECORDER_H
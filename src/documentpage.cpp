@@ -27,6 +27,7 @@
 #include "documentpage.h"
 #include "documentview.h"
 #include "csoundengine.h"
+#include "diskrecorder.h"
 #include "liveeventframe.h"
 #include "eventsheet.h"
 #include "liveeventcontrol.h"
@@ -1157,20 +1158,13 @@ void DocumentPage::registerButton(QuteButton *b)
 
 void DocumentPage::queueMidiIn(std::vector< unsigned char > *message)
 {
-    WidgetLayout *d = m_widgetLayouts[0];
-    unsigned int nBytes = message->size();
-    if (nBytes > 3 || nBytes < 1) {
-        qDebug() << "MIDI message ignored. nBytes=" << nBytes << " status =" << (int)message->at(0);
-        return;
-    }
-    if ( ((d->midiWriteCounter + 1) % QCS_MAX_MIDI_QUEUE) != d->midiReadCounter) {
-        int index = d->midiWriteCounter;
-        for (unsigned int i = 0; i < nBytes; i++) {
-            d->midiQueue[index][i] = (int)message->at(i);
-        }
-        d->midiWriteCounter = (d->midiWriteCounter + 1) % QCS_MAX_MIDI_QUEUE;
-    }
-    m_csEngine->queueMidiIn(message);
+	// Called from the MIDI input thread
+	unsigned int nBytes = message->size();
+	if (nBytes < 1) {
+		return;
+	}
+	m_csEngine->queueMidiIn(message);
+	m_widgetLayouts[0]->midiQueued();
 }
 
 void DocumentPage::queueVirtualMidiIn(std::vector< unsigned char > &message)
@@ -1178,6 +1172,67 @@ void DocumentPage::queueVirtualMidiIn(std::vector< unsigned char > &message)
     m_csEngine->queueVirtualMidiIn(message);
 }
 
+QList<QPair<QString, qint64> > DocumentPage::memoryUsage()
+{
+	QList<QPair<QString, qint64> > usage;
+	qint64 widgetHistoryBytes = widgetHistory.capacity() * sizeof(QString);
+	foreach (const QString &text, widgetHistory) {
+		widgetHistoryBytes += text.capacity() * sizeof(QChar);
+	}
+	qint64 curveBytes = 0;
+	foreach (WidgetLayout *wl, m_widgetLayouts) {
+		widgetHistoryBytes += wl->historyMemoryUsage();
+		curveBytes += wl->curvesMemoryUsage();
+	}
+	qint64 sheetBytes = 0;
+	foreach (LiveEventFrame *frame, m_liveFrames) {
+		sheetBytes += frame->getSheet()->historyMemoryUsage();
+	}
+	usage << QPair<QString, qint64>(tr("Document text"),
+									m_view->getFullText().capacity() * sizeof(QChar));
+	usage << QPair<QString, qint64>(tr("Syntax highlighting"), m_view->highlighterMemoryUsage());
+	usage << QPair<QString, qint64>(tr("Widget undo history"), widgetHistoryBytes);
+	usage << QPair<QString, qint64>(tr("Live event sheet history"), sheetBytes);
+	usage << QPair<QString, qint64>(tr("Graph curves"), curveBytes);
+	usage << QPair<QString, qint64>(tr("Console text"), m_console->memoryUsage());
+	usage << QPair<QString, qint64>(tr("Scope and message buffers"),
+									m_csEngine->bufferMemoryUsage());
+	return usage;
+}
+
+void DocumentPage::trimHistory()
+{
+	if (widgetHistory.size() > 1) {
+		QString current = widgetHistory[qBound(0, widgetHistoryIndex, widgetHistory.size() - 1)];
+		widgetHistory.clear();
+		widgetHistory << current;
+		widgetHistory.squeeze();
+		widgetHistoryIndex = 0;
+	}
+	foreach (WidgetLayout *wl, m_widgetLayouts) {
+		wl->trimHistory();
+	}
+	foreach (LiveEventFrame *frame, m_liveFrames) {
+		frame->getSheet()->trimHistory();
+	}
+}
+
+void DocumentPage::clearConsoles()
+{
+	m_console->reset();
+}
+
+bool DocumentPage::releaseCurves()
+{
+	if (isRunning()) {
+		return false;
+	}
+	foreach (WidgetLayout *wl, m_widgetLayouts) {
+		wl->clearGraphs();
+	}
+	return true;
+}
+
 void DocumentPage::init(QWidget *parent, OpEntryParser *opcodeTree)
 {
 	fileName = "";
@@ -1267,9 +1322,8 @@ void DocumentPage::stop()
 	}
 }
 
-int DocumentPage::record(int format)
+int DocumentPage::record(int format, int fileType)
 {
-#ifdef	PERFTHREAD_RECORD
 	if (fileName.startsWith(":/")) {
 		QMessageBox::critical(static_cast<QWidget *>(parent()),
 							  tr("CsoundQt"),
@@ -1277,8 +1331,9 @@ int DocumentPage::record(int format)
 							  QMessageBox::Ok);
 		return -1;
 	}
+	QString extension = DiskRecorder::extension(fileType);
 	int number = 0;
-	QString recName = fileName + "-000.wav";
+	QString recName = fileName + "-000" + extension;
 	while (QFile::exists(recName)) {
 		number++;
 		recName = fileName + "-";
@@ -1286,15 +1341,15 @@ int DocumentPage::record(int format)
 			recName += "0";
 		if (number < 100)
 			recName += "0";
-		recName += QString::number(number) + ".wav";
+		recName += QString::number(number) + extension;
 	}
 	emit setCurrentAudioFile(recName);
 	return m_csEngine->startRecording(format, recName);
-#else
-    (void) format;
-	QMessageBox::warning(NULL, tr("Recording not possible"), tr("This version of CsoundQt was not built with recording support."));
-	return 0;
-#endif
+}
+
+QString DocumentPage::recordingStatus()
+{
+	return m_csEngine->recordingStatus();
 }
 
 void DocumentPage::perfEnded()
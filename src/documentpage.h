@@ -173,6 +173,11 @@ public:
 	virtual void registerButton(QuteButton *button);
 	void queueMidiIn(std::vector<unsigned char> *message);
     void queueVirtualMidiIn(std::vector<unsigned char> &message);
+	// Memory accounting (approximate bytes held per subsystem)
+	QList<QPair<QString, qint64> > memoryUsage();
+	void trimHistory();  // Widget and live event undo history
+	void clearConsoles();
+	bool releaseCurves();  // Only possible when not running
 	// Member public variables
 	bool askForFile;
 	bool readOnly; // Used for manual files and internal examples
@@ -182,7 +187,8 @@ public:
 public slots:
 	virtual int play(CsoundOptions *options);
 	void stop();
-	int record(int format);
+	int record(int format, int fileType);
+	QString recordingStatus();
 	void perfEnded();
 	void setHelp();
 	int runPython();  // Called when file is a python file
@@ -22,6 +22,8 @@
 
 #include "eventsheet.h"
 #include "liveeventframe.h"
+#include "midiclock.h"
+#include "midiqueue.h"
 
 #include <QMenu>
 #include <QDir>
@@ -33,6 +35,8 @@
 #include <QDoubleSpinBox>
 #include <QApplication>
 #include <QClipboard>
+#include <QFileDialog>
+#include <QInputDialog>
 
 #include <QFile>
 #include <QMessageBox>
@@ -158,6 +162,7 @@ EventSheet::EventSheet(QWidget *parent) : QTableWidget(parent)
 	connect(this, SIGNAL(cellChanged (int, int)), this, SLOT(cellChangedSlot(int, int)));
 
 	loopTimer.setSingleShot(true);
+	loopTimer.setTimerType(Qt::PreciseTimer); // For loops synced to MIDI clock
 	connect(&loopTimer, SIGNAL(timeout()), this, SLOT(sendEvents()));
 
 	builtinScripts << ":/python/sort_by_start.py" << ":/python/produce_score.py"<< ":/python/fill_text.py";
@@ -256,7 +261,7 @@ QString EventSheet::getLine(int number, bool scaleTempo, bool storeNumber, bool
 					if (i == 2) { // Add start offset to p2 before scaling
 						value += startOffset;
 					}
-					value = value * (60.0/m_tempo);
+					value = value * (60.0/currentTempo());
 					line += QString::number(value, 'f', 8);;
 				}
 				else {
@@ -431,7 +436,7 @@ void EventSheet::sendEvents()
 	QModelIndexList list;
 	QPair<int, int> rowsRange;
 	if (m_looping && sender() != sendEventsAct) {
-		double time = 1000.0 * m_loopLength * 60.0 /m_tempo;
+		int time = msecsToLoopStart(true);
 		loopTimer.start(time);
 		qDebug() << " EventSheet::sendEvents() " << time;
 		rowsRange.first = m_loopStart;
@@ -493,6 +498,38 @@ void EventSheet::loopEvents()
 	emit setLoopEnabledFromSheet(true);
 }
 
+double EventSheet::currentTempo()
+{
+	MidiClock *clock = MidiClock::instance();
+	if (clock->syncLoops()) {
+		qint64 now = MidiQueue::now();
+		if (clock->isRunning(now)) {
+			return clock->tempo(now);
+		}
+	}
+	return m_tempo;
+}
+
+// Loops synced to a running MIDI clock start on multiples of the loop length
+// in the song position, so they stay on the beat without drifting. Otherwise
+// the loop restarts after its length, and -1 is returned if not restarting
+int EventSheet::msecsToLoopStart(bool restart)
+{
+	MidiClock *clock = MidiClock::instance();
+	if (clock->syncLoops()) {
+		qint64 now = MidiQueue::now();
+		qint64 next = clock->nextBeatTime(now, m_loopLength);
+		if (next >= 0) {
+			qint64 length = (qint64) (m_loopLength * 60e9 / clock->tempo(now));
+			if (restart && next - now < length / 2) {
+				next += length; // The timer fired just before the boundary
+			}
+			return (int) ((next - now) / 1000000);
+		}
+	}
+	return restart ? (int) (1000.0 * m_loopLength * 60.0 / m_tempo) : -1;
+}
+
 void EventSheet::setLoopActive(bool loop)
 {
 	//  qDebug() << "EventSheet::setLoopActive " << loop;
@@ -500,7 +537,13 @@ void EventSheet::setLoopActive(bool loop)
 		if (!m_looping) {
 			m_looping = true;
 			markLoop(m_loopStart, m_loopEnd);
-			sendEvents();
+			int time = msecsToLoopStart(false);
+			if (time >= 0) {
+				loopTimer.start(time); // Wait for the beat
+			}
+			else {
+				sendEvents();
+			}
 		}
 	}
 	else {
@@ -666,6 +709,27 @@ void EventSheet::clearHistory()
 	historyIndex = 0;
 }
 
+void EventSheet::trimHistory()
+{
+	if (history.isEmpty()) {
+		return;
+	}
+	QString current = history[qBound(0, historyIndex, history.size() - 1)];
+	history.clear();
+	history << current;
+	history.squeeze();
+	historyIndex = 0;
+}
+
+qint64 EventSheet::historyMemoryUsage()
+{
+	qint64 bytes = history.capacity() * sizeof(QString);
+	foreach (const QString &text, history) {
+		bytes += text.capacity() * sizeof(QChar);
+	}
+	return bytes;
+}
+
 void EventSheet::setScriptDirectory(QString dir)
 {
 	scriptDir = dir;
@@ -1058,6 +1122,30 @@ void EventSheet::deleteRows()
 	}
 }
 
+void EventSheet::importMidiFile()
+{
+	QString fileName = QFileDialog::getOpenFileName(this, tr("Import MIDI File"), QString(),
+													tr("MIDI Files (*.mid *.midi *.smf);;All Files (*)"));
+	if (fileName.isEmpty()) {
+		return;
+	}
+	QStringList modes;
+	modes << tr("One instrument per MIDI channel") << tr("One instrument per track");
+	bool ok = false;
+	QString mode = QInputDialog::getItem(this, tr("Import MIDI File"), tr("Instrument numbers:"),
+										 modes, 0, false, &ok);
+	if (!ok) {
+		return;
+	}
+	MidiFile file;
+	if (!file.load(fileName)) {
+		QMessageBox::warning(this, tr("Import MIDI File"),
+							 tr("Could not read %1:\n%2").arg(fileName).arg(file.errorString()));
+		return;
+	}
+	importNotes(file.notes(), mode == modes[1]);
+}
+
 void EventSheet::contextMenuEvent (QContextMenuEvent * event)
 {
 	//  qDebug() << "EventSheet::contextMenuEvent";
@@ -1112,6 +1200,8 @@ void EventSheet::contextMenuEvent (QContextMenuEvent * event)
 	menu.addAction(appendRowsAct);
 	menu.addAction(deleteColumnAct);
 	menu.addAction(deleteRowAct);
+	menu.addSeparator();
+	menu.addAction(importMidiAct);
 	menu.exec(event->globalPos());
 }
 
@@ -1356,6 +1446,46 @@ void EventSheet::fill(double start, double end, double slope)
 	markHistory();
 }
 
+// Replaces the sheet with one "i" line per note: instrument, start, duration,
+// key and velocity, times in seconds.
+// The rows are filled in a single pass with the table's signals blocked, so
+// files with many thousands of notes don't go through cellChangedSlot and a
+// view update for every cell.
+void EventSheet::importNotes(const QVector<MidiFile::Note> &notes, bool instrumentPerTrack)
+{
+	while (this->columnCount() < 6) {
+		appendColumn();
+	}
+	this->setUpdatesEnabled(false);
+	this->clearContents();
+	this->setRowCount(qMax(notes.size(), 1));
+	this->blockSignals(true);
+	this->model()->blockSignals(true);
+	for (int row = 0; row < notes.size(); row++) {
+		const MidiFile::Note &note = notes[row];
+		QVariant values[6] = {
+			QString("i"),
+			QString::number(instrumentPerTrack ? note.track + 1 : note.channel + 1),
+			QString::number(note.start, 'g', 10),
+			QString::number(note.duration, 'g', 10),
+			QString::number(note.key),
+			QString::number(note.velocity)
+		};
+		for (int column = 0; column < 6; column++) {
+			QTableWidgetItem *item = new QTableWidgetItem();
+			item->setData(Qt::DisplayRole, values[column]);
+			this->setItem(row, column, item);
+		}
+	}
+	this->model()->blockSignals(false);
+	this->blockSignals(false);
+	this->setUpdatesEnabled(true);
+	// The model was silent while filling, so repaint from it
+	this->viewport()->update();
+	markHistory();
+	emit modified();
+}
+
 void EventSheet::createActions()
 {
 	// For some reason, the shortcuts set here have no effect and need to be
@@ -1496,6 +1626,11 @@ void EventSheet::createActions()
 	deleteRowAct->setIconText(tr("Delete Rows"));
 	connect(deleteRowAct, SIGNAL(triggered()), this, SLOT(deleteRows()));
 
+	importMidiAct = new QAction(tr("Import MIDI File..."), this);
+	importMidiAct->setStatusTip(tr("Replace the sheet with the notes from a Standard MIDI File"));
+	importMidiAct->setIconText(tr("Import MIDI"));
+	connect(importMidiAct, SIGNAL(triggered()), this, SLOT(importMidiFile()));
+
 	stopScriptAct = new QAction(/*QIcon(":/a.png"),*/ tr("Stop running script"), this);
 	//  stopScriptAct->setStatusTip(tr("Delete Rows"));
 	//  stopScriptAct->setIconText(tr("Delete Rows"));
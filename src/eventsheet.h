@@ -28,6 +28,8 @@
 #include <QAction>
 #include <QTimer>
 
+#include "midifile.h"
+
 class EventSheet : public QTableWidget
 {
 	Q_OBJECT
@@ -69,6 +71,8 @@ public slots:
 	void redo();
 	void markHistory();
 	void clearHistory();
+	void trimHistory(); // Keep only the current state
+	qint64 historyMemoryUsage();
 	void setScriptDirectory(QString dir);
 
 	void subtract();
@@ -92,12 +96,16 @@ public slots:
 	void deleteColumn();
 	void deleteRows();
 
+	void importMidiFile();
+
 protected:
 	void contextMenuEvent(QContextMenuEvent * event);
 	virtual void keyPressEvent(QKeyEvent * event);
 
 private:
 	void createActions();
+	double currentTempo(); // Of the received MIDI clock when syncing
+	int msecsToLoopStart(bool restart);
 	QList<QPair<QString, QString> > parseLine(QString line);
 	bool m_stopScript;  // Order stopping python script
 
@@ -109,6 +117,7 @@ private:
 	void shuffle(int iterations);
 	void rotate(int amount);
 	void fill(double start, double end, double slope);
+	void importNotes(const QVector<MidiFile::Note> &notes, bool instrumentPerTrack);
 
 	void runScript(QString script);
 	QString generateDataText(QString outFileName);
@@ -149,6 +158,7 @@ private:
 	QAction *appendRowsAct;
 	QAction *deleteColumnAct;
 	QAction *deleteRowAct;
+	QAction *importMidiAct;
 
 	QStringList columnNames;
 
@@ -0,0 +1,121 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef GRAPHBUFFER_H
+#define GRAPHBUFFER_H
+
+#include <atomic>
+#include <cstring>
+
+#include "types.h"
+
+class Curve;
+
+struct GraphFrame {
+	MYFLT *data;
+	int npts;
+	MYFLT max, min, absmax;
+};
+
+//
+// Latest frame of a Csound graph window (display, dispfft, ftable graphs).
+// The performance thread copies each frame into a free buffer and publishes
+// it with a single atomic exchange, the GUI takes the newest published one.
+// Frames published faster than the GUI reads them replace each other instead
+// of queueing, and nothing is allocated after construction.
+// There are three buffers so that neither side ever waits or sees the one
+// the other is using. There must be a single writer and a single reader.
+//
+class GraphBuffer
+{
+public:
+	GraphBuffer(Curve *curve, int capacity)
+		: nextPending(nullptr), firstOfCurve(false), m_curve(curve), m_capacity(capacity),
+		  m_back(1), m_front(2), m_dropped(0)
+	{
+		for (int i = 0; i < 3; i++) {
+			m_frames[i].data = new MYFLT[capacity];
+			m_frames[i].npts = 0;
+			m_frames[i].max = m_frames[i].min = m_frames[i].absmax = 0;
+		}
+		m_middle.store(0, std::memory_order_relaxed);
+	}
+	~GraphBuffer()
+	{
+		for (int i = 0; i < 3; i++) {
+			delete[] m_frames[i].data;
+		}
+	}
+
+	Curve *curve() { return m_curve; }
+	int capacity() { return m_capacity; }
+	quint64 droppedFrames() { return m_dropped.load(std::memory_order_relaxed); }
+	qint64 memoryUsage() { return sizeof(GraphBuffer) + 3 * (qint64) m_capacity * sizeof(MYFLT); }
+
+	// Performance thread. Fails if the window is larger than the buffers
+	bool write(const WINDAT *windat)
+	{
+		if (windat->npts > m_capacity) {
+			return false;
+		}
+		GraphFrame &frame = m_frames[m_back];
+		memcpy(frame.data, windat->fdata, windat->npts * sizeof(MYFLT));
+		frame.npts = windat->npts;
+		frame.max = windat->max;
+		frame.min = windat->min;
+		frame.absmax = windat->absmax;
+		int previous = m_middle.exchange(m_back | Fresh, std::memory_order_acq_rel);
+		if (previous & Fresh) {
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+		m_back = previous & Index;
+		return true;
+	}
+
+	// GUI thread. The newest frame, or nullptr if none was written since the last call
+	const GraphFrame *read()
+	{
+		if (!(m_middle.load(std::memory_order_relaxed) & Fresh)) {
+			return nullptr;
+		}
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & Index;
+		return &m_frames[m_front];
+	}
+
+	// Links the buffers created by the performance thread until the GUI
+	// registers them (WidgetLayout::appendCurve)
+	GraphBuffer *nextPending;
+	bool firstOfCurve; // Not a larger buffer replacing one of the same curve
+
+private:
+	enum { Index = 3, Fresh = 4 };
+
+	Curve *m_curve;
+	int m_capacity;
+	GraphFrame m_frames[3];
+	int m_back;   // Owned by the writer
+	int m_front;  // Owned by the reader
+	std::atomic<int> m_middle; // Index of the last published frame, | Fresh until read
+	std::atomic<quint64> m_dropped;
+};
+
+#endif // GRAPHBUFFER_H
@@ -23,6 +23,8 @@
 #include "highlighter.h"
 
 #include <QDebug>
+#include <QTextBlock>
+#include <QTextLayout>
 
 TextBlockData::TextBlockData()
 {
@@ -225,6 +227,30 @@ void Highlighter::setMode(int mode)
 	m_mode = mode;
 }
 
+qint64 Highlighter::memoryUsage()
+{
+	qint64 bytes = 0;
+	QTextDocument *doc = document();
+	if (doc == 0) {
+		return 0;
+	}
+	for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+		if (block.layout() != 0) {
+#ifdef USE_QT_GT_55
+			bytes += block.layout()->formats().size() * sizeof(QTextLayout::FormatRange);
+#else
+			bytes += block.layout()->additionalFormats().size() * sizeof(QTextLayout::FormatRange);
+#endif
+		}
+		TextBlockData *data = static_cast<TextBlockData *>(block.userData());
+		if (data != 0) {
+			bytes += sizeof(TextBlockData)
+					+ data->parentheses().size() * (sizeof(ParenthesisInfo) + sizeof(void *));
+		}
+	}
+	return bytes;
+}
+
 
 void Highlighter::setColorVariables(bool color)
 {
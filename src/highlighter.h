@@ -62,6 +62,7 @@ public:
 	void setOpcodeNameList(QStringList list);
 	void setColorVariables(bool color);
 	void setMode(int mode);
+	qint64 memoryUsage(); // Approximate bytes held for formats and block data
 
 	// for html
 	enum Construct {
@@ -0,0 +1,145 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef HOSTINPUT_H
+#define HOSTINPUT_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Key events kept for Csound, must be a power of two
+#define QCS_KEY_RING_SIZE 256
+
+//
+// Keyboard and mouse state passed from the GUI thread to the performance
+// thread without locks. The pointer position is stored in one word, but
+// x() and y() load it separately, as Csound reads _MouseX and _MouseY in
+// separate invalue calls anyway. Buttons and modifiers share one word, and key
+// events go through single producer, single consumer rings. When a ring
+// is full new keys are dropped.
+//
+class HostInput
+{
+public:
+	enum Button {
+		LeftButton = 1,
+		RightButton = 2
+	};
+	enum Modifier {  // Read from _KeyModifiers
+		ShiftModifier = 1,
+		ControlModifier = 2,
+		AltModifier = 4,
+		MetaModifier = 8
+	};
+
+	HostInput() : m_position(0), m_relPosition(0), m_state(0), m_lastKey(0), m_keyDown(false) {}
+
+	// GUI thread
+	void setPosition(int x, int y, int relX, int relY)
+	{
+		m_position.store(pack(x, y), std::memory_order_relaxed);
+		m_relPosition.store(pack(relX, relY), std::memory_order_relaxed);
+	}
+	void setButton(int button, bool down)
+	{
+		quint32 state = m_state.load(std::memory_order_relaxed);
+		m_state.store(down ? state | button : state & ~(quint32) button, std::memory_order_relaxed);
+	}
+	void setModifiers(int modifiers)
+	{
+		quint32 state = m_state.load(std::memory_order_relaxed);
+		m_state.store((state & 0xFF) | (modifiers << 8), std::memory_order_relaxed);
+	}
+	void pushKeyPress(int key) { m_presses.push(key); }
+	void pushKeyRelease(int key) { m_releases.push(key); }
+	void setLastKey(int key, bool down)
+	{
+		m_lastKey.store(key, std::memory_order_relaxed);
+		m_keyDown.store(down, std::memory_order_relaxed);
+	}
+	void setKeyUp() { m_keyDown.store(false, std::memory_order_relaxed); }
+
+	// Any thread
+	int x() { return unpackX(m_position.load(std::memory_order_relaxed)); }
+	int y() { return unpackY(m_position.load(std::memory_order_relaxed)); }
+	int relX() { return unpackX(m_relPosition.load(std::memory_order_relaxed)); }
+	int relY() { return unpackY(m_relPosition.load(std::memory_order_relaxed)); }
+	bool button(int button) { return m_state.load(std::memory_order_relaxed) & button; }
+	int modifiers() { return m_state.load(std::memory_order_relaxed) >> 8; }
+	int lastKey() { return m_lastKey.load(std::memory_order_relaxed); }
+	bool keyDown() { return m_keyDown.load(std::memory_order_relaxed); }
+
+	// Performance thread, -1 when there are no keys. clearKeys() can also be
+	// called while the performance thread is not running
+	int popKeyPress() { return m_presses.pop(); }
+	int popKeyRelease() { return m_releases.pop(); }
+	void clearKeys()
+	{
+		m_presses.clear();
+		m_releases.clear();
+	}
+
+private:
+	class KeyRing
+	{
+	public:
+		KeyRing() : m_head(0), m_tail(0) {}
+		void push(int key)
+		{
+			quint32 head = m_head.load(std::memory_order_relaxed);
+			if (head - m_tail.load(std::memory_order_acquire) >= QCS_KEY_RING_SIZE) {
+				return;
+			}
+			m_keys[head & (QCS_KEY_RING_SIZE - 1)] = key;
+			m_head.store(head + 1, std::memory_order_release);
+		}
+		int pop()
+		{
+			quint32 tail = m_tail.load(std::memory_order_relaxed);
+			if (tail == m_head.load(std::memory_order_acquire)) {
+				return -1;
+			}
+			int key = m_keys[tail & (QCS_KEY_RING_SIZE - 1)];
+			m_tail.store(tail + 1, std::memory_order_release);
+			return key;
+		}
+		void clear() { m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+	private:
+		std::atomic<quint32> m_head;
+		std::atomic<quint32> m_tail;
+		int m_keys[QCS_KEY_RING_SIZE];
+	};
+
+	static quint64 pack(int x, int y) { return ((quint64) (quint32) x << 32) | (quint32) y; }
+	static int unpackX(quint64 position) { return (qint32) (position >> 32); }
+	static int unpackY(quint64 position) { return (qint32) (position & 0xFFFFFFFF); }
+
+	std::atomic<quint64> m_position;
+	std::atomic<quint64> m_relPosition;
+	std::atomic<quint32> m_state; // Buttons in the low byte, modifiers above
+	std::atomic<int> m_lastKey;
+	std::atomic<bool> m_keyDown;
+	KeyRing m_presses;
+	KeyRing m_releases;
+};
+
+#endif // HOSTINPUT_H
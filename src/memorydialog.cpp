@@ -0,0 +1,141 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#include "memorydialog.h"
+#include "documentpage.h"
+
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+
+MemoryDialog::MemoryDialog(QWidget *parent, QVector<DocumentPage *> *pages)
+	: QDialog(parent), m_pages(pages)
+{
+	setWindowTitle(tr("Memory Usage"));
+	QVBoxLayout *layout = new QVBoxLayout(this);
+	m_tree = new QTreeWidget(this);
+	m_tree->setColumnCount(2);
+	m_tree->setHeaderLabels(QStringList() << tr("Document") << tr("Size"));
+	m_tree->header()->setStretchLastSection(false);
+#ifdef USE_QT5
+	m_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+#endif
+	layout->addWidget(m_tree);
+	m_totalLabel = new QLabel(this);
+	layout->addWidget(m_totalLabel);
+
+	QHBoxLayout *buttons = new QHBoxLayout();
+	QPushButton *historyButton = new QPushButton(tr("Trim Undo History"), this);
+	historyButton->setToolTip(tr("Discard widget and live event undo history of all documents"));
+	connect(historyButton, SIGNAL(released()), this, SLOT(trimHistory()));
+	buttons->addWidget(historyButton);
+	QPushButton *consoleButton = new QPushButton(tr("Clear Consoles"), this);
+	connect(consoleButton, SIGNAL(released()), this, SLOT(clearConsoles()));
+	buttons->addWidget(consoleButton);
+	QPushButton *curvesButton = new QPushButton(tr("Release Graphs"), this);
+	curvesButton->setToolTip(tr("Free the tables and spectra kept from the last run "
+								"of documents that are not running"));
+	connect(curvesButton, SIGNAL(released()), this, SLOT(releaseCurves()));
+	buttons->addWidget(curvesButton);
+	buttons->addStretch();
+	QPushButton *closeButton = new QPushButton(tr("Close"), this);
+	connect(closeButton, SIGNAL(released()), this, SLOT(close()));
+	buttons->addWidget(closeButton);
+	layout->addLayout(buttons);
+
+	resize(480, 400);
+	connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+	m_refreshTimer.start(2000);
+	refresh();
+}
+
+void MemoryDialog::refresh()
+{
+	if (!isVisible() && m_tree->topLevelItemCount() > 0) {
+		return;
+	}
+	QStringList expanded;
+	for (int i = 0; i < m_tree->topLevelItemCount(); i++) {
+		if (m_tree->topLevelItem(i)->isExpanded()) {
+			expanded << m_tree->topLevelItem(i)->text(0);
+		}
+	}
+	m_tree->clear();
+	qint64 total = 0;
+	foreach (DocumentPage *page, *m_pages) {
+		QString name = page->getFileName();
+		name = name.isEmpty() ? tr("(Untitled)") : name.mid(name.lastIndexOf("/") + 1);
+		QTreeWidgetItem *docItem = new QTreeWidgetItem(m_tree, QStringList() << name);
+		qint64 docTotal = 0;
+		QList<QPair<QString, qint64> > usage = page->memoryUsage();
+		for (int i = 0; i < usage.size(); i++) {
+			QTreeWidgetItem *item = new QTreeWidgetItem(docItem);
+			item->setText(0, usage[i].first);
+			item->setText(1, formatBytes(usage[i].second));
+			item->setTextAlignment(1, Qt::AlignRight);
+			docTotal += usage[i].second;
+		}
+		docItem->setText(1, formatBytes(docTotal));
+		docItem->setTextAlignment(1, Qt::AlignRight);
+		docItem->setExpanded(expanded.contains(name) || m_pages->size() == 1);
+		total += docTotal;
+	}
+	m_totalLabel->setText(tr("Total: %1 in %2 documents").arg(formatBytes(total))
+						  .arg(m_pages->size()));
+}
+
+void MemoryDialog::trimHistory()
+{
+	foreach (DocumentPage *page, *m_pages) {
+		page->trimHistory();
+	}
+	refresh();
+}
+
+void MemoryDialog::clearConsoles()
+{
+	foreach (DocumentPage *page, *m_pages) {
+		page->clearConsoles();
+	}
+	refresh();
+}
+
+void MemoryDialog::releaseCurves()
+{
+	foreach (DocumentPage *page, *m_pages) {
+		page->releaseCurves();
+	}
+	refresh();
+}
+
+QString MemoryDialog::formatBytes(qint64 bytes)
+{
+	if (bytes >= 1024 * 1024) {
+		return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+	}
+	if (bytes >= 1024) {
+		return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+	}
+	return QString("%1 B").arg(bytes);
+}
@@ -0,0 +1,57 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#ifndef MEMORYDIALOG_H
+#define MEMORYDIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+
+class QTreeWidget;
+class QLabel;
+class DocumentPage;
+
+// Shows the memory held by each subsystem of every open document, and
+// offers to trim undo histories, consoles and graph curves.
+class MemoryDialog : public QDialog
+{
+	Q_OBJECT
+public:
+	MemoryDialog(QWidget *parent, QVector<DocumentPage *> *pages);
+
+public slots:
+	void refresh();
+
+private slots:
+	void trimHistory();
+	void clearConsoles();
+	void releaseCurves();
+
+private:
+	QVector<DocumentPage *> *m_pages;
+	QTreeWidget *m_tree;
+	QLabel *m_totalLabel;
+	QTimer m_refreshTimer;
+
+	static QString formatBytes(qint64 bytes);
+};
+
+#endif // MEMORYDIALOG_H
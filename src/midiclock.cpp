@@ -0,0 +1,259 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "midiclock.h"
+#include "midiqueue.h"
+
+#include <cmath>
+
+static const double twoPi = 6.283185307179586;
+static const double sqrt2 = 1.4142135623730951;
+
+MidiClock *MidiClock::instance()
+{
+	static MidiClock clock;
+	return &clock;
+}
+
+MidiClock::MidiClock() : m_source(-1), m_loopTicks(0), m_tickTime(0), m_nextTickTime(0),
+	m_period(0), m_arrival(0), m_position(-1), m_nextPosition(0), m_running(false),
+	m_bandwidth(1.0), m_sequence(0), m_sharedTickTime(0), m_sharedPeriod(0),
+	m_sharedPosition(-1), m_sharedArrival(0), m_sharedLocked(false), m_sharedRunning(false),
+	m_sendEnabled(false), m_sendTempo(120.0), m_output(nullptr), m_syncLoops(false)
+{
+}
+
+bool MidiClock::processMessage(const unsigned char *data, int size, int source, qint64 time)
+{
+	switch (data[0]) {
+	case 0xF8: // Clock
+		if (!follows(source, time)) {
+			return true;
+		}
+		tick(time);
+		return true;
+	case 0xFA: // Start, the next clock is the first beat
+		if (follows(source, time)) {
+			m_nextPosition = 0;
+			m_position = -1;
+			m_running = true;
+			publish();
+		}
+		return true;
+	case 0xFB: // Continue
+		if (follows(source, time)) {
+			m_running = true;
+			publish();
+		}
+		return true;
+	case 0xFC: // Stop
+		if (follows(source, time)) {
+			m_running = false;
+			publish();
+		}
+		return true;
+	case 0xF2: // Song Position Pointer, in sixteenth notes
+		if (size >= 3 && follows(source, time)) {
+			m_nextPosition = (((int) data[2] << 7) | data[1]) * (QCS_MIDI_CLOCK_PPQN / 4);
+			m_position = m_nextPosition - 1;
+			publish();
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Takes the first port that sends, and another one only when that one has
+// gone silent
+bool MidiClock::follows(int source, qint64 time)
+{
+	if (source == m_source) {
+		return true;
+	}
+	if (m_source >= 0 && time - m_arrival < QCS_MIDI_CLOCK_TIMEOUT) {
+		return false;
+	}
+	m_source = source;
+	m_loopTicks = 0;
+	return true;
+}
+
+void MidiClock::tick(qint64 time)
+{
+	double error = time - m_nextTickTime;
+	if (m_loopTicks == 0 || time - m_arrival > QCS_MIDI_CLOCK_TIMEOUT
+			|| (m_loopTicks > 1 && std::fabs(error) > m_period)) {
+		// (Re)start the loop, the tempo is known on the next tick
+		m_loopTicks = 1;
+		m_tickTime = time;
+	}
+	else if (m_loopTicks == 1) {
+		m_period = time - m_tickTime;
+		m_tickTime = time;
+		m_nextTickTime = time + m_period;
+		m_loopTicks = m_period > 0 ? 2 : 1;
+	}
+	else {
+		// Critically damped second order loop, with the coefficients given
+		// by the bandwidth relative to the tick rate
+		double omega = twoPi * m_bandwidth.load(std::memory_order_relaxed) * m_period * 1e-9;
+		omega = qMin(omega, 1.0);
+		m_tickTime = m_nextTickTime;
+		m_nextTickTime += sqrt2 * omega * error + m_period;
+		m_period += omega * omega * error;
+		m_loopTicks++;
+	}
+	m_arrival = time;
+	if (m_running) {
+		m_position = m_nextPosition++;
+	}
+	publish();
+}
+
+void MidiClock::publish()
+{
+	quint64 sequence = m_sequence.load(std::memory_order_relaxed);
+	m_sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_sharedTickTime.store(m_tickTime, std::memory_order_relaxed);
+	m_sharedPeriod.store(m_period, std::memory_order_relaxed);
+	m_sharedPosition.store(m_position, std::memory_order_relaxed);
+	m_sharedArrival.store(m_arrival, std::memory_order_relaxed);
+	m_sharedLocked.store(m_loopTicks > 1, std::memory_order_relaxed);
+	m_sharedRunning.store(m_running, std::memory_order_relaxed);
+	m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void MidiClock::state(State &state)
+{
+	while (true) {
+		quint64 sequence = m_sequence.load(std::memory_order_acquire);
+		state.tickTime = m_sharedTickTime.load(std::memory_order_relaxed);
+		state.period = m_sharedPeriod.load(std::memory_order_relaxed);
+		state.position = m_sharedPosition.load(std::memory_order_relaxed);
+		state.arrival = m_sharedArrival.load(std::memory_order_relaxed);
+		state.locked = m_sharedLocked.load(std::memory_order_relaxed);
+		state.running = m_sharedRunning.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (!(sequence & 1) && m_sequence.load(std::memory_order_relaxed) == sequence) {
+			return;
+		}
+	}
+}
+
+bool MidiClock::isLocked(qint64 time)
+{
+	State s;
+	state(s);
+	return s.locked && time - s.arrival < QCS_MIDI_CLOCK_TIMEOUT;
+}
+
+bool MidiClock::isRunning(qint64 time)
+{
+	State s;
+	state(s);
+	return s.locked && s.running && time - s.arrival < QCS_MIDI_CLOCK_TIMEOUT;
+}
+
+double MidiClock::tempo(qint64 time)
+{
+	State s;
+	state(s);
+	if (!s.locked || time - s.arrival >= QCS_MIDI_CLOCK_TIMEOUT) {
+		return 0.0;
+	}
+	return 60e9 / (s.period * QCS_MIDI_CLOCK_PPQN);
+}
+
+double MidiClock::beat(qint64 time)
+{
+	State s;
+	state(s);
+	double position = s.position;
+	if (s.locked && s.running && time - s.arrival < QCS_MIDI_CLOCK_TIMEOUT) {
+		// Interpolated up to the next tick, which may be late
+		position += qBound(0.0, (time - s.tickTime) / s.period, 1.0);
+	}
+	return qMax(position, 0.0) / QCS_MIDI_CLOCK_PPQN;
+}
+
+qint64 MidiClock::nextBeatTime(qint64 time, double beats)
+{
+	State s;
+	state(s);
+	if (!s.locked || !s.running || time - s.arrival >= QCS_MIDI_CLOCK_TIMEOUT || beats <= 0) {
+		return -1;
+	}
+	double position = s.position + qBound(0.0, (time - s.tickTime) / s.period, 1.0);
+	double clocks = beats * QCS_MIDI_CLOCK_PPQN;
+	double next = (std::floor(position / clocks + 1e-6) + 1.0) * clocks;
+	return (qint64) (s.tickTime + (next - s.position) * s.period);
+}
+
+bool MidiClock::claimOutput(const void *engine)
+{
+	const void *expected = nullptr;
+	return m_output.compare_exchange_strong(expected, engine) || expected == engine;
+}
+
+void MidiClock::releaseOutput(const void *engine)
+{
+	const void *expected = engine;
+	m_output.compare_exchange_strong(expected, nullptr);
+}
+
+bool MidiClockSender::process(MidiQueue *queue, qint64 time, int frames, int sampleRate,
+							  double tempo)
+{
+	static const unsigned char start = 0xFA;
+	static const unsigned char clock = 0xF8;
+	bool queued = false;
+	if (!m_started) {
+		queue->push(&start, 1, time);
+		m_started = true;
+		m_phase = 0.0;
+		queued = true;
+	}
+	double clocksPerFrame = tempo * QCS_MIDI_CLOCK_PPQN / (60.0 * sampleRate);
+	if (clocksPerFrame <= 0.0) {
+		return queued;
+	}
+	double end = m_phase + frames * clocksPerFrame;
+	// Each clock is stamped with its own position inside the k-cycle
+	for (double next = std::ceil(m_phase); next < end; next += 1.0) {
+		double offset = (next - m_phase) / clocksPerFrame;
+		queue->push(&clock, 1, time + (qint64) (offset * 1e9 / sampleRate));
+		queued = true;
+	}
+	m_phase = end;
+	return queued;
+}
+
+void MidiClockSender::stop(MidiQueue *queue, qint64 time)
+{
+	static const unsigned char stop = 0xFC;
+	if (m_started) {
+		queue->push(&stop, 1, time);
+	}
+	reset();
+}
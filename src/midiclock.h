@@ -0,0 +1,142 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef MIDICLOCK_H
+#define MIDICLOCK_H
+
+#include <QtGlobal>
+#include <atomic>
+
+class MidiQueue;
+
+// Clocks per quarter note
+#define QCS_MIDI_CLOCK_PPQN 24
+// The received clock is lost after this long without ticks, in nanoseconds (about 5 BPM)
+#define QCS_MIDI_CLOCK_TIMEOUT 500000000LL
+
+//
+// Follows the MIDI clock and transport (Start, Continue, Stop and Song
+// Position Pointer) received on the MIDI in ports. Tick arrival times jitter
+// by a millisecond or more, so they go through a second order delay locked
+// loop, which gives a smoothed tempo and tick times that can be interpolated
+// between ticks. Only one port is followed, until its clock stops.
+// It also holds the settings for sending clock, which is generated by the
+// engines from their sample clock (see MidiClockSender).
+// The state is written by the MIDI input threads and read lock-free from
+// any thread. Times are in MidiQueue::now() time.
+//
+class MidiClock
+{
+public:
+	static MidiClock *instance();
+
+	// Called from the MIDI input threads, one at a time. Returns true for
+	// clock and transport messages
+	bool processMessage(const unsigned char *data, int size, int source, qint64 time);
+	// Lower bandwidths are smoother but slower to follow tempo changes
+	void setBandwidth(double hz) { m_bandwidth.store(hz, std::memory_order_relaxed); }
+
+	bool isLocked(qint64 time);  // Receiving clock
+	bool isRunning(qint64 time); // Locked, and started or continued
+	double tempo(qint64 time);   // In beats per minute, 0 when not locked
+	double beat(qint64 time);    // Song position in quarter notes
+	// Time of the next multiple of beats in the song position, -1 when not running
+	qint64 nextBeatTime(qint64 time, double beats);
+
+	void setSendEnabled(bool enabled) { m_sendEnabled.store(enabled, std::memory_order_relaxed); }
+	bool sendEnabled() { return m_sendEnabled.load(std::memory_order_relaxed); }
+	void setSendTempo(double bpm) { m_sendTempo.store(bpm, std::memory_order_relaxed); }
+	double sendTempo() { return m_sendTempo.load(std::memory_order_relaxed); }
+	// Only one engine sends clock at a time
+	bool claimOutput(const void *engine);
+	void releaseOutput(const void *engine);
+
+	// Whether the event sheet loops follow the received clock
+	void setSyncLoops(bool sync) { m_syncLoops.store(sync, std::memory_order_relaxed); }
+	bool syncLoops() { return m_syncLoops.load(std::memory_order_relaxed); }
+
+private:
+	MidiClock();
+
+	struct State {
+		double tickTime; // Smoothed time of the last tick
+		double period;   // Smoothed time between ticks
+		qint64 position; // Clocks since the start of the song, at the last tick
+		qint64 arrival;  // Of the last tick
+		bool locked;
+		bool running;
+	};
+
+	void tick(qint64 time);
+	bool follows(int source, qint64 time);
+	void publish();
+	void state(State &state);
+
+	// Only used by the input threads
+	int m_source; // Port followed, -1 for none
+	int m_loopTicks; // Ticks since the loop was (re)started
+	double m_tickTime;
+	double m_nextTickTime; // Predicted
+	double m_period;
+	qint64 m_arrival;
+	qint64 m_position;
+	qint64 m_nextPosition;
+	bool m_running;
+	std::atomic<double> m_bandwidth;
+
+	// Published state, a seqlock as in MidiQueue
+	std::atomic<quint64> m_sequence;
+	std::atomic<double> m_sharedTickTime;
+	std::atomic<double> m_sharedPeriod;
+	std::atomic<qint64> m_sharedPosition;
+	std::atomic<qint64> m_sharedArrival;
+	std::atomic<bool> m_sharedLocked;
+	std::atomic<bool> m_sharedRunning;
+
+	std::atomic<bool> m_sendEnabled;
+	std::atomic<double> m_sendTempo;
+	std::atomic<const void *> m_output;
+	std::atomic<bool> m_syncLoops;
+};
+
+//
+// Generates MIDI clock from an engine's sample clock, so the ticks are as
+// steady as the audio. Only used from the performance thread.
+//
+class MidiClockSender
+{
+public:
+	MidiClockSender() : m_started(false), m_phase(0.0) {}
+
+	void reset() { m_started = false; m_phase = 0.0; }
+	bool isStarted() { return m_started; }
+	// Queues Start on the first call, then the clocks that fall in the
+	// k-cycle of frames starting at time. Returns true if anything was queued
+	bool process(MidiQueue *queue, qint64 time, int frames, int sampleRate, double tempo);
+	void stop(MidiQueue *queue, qint64 time); // Queues Stop
+
+private:
+	bool m_started;
+	double m_phase; // Clocks sent, at the start of the next k-cycle
+};
+
+#endif // MIDICLOCK_H
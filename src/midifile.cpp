@@ -0,0 +1,443 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "midifile.h"
+
+#include <QFile>
+#include <QObject>
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+static quint32 readBigEndian(const unsigned char *data, int bytes)
+{
+	quint32 value = 0;
+	for (int i = 0; i < bytes; i++) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+static bool readVarLen(const unsigned char *data, int size, int &pos, quint32 &value)
+{
+	value = 0;
+	for (int i = 0; i < 4; i++) {
+		if (pos >= size) {
+			return false;
+		}
+		unsigned char byte = data[pos++];
+		value = (value << 7) | (byte & 0x7F);
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+MidiFile::MidiFile() : m_format(0), m_division(96), m_duration(0)
+{
+}
+
+bool MidiFile::load(QString fileName)
+{
+	m_fileName = fileName;
+	m_error.clear();
+	m_trackNames.clear();
+	m_events.clear();
+	m_data.clear();
+	m_duration = 0;
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		setError(file.errorString());
+		return false;
+	}
+	QByteArray contents = file.readAll();
+	const unsigned char *bytes = (const unsigned char *) contents.constData();
+	int size = contents.size();
+	if (size < 14 || memcmp(bytes, "MThd", 4) != 0 || readBigEndian(bytes + 4, 4) < 6) {
+		setError(QObject::tr("Not a Standard MIDI File"));
+		return false;
+	}
+	m_format = readBigEndian(bytes + 8, 2);
+	m_division = readBigEndian(bytes + 12, 2);
+	if (m_division == 0) {
+		setError(QObject::tr("Invalid time division"));
+		return false;
+	}
+
+	// Every event is at least 3 bytes in the file, and gains at most one
+	// byte when running status is expanded
+	m_events.reserve(size / 3);
+	m_data.reserve(size + size / 3);
+	QVector<qint64> ticks;
+	ticks.reserve(size / 3);
+	QVector<TempoChange> tempos;
+	qint64 endTick = 0;
+	int pos = 8 + readBigEndian(bytes + 4, 4);
+	while (pos + 8 <= size) {
+		quint32 length = readBigEndian(bytes + pos + 4, 4);
+		if (length > (quint32) (size - pos - 8)) {
+			setError(QObject::tr("Truncated chunk"));
+			return false;
+		}
+		if (memcmp(bytes + pos, "MTrk", 4) == 0) {
+			qint64 trackEnd = 0;
+			if (!parseTrack(bytes + pos + 8, length, m_trackNames.size(), ticks, tempos, trackEnd)) {
+				return false;
+			}
+			endTick = qMax(endTick, trackEnd);
+		}
+		pos += 8 + length; // Other chunks are skipped
+	}
+
+	// Merge the tracks. The sort is stable, so events at the same tick keep
+	// the track and file order
+	QVector<int> order(m_events.size());
+	for (int i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+					 [&ticks](int a, int b) { return ticks[a] < ticks[b]; });
+	std::stable_sort(tempos.begin(), tempos.end(),
+					 [](const TempoChange &a, const TempoChange &b) { return a.tick < b.tick; });
+
+	// Resolve times through the tempo map in one pass
+	double secondsPerTick;
+	if (m_division & 0x8000) { // SMPTE frames per second and ticks per frame
+		int framesPerSecond = -(qint8) (m_division >> 8);
+		secondsPerTick = 1.0 / (framesPerSecond * (m_division & 0xFF));
+		tempos.clear();
+	}
+	else {
+		secondsPerTick = 0.5 / m_division; // 120 BPM until the first tempo change
+	}
+	int tempoIndex = 0;
+	qint64 segmentTick = 0;
+	double segmentTime = 0;
+	auto ticksToSeconds = [&](qint64 tick) {
+		while (tempoIndex < tempos.size() && tempos[tempoIndex].tick <= tick) {
+			segmentTime += (tempos[tempoIndex].tick - segmentTick) * secondsPerTick;
+			segmentTick = tempos[tempoIndex].tick;
+			secondsPerTick = tempos[tempoIndex].secondsPerTick;
+			tempoIndex++;
+		}
+		return segmentTime + (tick - segmentTick) * secondsPerTick;
+	};
+	QVector<Event> sorted(m_events.size());
+	for (int i = 0; i < order.size(); i++) {
+		sorted[i] = m_events[order[i]];
+		sorted[i].time = ticksToSeconds(ticks[order[i]]);
+	}
+	m_events.swap(sorted);
+	m_duration = ticksToSeconds(endTick);
+	return true;
+}
+
+bool MidiFile::parseTrack(const unsigned char *data, int size, int track, QVector<qint64> &ticks,
+						  QVector<TempoChange> &tempos, qint64 &endTick)
+{
+	QString name;
+	int pos = 0;
+	qint64 tick = 0;
+	unsigned char running = 0;
+	while (pos < size) {
+		quint32 delta, length;
+		if (!readVarLen(data, size, pos, delta) || pos >= size) {
+			setError(QObject::tr("Truncated track %1").arg(track + 1));
+			return false;
+		}
+		tick += delta;
+		unsigned char status = data[pos];
+		if (status & 0x80) {
+			pos++;
+		}
+		else if (running != 0) {
+			status = running;
+		}
+		else {
+			setError(QObject::tr("Data without status in track %1").arg(track + 1));
+			return false;
+		}
+		if (status == 0xFF) { // Meta event
+			unsigned char type = pos < size ? data[pos++] : 0;
+			if (!readVarLen(data, size, pos, length) || length > (quint32) (size - pos)) {
+				setError(QObject::tr("Truncated meta event in track %1").arg(track + 1));
+				return false;
+			}
+			if (type == 0x51 && length == 3 && !(m_division & 0x8000)) {
+				TempoChange tempo;
+				tempo.tick = tick;
+				tempo.secondsPerTick = readBigEndian(data + pos, 3) / (1e6 * m_division);
+				tempos.append(tempo);
+			}
+			else if (type == 0x03 && name.isEmpty()) {
+				name = QString::fromLatin1((const char *) data + pos, length);
+			}
+			pos += length;
+			running = 0;
+			if (type == 0x2F) { // End of track
+				break;
+			}
+			continue;
+		}
+		if (status == 0xF0 || status == 0xF7) { // SysEx, or escaped bytes sent as they are
+			if (!readVarLen(data, size, pos, length) || length > (quint32) (size - pos)) {
+				setError(QObject::tr("Truncated SysEx in track %1").arg(track + 1));
+				return false;
+			}
+			int eventSize = length + (status == 0xF0 ? 1 : 0);
+			if (eventSize > 0) {
+				Event event;
+				event.offset = m_data.size();
+				event.size = eventSize;
+				event.track = track;
+				if (status == 0xF0) {
+					m_data.append((char) status);
+				}
+				m_data.append((const char *) data + pos, length);
+				m_events.append(event);
+				ticks.append(tick);
+			}
+			pos += length;
+			running = 0;
+			continue;
+		}
+		if (status > 0xF0) {
+			setError(QObject::tr("Unexpected status %1 in track %2").arg(status, 0, 16).arg(track + 1));
+			return false;
+		}
+		running = status;
+		int dataBytes = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+		if (pos + dataBytes > size) {
+			setError(QObject::tr("Truncated track %1").arg(track + 1));
+			return false;
+		}
+		Event event;
+		event.offset = m_data.size();
+		event.size = dataBytes + 1;
+		event.track = track;
+		m_data.append((char) status);
+		m_data.append((const char *) data + pos, dataBytes);
+		m_events.append(event);
+		ticks.append(tick);
+		pos += dataBytes;
+	}
+	m_trackNames.append(name);
+	endTick = tick;
+	return true;
+}
+
+int MidiFile::indexAt(double seconds) const
+{
+	Event key;
+	key.time = seconds;
+	return std::lower_bound(m_events.constBegin(), m_events.constEnd(), key,
+							[](const Event &a, const Event &b) { return a.time < b.time; })
+			- m_events.constBegin();
+}
+
+QVector<MidiFile::Note> MidiFile::notes() const
+{
+	QVector<Note> notes;
+	notes.reserve(m_events.size() / 2);
+	// Index in notes of the sounding note for each track, channel and key
+	QVector<int> sounding(trackCount() * 16 * 128, -1);
+	for (int i = 0; i < m_events.size(); i++) {
+		const Event &event = m_events[i];
+		const unsigned char *bytes = data(event);
+		int type = bytes[0] & 0xF0;
+		if (event.size != 3 || (type != 0x80 && type != 0x90)) {
+			continue;
+		}
+		int channel = bytes[0] & 0x0F;
+		int &slot = sounding[(event.track * 16 + channel) * 128 + (bytes[1] & 0x7F)];
+		if (slot >= 0) { // Note off, or a new note on the same key
+			notes[slot].duration = event.time - notes[slot].start;
+			slot = -1;
+		}
+		if (type == 0x90 && bytes[2] != 0) {
+			Note note;
+			note.start = event.time;
+			note.duration = 0;
+			note.track = event.track;
+			note.channel = channel;
+			note.key = bytes[1] & 0x7F;
+			note.velocity = bytes[2] & 0x7F;
+			slot = notes.size();
+			notes.append(note);
+		}
+	}
+	for (int i = 0; i < sounding.size(); i++) {
+		if (sounding[i] >= 0) {
+			notes[sounding[i]].duration = m_duration - notes[sounding[i]].start;
+		}
+	}
+	return notes;
+}
+
+void MidiFile::setError(QString error)
+{
+	m_error = error;
+	qDebug() << "MidiFile::load" << m_fileName << error;
+}
+
+MidiFilePlayer::MidiFilePlayer() : m_file(nullptr), m_reading(false), m_playing(false),
+	m_loop(false), m_seek(-1.0), m_position(0), m_index(0), m_startSample(0),
+	m_wasPlaying(false), m_releaseChannel(16)
+{
+	memset(m_sounding, 0, sizeof(m_sounding));
+}
+
+void MidiFilePlayer::setFile(QSharedPointer<MidiFile> file)
+{
+	m_playing.store(false);
+	m_file.store(nullptr);
+	// The old file can only be released once read() has stopped using it
+	while (m_reading.load()) {
+		QThread::yieldCurrentThread();
+	}
+	m_fileRef = file;
+	m_position.store(0, std::memory_order_relaxed);
+	m_file.store(file.data());
+}
+
+void MidiFilePlayer::play()
+{
+	double position = m_position.load(std::memory_order_relaxed);
+	if (m_fileRef.isNull() || position >= m_fileRef->duration()) {
+		position = 0;
+	}
+	m_seek.store(position);
+	m_playing.store(true);
+}
+
+void MidiFilePlayer::stop()
+{
+	m_playing.store(false);
+}
+
+void MidiFilePlayer::seek(double seconds)
+{
+	seconds = qMax(0.0, seconds);
+	m_position.store(seconds, std::memory_order_relaxed);
+	m_seek.store(seconds);
+}
+
+int MidiFilePlayer::read(qint64 sample, int ksmps, double sampleRate, unsigned char *buf, int nBytes)
+{
+	m_reading.store(true);
+	const MidiFile *file = m_file.load();
+	bool playing = m_playing.load(std::memory_order_relaxed) && file != nullptr;
+	double seek = m_seek.exchange(-1.0, std::memory_order_relaxed);
+	if (seek >= 0 && file != nullptr) {
+		m_index = file->indexAt(seek);
+		m_startSample = sample - (qint64) (seek * sampleRate + 0.5);
+		m_releaseChannel = 0;
+	}
+	if (m_wasPlaying && !playing) {
+		m_releaseChannel = 0;
+	}
+	m_wasPlaying = playing;
+	// Sounding notes are turned off before anything else is passed. This can
+	// take a few calls if Csound's buffer is small
+	int count = releaseNotes(buf, nBytes);
+	if (!playing || m_releaseChannel < 16) {
+		m_reading.store(false, std::memory_order_release);
+		return count;
+	}
+	qint64 end = sample + ksmps;
+	qint64 length = (qint64) (file->duration() * sampleRate + 0.5);
+	while (true) {
+		if (m_index >= file->eventCount()) {
+			if (m_startSample + length >= end) {
+				break; // Not at the end of the file yet
+			}
+			if (m_loop.load(std::memory_order_relaxed) && length > 0) {
+				m_startSample += length;
+				m_index = 0;
+				m_releaseChannel = 0;
+				count += releaseNotes(buf + count, nBytes - count);
+				if (m_releaseChannel < 16) {
+					break;
+				}
+				continue;
+			}
+			m_playing.store(false, std::memory_order_relaxed);
+			break;
+		}
+		const MidiFile::Event &event = file->event(m_index);
+		if (m_startSample + (qint64) (event.time * sampleRate + 0.5) >= end) {
+			break;
+		}
+		int eventSize = (int) event.size;
+		if (eventSize > nBytes - count) {
+			if (eventSize > nBytes) { // Can never fit in Csound's buffer
+				m_index++;
+				continue;
+			}
+			break; // Next call
+		}
+		const unsigned char *bytes = file->data(event);
+		memcpy(buf + count, bytes, eventSize);
+		count += eventSize;
+		int type = bytes[0] & 0xF0;
+		if (eventSize == 3 && (type == 0x80 || type == 0x90)) {
+			int channel = bytes[0] & 0x0F;
+			int key = bytes[1] & 0x7F;
+			quint64 bit = Q_UINT64_C(1) << (key & 63);
+			if (type == 0x90 && bytes[2] != 0) {
+				m_sounding[channel][key >> 6] |= bit;
+			}
+			else {
+				m_sounding[channel][key >> 6] &= ~bit;
+			}
+		}
+		m_index++;
+	}
+	m_position.store(qBound(0.0, (end - m_startSample) / sampleRate, file->duration()),
+					 std::memory_order_relaxed);
+	m_reading.store(false, std::memory_order_release);
+	return count;
+}
+
+int MidiFilePlayer::releaseNotes(unsigned char *buf, int nBytes)
+{
+	int count = 0;
+	while (m_releaseChannel < 16) {
+		quint64 *keys = m_sounding[m_releaseChannel];
+		for (int key = 0; key < 128; key++) {
+			quint64 bit = Q_UINT64_C(1) << (key & 63);
+			if (keys[key >> 6] & bit) {
+				if (count + 3 > nBytes) {
+					return count;
+				}
+				buf[count++] = 0x80 | m_releaseChannel;
+				buf[count++] = key;
+				buf[count++] = 0;
+				keys[key >> 6] &= ~bit;
+			}
+		}
+		m_releaseChannel++;
+	}
+	return count;
+}
@@ -0,0 +1,145 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef MIDIFILE_H
+#define MIDIFILE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QSharedPointer>
+#include <atomic>
+
+//
+// Standard MIDI File (format 0, 1 or 2) loaded into memory. The events of
+// all tracks are merged into one list sorted by time, with their times in
+// seconds already resolved through the tempo map. Message bytes are kept
+// in a single pool, so files with hundreds of thousands of events load
+// with a handful of allocations. Meta events are only used for the tempo
+// map and track names, they are not part of the event list.
+//
+class MidiFile
+{
+public:
+	struct Event {
+		double time;    // Seconds
+		quint32 offset; // In the data pool
+		quint32 size;   // SysEx can be long
+		quint16 track;
+	};
+	struct Note {
+		double start;
+		double duration;
+		int track;
+		int channel;    // 0-15
+		int key;
+		int velocity;
+	};
+
+	MidiFile();
+
+	bool load(QString fileName);
+	QString errorString() { return m_error; }
+	QString fileName() { return m_fileName; }
+
+	int format() const { return m_format; }
+	int trackCount() const { return m_trackNames.size(); }
+	QString trackName(int track) const { return m_trackNames.value(track); }
+	int eventCount() const { return m_events.size(); }
+	const Event &event(int index) const { return m_events[index]; }
+	const unsigned char *data(const Event &event) const
+	{
+		return (const unsigned char *) m_data.constData() + event.offset;
+	}
+	double duration() const { return m_duration; } // Up to the last end of track
+	int indexAt(double seconds) const; // First event at or after seconds
+
+	// Note on/off pairs, sorted by start. Notes left on end with the file
+	QVector<Note> notes() const;
+
+private:
+	struct TempoChange {
+		qint64 tick;
+		double secondsPerTick;
+	};
+
+	bool parseTrack(const unsigned char *data, int size, int track, QVector<qint64> &ticks,
+					QVector<TempoChange> &tempos, qint64 &endTick);
+	void setError(QString error);
+
+	QString m_fileName;
+	QString m_error;
+	int m_format;
+	int m_division;
+	QStringList m_trackNames;
+	QVector<Event> m_events;
+	QByteArray m_data;
+	double m_duration;
+};
+
+//
+// Plays a MidiFile into an engine's host MIDI input. read() is called by the
+// engine's MIDI read callback on the performance thread, and passes the
+// events that fall in the current k-cycle on the performance sample clock,
+// so playback is free of scheduling jitter and also works when rendering.
+// Control (play, stop, seek, loop) is lock free from any thread; notes left
+// sounding by a stop, seek or loop are turned off.
+//
+class MidiFilePlayer
+{
+public:
+	MidiFilePlayer();
+
+	void setFile(QSharedPointer<MidiFile> file); // Stops playback
+	QSharedPointer<MidiFile> file() { return m_fileRef; }
+	void play(); // From the current position
+	void stop();
+	void seek(double seconds);
+	void setLoop(bool loop) { m_loop.store(loop, std::memory_order_relaxed); }
+	bool isPlaying() { return m_playing.load(std::memory_order_relaxed); }
+	bool isLooping() { return m_loop.load(std::memory_order_relaxed); }
+	double position() { return m_position.load(std::memory_order_relaxed); } // Seconds
+
+	// Performance thread. sample is the start of the k-cycle
+	int read(qint64 sample, int ksmps, double sampleRate, unsigned char *buf, int nBytes);
+
+private:
+	int releaseNotes(unsigned char *buf, int nBytes);
+
+	QSharedPointer<MidiFile> m_fileRef;
+	std::atomic<const MidiFile *> m_file;
+	std::atomic<bool> m_reading; // read() is running
+	std::atomic<bool> m_playing;
+	std::atomic<bool> m_loop;
+	std::atomic<double> m_seek; // Negative when there is no request
+	std::atomic<double> m_position;
+
+	// Only used by the performance thread
+	int m_index;
+	qint64 m_startSample; // Sample where the file starts
+	bool m_wasPlaying;
+	quint64 m_sounding[16][2]; // Bit per key, from the events passed
+	int m_releaseChannel;      // Next channel to turn off, 16 when done
+};
+
+#endif // MIDIFILE_H
@@ -1,5 +1,7 @@
 #include "midihandler.h"
 #include "midilearndialog.h"
+#include "midiclock.h"
+#include "tracer.h"
 
 #ifdef QCS_RTMIDI
 #include "RtMidi.h"
@@ -11,8 +13,8 @@ static void midiInMessageCallback(double deltatime,
 								void *userData)
 {
 	Q_UNUSED(deltatime);
-	MidiHandler *midiHandler = (MidiHandler *) userData;
-	midiHandler->passMidiMessage(message);
+	MidiHandler::InPort *port = (MidiHandler::InPort *) userData;
+	port->handler->passMidiMessage(port, message);
 	//  if (nBytes > 0) {
 	//    qDebug() << "stamp = " << deltatime;
 	//  }
@@ -20,38 +22,257 @@ static void midiInMessageCallback(double deltatime,
 
 #endif
 
+bool MidiRoute::accepts(const std::vector<unsigned char> &message) const
+{
+	if (message.empty()) {
+		return false;
+	}
+	unsigned char status = message[0];
+	int type;
+	switch (status & 0xF0) {
+	case 0x80:
+	case 0x90:
+		type = Notes;
+		break;
+	case 0xA0:
+	case 0xD0:
+		type = Aftertouch;
+		break;
+	case 0xB0:
+		type = Controllers;
+		break;
+	case 0xC0:
+		type = Programs;
+		break;
+	case 0xE0:
+		type = PitchBend;
+		break;
+	default:
+		type = status == 0xF0 ? SysEx : System;
+	}
+	if (!(messages & type)) {
+		return false;
+	}
+	return channel == 0 || status >= 0xF0 || (status & 0x0F) == channel - 1;
+}
+
+QString MidiRoute::toString() const
+{
+	// Port names can contain anything but new lines, so they go last
+	return QString("%1|%2|%3|%4|%5").arg(channel).arg(toChannel).arg(messages)
+			.arg(document).arg(port);
+}
+
+MidiRoute MidiRoute::fromString(QString text)
+{
+	MidiRoute route;
+	QStringList fields = text.split("|");
+	if (fields.size() >= 5) {
+		route.channel = qBound(0, fields[0].toInt(), 16);
+		route.toChannel = qBound(0, fields[1].toInt(), 16);
+		route.messages = fields[2].toInt() & AllMessages;
+		route.document = fields[3];
+		route.port = QStringList(fields.mid(4)).join("|");
+	}
+	return route;
+}
+
 
 MidiHandler::MidiHandler(int api, QObject *parent) :
     QObject(parent)
 {
+	m_api = api;
 #ifdef QCS_RTMIDI
 	qDebug()<<"Using RtMidi API: " << api;
 	m_midiin = new RtMidiIn((RtMidi::Api) api, "CsoundQt"); //api - see RtMidi.h for types
 	m_midiout = new RtMidiOut((RtMidi::Api) api, "CsoundQt");
-	m_midiin->setCallback(&midiInMessageCallback, this);
-
 #endif
+	m_routedMessage.reserve(3); // Only channel messages are remapped
 	m_midiLearnDialog = NULL;
+	m_runOutThread = false;
+	m_outSleeping = false;
+	m_outThread = new MidiOutThread(this); // Started when out ports are opened
+}
+
+MidiHandler::~MidiHandler()
+{
+	m_listeners.clear(); // Pages may be gone already
+	closeMidiInPorts();
+	closeMidiOutPorts(); // Stops the output thread
+	delete m_outThread;
+#ifdef QCS_RTMIDI
+	delete m_midiin;
+	delete m_midiout;
+#endif
+}
+
+void MidiOutThread::run()
+{
+	m_handler->dispatchMidiOut();
+}
+
+void MidiHandler::addOutputQueue(MidiQueue *queue)
+{
+	QMutexLocker locker(&m_outQueuesMutex);
+	if (!m_outQueues.contains(queue)) {
+		m_outQueues.append(queue);
+		m_outReaders.append(queue->reader());
+	}
+}
+
+void MidiHandler::removeOutputQueue(MidiQueue *queue)
+{
+	QMutexLocker locker(&m_outQueuesMutex);
+	int index = m_outQueues.indexOf(queue);
+	if (index >= 0) {
+		m_outQueues.removeAt(index);
+		m_outReaders.removeAt(index);
+	}
+}
+
+void MidiHandler::wakeMidiOut()
+{
+	// Only posts while the output thread waits. QSemaphore::release() may
+	// take an internal mutex, which only the output thread contends for
+	if (m_outSleeping.exchange(false)) {
+		m_outWake.release();
+	}
+}
+
+void MidiHandler::startOutThread()
+{
+	if (m_outThread->isRunning()) {
+		return;
+	}
+	QMutexLocker locker(&m_outQueuesMutex);
+	// Skip what was queued while no port was open
+	for (int i = 0; i < m_outQueues.size(); i++) {
+		m_outReaders[i] = m_outQueues[i]->reader();
+	}
+	locker.unlock();
+	while (m_outWake.tryAcquire()) {
+	}
+	m_runOutThread = true;
+	m_outThread->start(QThread::TimeCriticalPriority);
+}
+
+void MidiHandler::stopOutThread()
+{
+	m_runOutThread = false;
+	m_outWake.release();
+	m_outThread->wait();
+}
+
+qint64 MidiHandler::nextOutTime()
+{
+	QMutexLocker locker(&m_outQueuesMutex);
+	qint64 next = -1;
+	MidiEvent event;
+	for (int i = 0; i < m_outQueues.size(); i++) {
+		if (m_outQueues[i]->peek(m_outReaders[i], event) && (next < 0 || event.time < next)) {
+			next = event.time;
+		}
+	}
+	return next;
+}
+
+void MidiHandler::dispatchMidiOut()
+{
+	QCS_TRACE_THREAD("MIDI out");
+	std::vector<unsigned char> message;
+	// Large enough for any queued message, so this never allocates again
+	message.reserve(QCS_MIDI_LONG_DATA_SIZE);
+	MidiEvent event;
+	while (m_runOutThread) {
+		m_outQueuesMutex.lock();
+		qint64 now = MidiQueue::now();
+		for (int i = 0; i < m_outQueues.size(); i++) {
+			while (m_outQueues[i]->peek(m_outReaders[i], event) && event.time <= now) {
+				m_outQueues[i]->next(m_outReaders[i]);
+				message.resize(event.size);
+				if (m_outQueues[i]->copyData(event, message.data())) {
+					sendMidiOut(&message);
+				}
+			}
+		}
+		m_outQueuesMutex.unlock();
+		m_outSleeping = true;
+		// Checked after setting the flag, as events pushed before didn't wake us
+		qint64 next = nextOutTime();
+		now = MidiQueue::now();
+		if (next < 0) {
+			m_outWake.acquire();
+		}
+		else if (next > now) {
+			m_outWake.tryAcquire(1, (int) ((next - now + 999999) / 1000000));
+		}
+		m_outSleeping = false;
+	}
 }
 
 void MidiHandler::addListener(DocumentPage *page)
 {
+	QMutexLocker locker(&m_midiInMutex);
 	if(!m_listeners.contains(page)) {
 		m_listeners.append(page);
+		resolveRoutes();
 	}
 }
 
 void MidiHandler::removeListener(DocumentPage *page)
 {
+	QMutexLocker locker(&m_midiInMutex);
 	if(m_listeners.contains(page)) {
 		m_listeners.remove(m_listeners.indexOf(page));
+		resolveRoutes();
 	}
 }
 
 void MidiHandler::setListener(DocumentPage *page)
 {
+	QMutexLocker locker(&m_midiInMutex);
 	m_listeners.clear();
 	m_listeners.append(page);
+	resolveRoutes();
+}
+
+void MidiHandler::setRoutes(QList<MidiRoute> routes)
+{
+	QMutexLocker locker(&m_midiInMutex);
+	m_routes = routes;
+	resolveRoutes();
+}
+
+void MidiHandler::updateRoutes()
+{
+	QMutexLocker locker(&m_midiInMutex);
+	resolveRoutes();
+}
+
+// Resolves port names and document wildcards, so the input threads only
+// compare bits and walk lists
+void MidiHandler::resolveRoutes()
+{
+	m_routeTargets.resize(m_routes.size());
+	for (int i = 0; i < m_routes.size(); i++) {
+		const MidiRoute &route = m_routes[i];
+		RouteTargets &targets = m_routeTargets[i];
+		targets.ports = 0;
+		for (int p = 0; p < m_inPorts.size() && p < 64; p++) {
+			if (route.port.isEmpty() || m_inPorts[p]->name.startsWith(route.port)) {
+				targets.ports |= Q_UINT64_C(1) << p;
+			}
+		}
+		targets.pages.clear();
+		QRegExp pattern(route.document, Qt::CaseInsensitive, QRegExp::Wildcard);
+		foreach (DocumentPage *page, m_listeners) {
+			QString name = page->getFileName();
+			name = name.mid(name.lastIndexOf("/") + 1);
+			if (route.document.isEmpty() || pattern.exactMatch(name)) {
+				targets.pages.append(page);
+			}
+		}
+	}
 }
 
 void MidiHandler::setMidiLearner(MidiLearnDialog *midiLearn)
@@ -59,17 +280,52 @@ void MidiHandler::setMidiLearner(MidiLearnDialog *midiLearn)
 	m_midiLearnDialog = midiLearn;
 }
 
-void MidiHandler::passMidiMessage(std::vector<unsigned char> *message)
+void MidiHandler::passMidiMessage(InPort *port, std::vector<unsigned char> *message)
 {
-	if (!message) {
-		qDebug() << "MidiHandler::passMidiMessage Error: message is NULL";
+	if (!message || message->empty()) {
+		qDebug() << "MidiHandler::passMidiMessage Error: message is empty";
 		return;
 	}
-	foreach(DocumentPage *page, m_listeners) {
-		page->queueMidiIn(message);
+	QMutexLocker locker(&m_midiInMutex);
+	unsigned char status = (*message)[0];
+	if (MidiClock::instance()->processMessage(message->data(), (int) message->size(), port->index,
+											 MidiQueue::now())
+			&& status == 0xF8) {
+		return; // Clock ticks only drive MidiClock
+	}
+	if (status == 0xF1) {
+		return; // MIDI time code is not used
 	}
+	if (m_routes.isEmpty()) {
+		foreach(DocumentPage *page, m_listeners) {
+			page->queueMidiIn(message);
+		}
+	}
+	m_delivered.resize(0);
+	for (int i = 0; i < m_routes.size(); i++) {
+		const MidiRoute &route = m_routes[i];
+		if (port->index >= 64 || !(m_routeTargets[i].ports & (Q_UINT64_C(1) << port->index))
+				|| !route.accepts(*message)) {
+			continue;
+		}
+		std::vector<unsigned char> *routed = message;
+		if (route.toChannel > 0 && (*message)[0] < 0xF0) {
+			m_routedMessage.assign(message->begin(), message->end());
+			m_routedMessage[0] = ((*message)[0] & 0xF0) | (route.toChannel - 1);
+			routed = &m_routedMessage;
+		}
+		const QVector<DocumentPage *> &pages = m_routeTargets[i].pages;
+		for (int j = 0; j < pages.size(); j++) {
+			QPair<DocumentPage *, unsigned char> target(pages[j], (*routed)[0]);
+			if (!m_delivered.contains(target)) {
+				m_delivered.append(target);
+				pages[j]->queueMidiIn(routed);
+			}
+		}
+	}
+	locker.unlock();
 	if (m_midiLearnDialog) {
-		if (message->size() > 2 && ((*message)[0] & 0x90)) {
+		if (message->size() == 3 && ((*message)[0] & 0x90)) {
 			m_midiLearnDialog->setMidiController(((*message)[0] & 0x0F) + 1, (*message)[1] & 0x7F); // was & 8F, that exludes most controller numbers above 0xf
 		}
 	}
@@ -78,23 +334,16 @@ void MidiHandler::passMidiMessage(std::vector<unsigned char> *message)
 void MidiHandler::sendMidiOut(std::vector<unsigned char> *message)
 {
 #ifdef QCS_RTMIDI
-	m_midiout->sendMessage(message);
+	QMutexLocker locker(&m_midiOutMutex);
+	for (int i = 0; i < m_outPorts.size(); i++) {
+		m_outPorts[i]->sendMessage(message);
+	}
 #else
     (void) message;
 #endif
 }
 
 
-void MidiHandler::setMidiInterface(int number)
-{
-	if (number >= 0 && number < 9998) {
-		openMidiInPort(number);
-	}
-	else {
-		closeMidiInPort();
-	}
-}
-
 int MidiHandler::findMidiInPortByName(QString name) {
 	int port = 9999; // stands for None
 #ifdef QCS_RTMIDI
@@ -142,91 +391,142 @@ int MidiHandler::findMidiOutPortByName(QString name) {
 }
 
 
-void MidiHandler::openMidiInPort(int port)
+QStringList MidiHandler::availableMidiInPorts()
 {
-    (void) port;
+	QStringList names;
 #ifdef QCS_RTMIDI
-	try {
-		closeMidiInPort();
+	for (unsigned int i = 0; i < m_midiin->getPortCount(); i++) {
+		names << QString::fromStdString(m_midiin->getPortName(i));
 	}
-#ifdef QCS_OLD_RTMIDI
-	catch (RtError &error) {
-#else
-	catch (RtMidiError &error) {
 #endif
-		error.printMessage();
-	}
-
-	try {
-		m_midiin->openPort(port, "MIDI in");
-	}
-#ifdef QCS_OLD_RTMIDI
-	catch (RtError &error) {
-#else
-	catch (RtMidiError &error) {
-#endif
-		qDebug() << "Error opening MIDI port " << port;
-		error.printMessage();
-		return;
-	}
-	qDebug() << "CsoundQt::openMidiPort opened port " << port;
-#endif
-	//  m_midiin->ignoreTypes(false, false, false);
+	return names;
 }
 
-void MidiHandler::setMidiOutInterface(int number)
+QStringList MidiHandler::availableMidiOutPorts()
 {
-	if (number >= 0 && number < 9998) {
-		openMidiOutPort(number);
-	}
-	else {
-		closeMidiOutPort();
+	QStringList names;
+#ifdef QCS_RTMIDI
+	for (unsigned int i = 0; i < m_midiout->getPortCount(); i++) {
+		names << QString::fromStdString(m_midiout->getPortName(i));
 	}
+#endif
+	return names;
 }
 
-void MidiHandler::openMidiOutPort(int port)
+QStringList MidiHandler::setMidiInPorts(QStringList names)
 {
-    (void) port;
+	QStringList notFound;
+	closeMidiInPorts();
 #ifdef QCS_RTMIDI
-	try {
-		closeMidiOutPort();
-	}
+	QList<InPort *> ports;
+	foreach (QString name, names) {
+		int number = findMidiInPortByName(name);
+		if (number == 9999) {
+			notFound << name;
+			continue;
+		}
+		InPort *port = new InPort;
+		port->handler = this;
+		port->index = ports.size();
+		port->name = QString::fromStdString(m_midiin->getPortName(number));
+		port->midiin = nullptr;
+		try {
+			port->midiin = new RtMidiIn((RtMidi::Api) m_api, "CsoundQt");
+			port->midiin->setCallback(&midiInMessageCallback, port);
+			port->midiin->ignoreTypes(false, false, true); // Pass SysEx and timing, ignore active sensing
+			port->midiin->openPort(number, QString("MIDI in %1").arg(ports.size() + 1).toStdString());
+		}
 #ifdef QCS_OLD_RTMIDI
-	catch (RtError &error) {
+		catch (RtError &error) {
 #else
-	catch (RtMidiError &error) {
+		catch (RtMidiError &error) {
 #endif
-		error.printMessage();
+			qDebug() << "Error opening MIDI port " << name;
+			error.printMessage();
+			delete port->midiin;
+			delete port;
+			notFound << name;
+			continue;
+		}
+		qDebug() << "MidiHandler::setMidiInPorts opened port " << port->name;
+		ports << port;
 	}
+	QMutexLocker locker(&m_midiInMutex);
+	m_inPorts = ports;
+	resolveRoutes();
+#else
+	notFound = names;
+#endif
+	return notFound;
+}
 
-	try {
-		m_midiout->openPort(port, "MIDI out");
-	}
+QStringList MidiHandler::setMidiOutPorts(QStringList names)
+{
+	QStringList notFound;
+	closeMidiOutPorts();
+#ifdef QCS_RTMIDI
+	QList<RtMidiOut *> ports;
+	foreach (QString name, names) {
+		int number = findMidiOutPortByName(name);
+		if (number == 9999) {
+			notFound << name;
+			continue;
+		}
+		RtMidiOut *midiout = nullptr;
+		try {
+			midiout = new RtMidiOut((RtMidi::Api) m_api, "CsoundQt");
+			midiout->openPort(number, QString("MIDI out %1").arg(ports.size() + 1).toStdString());
+		}
 #ifdef QCS_OLD_RTMIDI
-	catch (RtError &error) {
+		catch (RtError &error) {
 #else
-	catch (RtMidiError &error) {
+		catch (RtMidiError &error) {
 #endif
-		qDebug() << "Error opening MIDI out port " << port;
-		error.printMessage();
-		return;
+			qDebug() << "Error opening MIDI out port " << name;
+			error.printMessage();
+			delete midiout;
+			notFound << name;
+			continue;
+		}
+		qDebug() << "MidiHandler::setMidiOutPorts opened port " << name;
+		ports << midiout;
 	}
-	  qDebug() << "CsoundQt::openMidiOutPort opened port " << port;
+	QMutexLocker locker(&m_midiOutMutex);
+	m_outPorts = ports;
+	locker.unlock();
+	if (!ports.isEmpty()) {
+		startOutThread();
+	}
+#else
+	notFound = names;
 #endif
-	//  m_midiin->ignoreTypes(false, false, false);
-
+	return notFound;
 }
 
-void MidiHandler::closeMidiInPort()
+void MidiHandler::closeMidiInPorts()
 {
+	// Not locked while closing, as the ports' threads may be waiting for the lock
+	QMutexLocker locker(&m_midiInMutex);
+	QList<InPort *> ports = m_inPorts;
+	m_inPorts.clear();
+	resolveRoutes();
+	locker.unlock();
 #ifdef QCS_RTMIDI
-	m_midiin->closePort();
+	foreach (InPort *port, ports) {
+		delete port->midiin; // Closes the port and waits for its callback
+		delete port;
+	}
 #endif
 }
 
-void MidiHandler::closeMidiOutPort()
+void MidiHandler::closeMidiOutPorts()
 {
+	stopOutThread();
 #ifdef QCS_RTMIDI
-	m_midiout->closePort();
+	QMutexLocker locker(&m_midiOutMutex);
+	foreach (RtMidiOut *midiout, m_outPorts) {
+		delete midiout;
+	}
+	m_outPorts.clear();
 #endif
 }
@@ -2,47 +2,146 @@
 #define MIDIHANDLER_H
 
 #include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <atomic>
 
 #include "documentpage.h"
+#include "midiqueue.h"
 
 class RtMidiIn;
 class RtMidiOut;
+class MidiHandler;
+
+// A rule of the MIDI routing matrix. Incoming messages are checked against
+// every route and passed to the documents of each route that accepts them.
+class MidiRoute
+{
+public:
+	enum MessageType {
+		Notes = 1,
+		Aftertouch = 2, // Polyphonic and channel
+		Controllers = 4,
+		Programs = 8,
+		PitchBend = 16,
+		SysEx = 32,
+		System = 64, // Common and real time
+		AllMessages = 127
+	};
+
+	MidiRoute() : channel(0), toChannel(0), messages(AllMessages) {}
+
+	QString port;     // Start of the input port name, empty for all ports
+	QString document; // Wildcard for the document file name, empty for all documents
+	int channel;      // 1-16, 0 for all channels
+	int toChannel;    // 1-16, 0 to keep the channel
+	int messages;     // MessageType flags that pass
+
+	bool accepts(const std::vector<unsigned char> &message) const;
+	QString toString() const; // For the settings
+	static MidiRoute fromString(QString text);
+};
+
+// Sends the MIDI out queued by the engines at its scheduled time. It only
+// runs while out ports are open, and sleeps until the next event is due
+class MidiOutThread : public QThread
+{
+public:
+	MidiOutThread(MidiHandler *handler) : m_handler(handler) {}
+protected:
+	virtual void run();
+private:
+	MidiHandler *m_handler;
+};
 
 class MidiHandler : public QObject
 {
     Q_OBJECT
 public:
+	struct InPort {
+		MidiHandler *handler;
+		int index; // In the list of open ports
+		QString name;
+		RtMidiIn *midiin;
+	};
+
 	explicit MidiHandler(int api=0, QObject *parent = 0);
-	void setMidiInterface(int number);
-	void setMidiInterface(QString name);
+	~MidiHandler();
 	int findMidiInPortByName(QString name);
 	int findMidiOutPortByName(QString name);
-	void openMidiInPort(int port);
-    void setMidiOutInterface(int number);
-    void openMidiOutPort(int port);
-    void closeMidiInPort();
-    void closeMidiOutPort();
+	QStringList availableMidiInPorts();
+	QStringList availableMidiOutPorts();
+	// Opens all the ports given by name, closing the others.
+	// Returns the names that were not found
+	QStringList setMidiInPorts(QStringList names);
+	QStringList setMidiOutPorts(QStringList names);
+    void closeMidiInPorts();
+    void closeMidiOutPorts();
 
     void addListener(DocumentPage *page);
     void removeListener(DocumentPage *page);
     void setListener(DocumentPage *page); // Unique listener
 
+    // Without routes every port goes to every listener
+    void setRoutes(QList<MidiRoute> routes);
+    void updateRoutes(); // Call when listeners' file names change
+
     void setMidiLearner(MidiLearnDialog *midiLearn);
 
-    void passMidiMessage(std::vector< unsigned char > *message);
-    void sendMidiOut(std::vector< unsigned char > *message);
+    void passMidiMessage(InPort *port, std::vector< unsigned char > *message);
+    void sendMidiOut(std::vector< unsigned char > *message); // Sends immediately to all out ports
 
+    // Queues filled from the engines' performance threads (midiWriteCb).
+    // Writers call wakeMidiOut() after pushing. It may lock briefly when the
+    // output thread is asleep (QSemaphore), and doesn't lock otherwise
+    void addOutputQueue(MidiQueue *queue);
+    void removeOutputQueue(MidiQueue *queue);
+    void wakeMidiOut();
+    void dispatchMidiOut(); // Output thread loop
 
 signals:
 
 public slots:
 private:
+	void resolveRoutes(); // m_midiInMutex must be held
+	void startOutThread();
+	void stopOutThread();
+	qint64 nextOutTime(); // Earliest queued event, -1 if none
+
+	struct RouteTargets {
+		quint64 ports; // Bit per open in port
+		QVector<DocumentPage *> pages;
+	};
+
 	QVector<DocumentPage *> m_listeners;
 	MidiLearnDialog *m_midiLearnDialog;
 
+	QList<InPort *> m_inPorts;
+	QList<MidiRoute> m_routes;
+	QVector<RouteTargets> m_routeTargets; // Same order as m_routes
+	std::vector<unsigned char> m_routedMessage;
+	// Pages and status bytes a message was already passed to, so that
+	// overlapping routes don't deliver it twice
+	QVector<QPair<DocumentPage *, unsigned char> > m_delivered;
+	// Each in port calls back from its own thread, and a MidiQueue takes one
+	// producer at a time. Also guards listeners and routes
+	QMutex m_midiInMutex;
+
+	QList<MidiQueue *> m_outQueues;
+	QList<MidiQueue::Reader> m_outReaders;
+	QMutex m_outQueuesMutex; // Never taken by the audio thread
+	QMutex m_midiOutMutex; // RtMidiOut is not thread safe
+	MidiOutThread *m_outThread;
+	std::atomic<bool> m_runOutThread;
+	QSemaphore m_outWake;
+	std::atomic<bool> m_outSleeping; // The output thread waits on m_outWake
+
+	int m_api;
 #ifdef QCS_RTMIDI
-	RtMidiIn *m_midiin;
+	RtMidiIn *m_midiin; // Only to list ports
 	RtMidiOut *m_midiout;
+	QList<RtMidiOut *> m_outPorts;
 #endif
 
 };
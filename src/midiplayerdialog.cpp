@@ -0,0 +1,171 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "midiplayerdialog.h"
+#include "qutecsound.h"
+#include "csoundengine.h"
+
+#include <QLabel>
+#include <QSlider>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+
+static QString formatTime(double seconds)
+{
+	int total = (int) seconds;
+	return QString("%1:%2").arg(total / 60).arg(total % 60, 2, 10, QChar('0'));
+}
+
+MidiPlayerDialog::MidiPlayerDialog(CsoundQt *parent)
+	: QDialog(parent), m_qcs(parent)
+{
+	setWindowTitle(tr("MIDI File Player"));
+	QVBoxLayout *layout = new QVBoxLayout(this);
+	QHBoxLayout *fileLayout = new QHBoxLayout();
+	m_fileLabel = new QLabel(tr("No file"), this);
+	fileLayout->addWidget(m_fileLabel, 1);
+	QPushButton *openButton = new QPushButton(tr("Open..."), this);
+	connect(openButton, SIGNAL(released()), this, SLOT(open()));
+	fileLayout->addWidget(openButton);
+	layout->addLayout(fileLayout);
+
+	QHBoxLayout *positionLayout = new QHBoxLayout();
+	m_slider = new QSlider(Qt::Horizontal, this);
+	m_slider->setRange(0, 0);
+	connect(m_slider, SIGNAL(sliderMoved(int)), this, SLOT(seek(int)));
+	positionLayout->addWidget(m_slider, 1);
+	m_timeLabel = new QLabel(formatTime(0), this);
+	positionLayout->addWidget(m_timeLabel);
+	layout->addLayout(positionLayout);
+
+	QHBoxLayout *buttons = new QHBoxLayout();
+	m_playButton = new QPushButton(tr("Play"), this);
+	m_playButton->setToolTip(tr("Play into the current document, which must be running "
+								"with CsoundQt's internal MIDI"));
+	connect(m_playButton, SIGNAL(released()), this, SLOT(play()));
+	buttons->addWidget(m_playButton);
+	m_stopButton = new QPushButton(tr("Stop"), this);
+	connect(m_stopButton, SIGNAL(released()), this, SLOT(stop()));
+	buttons->addWidget(m_stopButton);
+	m_loopCheckBox = new QCheckBox(tr("Loop"), this);
+	connect(m_loopCheckBox, SIGNAL(toggled(bool)), this, SLOT(setLoop(bool)));
+	buttons->addWidget(m_loopCheckBox);
+	buttons->addStretch();
+	QPushButton *closeButton = new QPushButton(tr("Close"), this);
+	connect(closeButton, SIGNAL(released()), this, SLOT(close()));
+	buttons->addWidget(closeButton);
+	layout->addLayout(buttons);
+
+	connect(&m_timer, SIGNAL(timeout()), this, SLOT(updatePosition()));
+	m_timer.start(100);
+	resize(420, 120);
+}
+
+void MidiPlayerDialog::open()
+{
+	QString fileName = QFileDialog::getOpenFileName(this, tr("Open MIDI File"), m_lastDir,
+													tr("MIDI Files (*.mid *.midi *.smf);;All Files (*)"));
+	if (fileName.isEmpty()) {
+		return;
+	}
+	m_lastDir = fileName.left(fileName.lastIndexOf("/") + 1);
+	QSharedPointer<MidiFile> file(new MidiFile);
+	if (!file->load(fileName)) {
+		QMessageBox::warning(this, tr("MIDI File Player"),
+							 tr("Could not load %1:\n%2").arg(fileName).arg(file->errorString()));
+		return;
+	}
+	if (!m_engine.isNull()) {
+		m_engine->midiFilePlayer()->setFile(QSharedPointer<MidiFile>());
+		m_engine.clear();
+	}
+	m_playButton->setEnabled(true);
+	m_file = file;
+	m_fileLabel->setText(QString("%1 (%2 tracks, %3 events)")
+						 .arg(fileName.mid(fileName.lastIndexOf("/") + 1))
+						 .arg(file->trackCount()).arg(file->eventCount()));
+	m_slider->setRange(0, (int) (file->duration() * 10));
+	m_slider->setValue(0);
+	updatePosition();
+}
+
+void MidiPlayerDialog::play()
+{
+	if (m_file.isNull()) {
+		open();
+		if (m_file.isNull()) {
+			return;
+		}
+	}
+	CsoundEngine *engine = m_qcs->getEngine();
+	if (engine == nullptr) {
+		return;
+	}
+	if (m_engine != engine) { // Move to the current document
+		double position = m_slider->value() / 10.0;
+		if (!m_engine.isNull()) {
+			m_engine->midiFilePlayer()->setFile(QSharedPointer<MidiFile>());
+		}
+		m_engine = engine;
+		engine->midiFilePlayer()->setFile(m_file);
+		engine->midiFilePlayer()->seek(position);
+	}
+	engine->midiFilePlayer()->setLoop(m_loopCheckBox->isChecked());
+	engine->midiFilePlayer()->play();
+}
+
+void MidiPlayerDialog::stop()
+{
+	if (!m_engine.isNull()) {
+		m_engine->midiFilePlayer()->stop();
+	}
+}
+
+void MidiPlayerDialog::setLoop(bool loop)
+{
+	if (!m_engine.isNull()) {
+		m_engine->midiFilePlayer()->setLoop(loop);
+	}
+}
+
+void MidiPlayerDialog::seek(int value)
+{
+	if (!m_engine.isNull()) {
+		m_engine->midiFilePlayer()->seek(value / 10.0);
+	}
+	m_timeLabel->setText(formatTime(value / 10.0));
+}
+
+void MidiPlayerDialog::updatePosition()
+{
+	if (m_engine.isNull() || !isVisible() || m_slider->isSliderDown()) {
+		return;
+	}
+	double position = m_engine->midiFilePlayer()->position();
+	m_slider->setValue((int) (position * 10));
+	m_timeLabel->setText(formatTime(position));
+	m_playButton->setEnabled(!m_engine->midiFilePlayer()->isPlaying());
+}
@@ -0,0 +1,70 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef MIDIPLAYERDIALOG_H
+#define MIDIPLAYERDIALOG_H
+
+#include <QDialog>
+#include <QTimer>
+#include <QPointer>
+
+#include "midifile.h"
+
+class QLabel;
+class QSlider;
+class QCheckBox;
+class QPushButton;
+class CsoundEngine;
+class CsoundQt;
+
+// Plays a Standard MIDI File into the current document's MIDI input
+class MidiPlayerDialog : public QDialog
+{
+	Q_OBJECT
+public:
+	MidiPlayerDialog(CsoundQt *parent);
+
+public slots:
+	void open();
+	void play();
+	void stop();
+
+private slots:
+	void setLoop(bool loop);
+	void seek(int value);
+	void updatePosition();
+
+private:
+	CsoundQt *m_qcs;
+	QPointer<CsoundEngine> m_engine; // Engine playing the file
+	QSharedPointer<MidiFile> m_file;
+	QLabel *m_fileLabel;
+	QLabel *m_timeLabel;
+	QSlider *m_slider;
+	QCheckBox *m_loopCheckBox;
+	QPushButton *m_playButton;
+	QPushButton *m_stopButton;
+	QTimer m_timer;
+	QString m_lastDir;
+};
+
+#endif // MIDIPLAYERDIALOG_H
@@ -0,0 +1,207 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#ifndef MIDIQUEUE_H
+#define MIDIQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+
+// Number of MIDI events kept, must be a power of two
+#define QCS_MIDI_QUEUE_SIZE 1024
+// Times peek() retries a slot that is being overwritten
+#define QCS_MIDI_PEEK_ATTEMPTS 4
+// Default bytes kept for messages longer than 3 bytes (SysEx)
+#define QCS_MIDI_LONG_DATA_SIZE (1 << 17)
+// Long data for queues that seldom carry SysEx
+#define QCS_MIDI_SMALL_LONG_DATA_SIZE (1 << 14)
+
+struct MidiEvent {
+	qint64 time; // Arrival time in nanoseconds, see MidiQueue::now()
+	int size;    // Bytes in the message
+	unsigned char data[3]; // The message, or its first 3 bytes if longer (use longData())
+	quint64 position; // Where a long message starts in the long data pool
+};
+
+//
+// Incoming MIDI for a document. There is a single producer (the MIDI input
+// thread) and any number of readers (the engine's MIDI read callback, the
+// widget layout), each with its own position, so every reader sees every
+// event and nothing is ever locked. Events are stamped on arrival.
+// The producer never waits: a reader that falls more than
+// QCS_MIDI_QUEUE_SIZE events behind skips the overwritten events and
+// counts them as lost.
+// Long messages (SysEx) are copied into a byte pool shared by all events,
+// allocated once with the queue, so bulk dumps don't allocate. Their bytes
+// stay valid until the pool size of more long data has been pushed.
+//
+class MidiQueue
+{
+public:
+	struct Reader {
+		Reader() : position(0), lost(0) {}
+		quint64 position;
+		quint64 lost;
+	};
+
+	// longDataSize is rounded up to a power of two
+	explicit MidiQueue(int longDataSize = QCS_MIDI_LONG_DATA_SIZE) : m_head(0), m_longHead(0)
+	{
+		for (int i = 0; i < QCS_MIDI_QUEUE_SIZE; i++) {
+			m_slots[i].sequence.store(0, std::memory_order_relaxed);
+		}
+		m_longSize = 4;
+		while (m_longSize < longDataSize) {
+			m_longSize *= 2;
+		}
+		m_longData = new unsigned char[m_longSize];
+	}
+
+	~MidiQueue() { delete[] m_longData; }
+
+	int longDataSize() const { return m_longSize; }
+
+	// Monotonic clock shared by all threads
+	static qint64 now();
+
+	// Only called from one thread at a time. Fails for messages larger than the long data pool
+	bool push(const unsigned char *data, int size, qint64 time)
+	{
+		if (size < 1 || size > m_longSize) {
+			return false;
+		}
+		quint64 position = 0;
+		if (size > 3) {
+			position = m_longHead.load(std::memory_order_relaxed);
+			// Claim the bytes before overwriting them, so readers of older
+			// messages can tell their data is gone
+			m_longHead.store(position + size, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (int i = 0; i < size; i++) {
+				m_longData[(position + i) & (m_longSize - 1)] = data[i];
+			}
+		}
+		quint64 head = m_head.load(std::memory_order_relaxed);
+		Slot &slot = m_slots[head & (QCS_MIDI_QUEUE_SIZE - 1)];
+		// Odd sequence while the slot is being written
+		slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		quint32 message = 0;
+		for (int i = 0; i < size && i < 3; i++) {
+			message |= ((quint32) data[i]) << (8 * i);
+		}
+		slot.message.store(message, std::memory_order_relaxed);
+		slot.size.store(size, std::memory_order_relaxed);
+		slot.position.store(position, std::memory_order_relaxed);
+		slot.time.store(time, std::memory_order_relaxed);
+		slot.sequence.store(2 * head + 2, std::memory_order_release);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// A reader that only sees events pushed from now on
+	Reader reader()
+	{
+		Reader reader;
+		reader.position = m_head.load(std::memory_order_acquire);
+		return reader;
+	}
+
+	// The next event for reader, without consuming it. Readers run on the
+	// audio thread, so if the producer keeps overwriting the slot this gives
+	// up after a few tries and reports the queue as empty until the next call
+	bool peek(Reader &reader, MidiEvent &event)
+	{
+		for (int attempt = 0; attempt < QCS_MIDI_PEEK_ATTEMPTS; attempt++) {
+			quint64 head = m_head.load(std::memory_order_acquire);
+			if (reader.position == head) {
+				return false;
+			}
+			if (head - reader.position > QCS_MIDI_QUEUE_SIZE) {
+				reader.lost += head - QCS_MIDI_QUEUE_SIZE - reader.position;
+				reader.position = head - QCS_MIDI_QUEUE_SIZE;
+			}
+			Slot &slot = m_slots[reader.position & (QCS_MIDI_QUEUE_SIZE - 1)];
+			quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+			quint32 message = slot.message.load(std::memory_order_relaxed);
+			event.size = slot.size.load(std::memory_order_relaxed);
+			event.position = slot.position.load(std::memory_order_relaxed);
+			event.time = slot.time.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence != 2 * reader.position + 2
+					|| slot.sequence.load(std::memory_order_relaxed) != sequence) {
+				continue; // Overwritten while reading, skip ahead
+			}
+			for (int i = 0; i < 3; i++) {
+				event.data[i] = (message >> (8 * i)) & 0xFF;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	// Copies a whole message (short or long) to dest, which must hold event.size
+	// bytes. Returns false if the long data was overwritten by newer messages
+	bool copyData(const MidiEvent &event, unsigned char *dest)
+	{
+		if (event.size <= 3) {
+			memcpy(dest, event.data, event.size);
+			return true;
+		}
+		for (int i = 0; i < event.size; i++) {
+			dest[i] = m_longData[(event.position + i) & (m_longSize - 1)];
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return m_longHead.load(std::memory_order_relaxed) <= event.position + m_longSize;
+	}
+
+	// Consumes the event returned by peek()
+	void next(Reader &reader) { reader.position++; }
+
+	bool read(Reader &reader, MidiEvent &event)
+	{
+		if (!peek(reader, event)) {
+			return false;
+		}
+		next(reader);
+		return true;
+	}
+
+private:
+	Q_DISABLE_COPY(MidiQueue)
+
+	struct Slot {
+		std::atomic<quint64> sequence;
+		std::atomic<qint64> time;
+		std::atomic<quint32> message; // Up to the first 3 bytes
+		std::atomic<int> size;
+		std::atomic<quint64> position; // In the long data pool
+	};
+
+	Slot m_slots[QCS_MIDI_QUEUE_SIZE];
+	std::atomic<quint64> m_head;
+	unsigned char *m_longData;
+	int m_longSize;
+	std::atomic<quint64> m_longHead; // Total long data bytes pushed
+};
+
+#endif // MIDIQUEUE_H
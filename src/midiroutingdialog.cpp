@@ -0,0 +1,246 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "midiroutingdialog.h"
+
+#include <QListWidget>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+
+static const int messageTypes[] = {
+	MidiRoute::Notes, MidiRoute::Aftertouch, MidiRoute::Controllers, MidiRoute::Programs,
+	MidiRoute::PitchBend, MidiRoute::SysEx, MidiRoute::System
+};
+static const int messageTypeCount = sizeof(messageTypes) / sizeof(int);
+
+MidiRoutingDialog::MidiRoutingDialog(QWidget *parent, QStringList availableInPorts,
+									 QStringList availableOutPorts)
+	: QDialog(parent), m_availableInPorts(availableInPorts), m_availableOutPorts(availableOutPorts)
+{
+	setWindowTitle(tr("MIDI Routing"));
+	QVBoxLayout *layout = new QVBoxLayout(this);
+
+	QHBoxLayout *ports = new QHBoxLayout();
+	QVBoxLayout *inLayout = new QVBoxLayout();
+	inLayout->addWidget(new QLabel(tr("Additional MIDI in ports"), this));
+	m_inList = new QListWidget(this);
+	inLayout->addWidget(m_inList);
+	ports->addLayout(inLayout);
+	QVBoxLayout *outLayout = new QVBoxLayout();
+	outLayout->addWidget(new QLabel(tr("Additional MIDI out ports"), this));
+	m_outList = new QListWidget(this);
+	outLayout->addWidget(m_outList);
+	ports->addLayout(outLayout);
+	layout->addLayout(ports);
+
+	QLabel *routesLabel = new QLabel(tr("Routes. Each incoming message goes to the documents of every "
+										"route that accepts it. Without routes all ports go to all "
+										"documents."), this);
+	routesLabel->setWordWrap(true);
+	layout->addWidget(routesLabel);
+	m_table = new QTableWidget(0, FirstTypeColumn + messageTypeCount, this);
+	m_table->setHorizontalHeaderLabels(QStringList() << tr("In port") << tr("Document")
+									   << tr("Channel") << tr("To channel")
+									   << tr("Notes") << tr("Aftertouch") << tr("CC")
+									   << tr("Program") << tr("Bend") << tr("SysEx") << tr("System"));
+	m_table->horizontalHeaderItem(DocumentColumn)->setToolTip(
+				tr("File name, wildcards allowed. Empty for all documents"));
+	m_table->verticalHeader()->hide();
+	layout->addWidget(m_table);
+
+	QHBoxLayout *clock = new QHBoxLayout();
+	m_clockOutBox = new QCheckBox(tr("Send MIDI clock while running, at"), this);
+	clock->addWidget(m_clockOutBox);
+	m_clockTempoBox = new QDoubleSpinBox(this);
+	m_clockTempoBox->setRange(20.0, 300.0);
+	m_clockTempoBox->setDecimals(2);
+	m_clockTempoBox->setSuffix(tr(" BPM"));
+	clock->addWidget(m_clockTempoBox);
+	clock->addSpacing(20);
+	m_clockSyncBox = new QCheckBox(tr("Sync event sheet loops to received MIDI clock"), this);
+	clock->addWidget(m_clockSyncBox);
+	clock->addStretch();
+	layout->addLayout(clock);
+
+	QHBoxLayout *buttons = new QHBoxLayout();
+	QPushButton *addButton = new QPushButton(tr("Add Route"), this);
+	connect(addButton, SIGNAL(released()), this, SLOT(addRoute()));
+	buttons->addWidget(addButton);
+	QPushButton *removeButton = new QPushButton(tr("Remove Route"), this);
+	connect(removeButton, SIGNAL(released()), this, SLOT(removeRoute()));
+	buttons->addWidget(removeButton);
+	buttons->addStretch();
+	QDialogButtonBox *box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+	connect(box, SIGNAL(accepted()), this, SLOT(accept()));
+	connect(box, SIGNAL(rejected()), this, SLOT(reject()));
+	buttons->addWidget(box);
+	layout->addLayout(buttons);
+
+	resize(800, 480);
+}
+
+void MidiRoutingDialog::setPorts(QStringList inPorts, QStringList outPorts)
+{
+	setChecked(m_inList, m_availableInPorts, inPorts);
+	setChecked(m_outList, m_availableOutPorts, outPorts);
+}
+
+QStringList MidiRoutingDialog::inPorts()
+{
+	return checked(m_inList);
+}
+
+QStringList MidiRoutingDialog::outPorts()
+{
+	return checked(m_outList);
+}
+
+void MidiRoutingDialog::setRoutes(QList<MidiRoute> routes)
+{
+	m_table->setRowCount(0);
+	foreach (MidiRoute route, routes) {
+		appendRoute(route);
+	}
+}
+
+QList<MidiRoute> MidiRoutingDialog::routes()
+{
+	QList<MidiRoute> routes;
+	for (int row = 0; row < m_table->rowCount(); row++) {
+		MidiRoute route;
+		QComboBox *port = static_cast<QComboBox *>(m_table->cellWidget(row, PortColumn));
+		route.port = port->currentIndex() == 0 ? QString() : port->currentText();
+		route.document = m_table->item(row, DocumentColumn)->text().trimmed();
+		route.channel = static_cast<QSpinBox *>(m_table->cellWidget(row, ChannelColumn))->value();
+		route.toChannel = static_cast<QSpinBox *>(m_table->cellWidget(row, ToChannelColumn))->value();
+		route.messages = 0;
+		for (int i = 0; i < messageTypeCount; i++) {
+			if (m_table->item(row, FirstTypeColumn + i)->checkState() == Qt::Checked) {
+				route.messages |= messageTypes[i];
+			}
+		}
+		routes << route;
+	}
+	return routes;
+}
+
+void MidiRoutingDialog::setClock(bool out, double tempo, bool sync)
+{
+	m_clockOutBox->setChecked(out);
+	m_clockTempoBox->setValue(tempo);
+	m_clockSyncBox->setChecked(sync);
+}
+
+bool MidiRoutingDialog::clockOut()
+{
+	return m_clockOutBox->isChecked();
+}
+
+double MidiRoutingDialog::clockTempo()
+{
+	return m_clockTempoBox->value();
+}
+
+bool MidiRoutingDialog::clockSync()
+{
+	return m_clockSyncBox->isChecked();
+}
+
+{
+	appendRoute(MidiRoute());
+}
+
+void MidiRoutingDialog::removeRoute()
+{
+	if (m_table->currentRow() >= 0) {
+		m_table->removeRow(m_table->currentRow());
+	}
+}
+
+void MidiRoutingDialog::appendRoute(const MidiRoute &route)
+{
+	int row = m_table->rowCount();
+	m_table->insertRow(row);
+	QComboBox *port = new QComboBox(m_table);
+	port->setEditable(true); // Port names are matched by their start
+	port->addItem(tr("All ports"));
+	port->addItems(m_availableInPorts);
+	if (route.port.isEmpty()) {
+		port->setCurrentIndex(0);
+	}
+	else {
+		port->setEditText(route.port);
+	}
+	m_table->setCellWidget(row, PortColumn, port);
+	m_table->setItem(row, DocumentColumn, new QTableWidgetItem(route.document));
+	QSpinBox *channel = new QSpinBox(m_table);
+	channel->setRange(0, 16);
+	channel->setSpecialValueText(tr("All"));
+	channel->setValue(route.channel);
+	m_table->setCellWidget(row, ChannelColumn, channel);
+	QSpinBox *toChannel = new QSpinBox(m_table);
+	toChannel->setRange(0, 16);
+	toChannel->setSpecialValueText(tr("Same"));
+	toChannel->setValue(route.toChannel);
+	m_table->setCellWidget(row, ToChannelColumn, toChannel);
+	for (int i = 0; i < messageTypeCount; i++) {
+		QTableWidgetItem *item = new QTableWidgetItem();
+		item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+		item->setCheckState((route.messages & messageTypes[i]) ? Qt::Checked : Qt::Unchecked);
+		m_table->setItem(row, FirstTypeColumn + i, item);
+	}
+}
+
+void MidiRoutingDialog::setChecked(QListWidget *list, QStringList available, QStringList names)
+{
+	list->clear();
+	foreach (QString name, names) { // Keep ports that are not connected now
+		if (!available.contains(name)) {
+			available << name;
+		}
+	}
+	foreach (QString name, available) {
+		QListWidgetItem *item = new QListWidgetItem(name, list);
+		item->setFlags(Qt::ItemIsUserCheckable | Qt::ItemIsEnabled);
+		item->setCheckState(names.contains(name) ? Qt::Checked : Qt::Unchecked);
+	}
+}
+
+QStringList MidiRoutingDialog::checked(QListWidget *list)
+{
+	QStringList names;
+	for (int i = 0; i < list->count(); i++) {
+		if (list->item(i)->checkState() == Qt::Checked) {
+			names << list->item(i)->text();
+		}
+	}
+	return names;
+}
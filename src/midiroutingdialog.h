@@ -0,0 +1,80 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef MIDIROUTINGDIALOG_H
+#define MIDIROUTINGDIALOG_H
+
+#include <QDialog>
+
+#include "midihandler.h"
+
+class QListWidget;
+class QTableWidget;
+class QCheckBox;
+class QDoubleSpinBox;
+
+// Edits the MIDI ports opened besides the ones chosen in the configuration,
+// the routing matrix applied to incoming MIDI and the MIDI clock settings.
+class MidiRoutingDialog : public QDialog
+{
+	Q_OBJECT
+public:
+	MidiRoutingDialog(QWidget *parent, QStringList availableInPorts, QStringList availableOutPorts);
+
+	void setPorts(QStringList inPorts, QStringList outPorts);
+	QStringList inPorts();
+	QStringList outPorts();
+	void setRoutes(QList<MidiRoute> routes);
+	QList<MidiRoute> routes();
+	void setClock(bool out, double tempo, bool sync);
+	bool clockOut();
+	double clockTempo();
+	bool clockSync();
+
+private slots:
+	void addRoute();
+	void removeRoute();
+
+private:
+	enum Column {
+		PortColumn = 0,
+		DocumentColumn,
+		ChannelColumn,
+		ToChannelColumn,
+		FirstTypeColumn // One column per MidiRoute::MessageType
+	};
+
+	void appendRoute(const MidiRoute &route);
+	static void setChecked(QListWidget *list, QStringList available, QStringList names);
+	static QStringList checked(QListWidget *list);
+
+	QStringList m_availableInPorts;
+	QStringList m_availableOutPorts;
+	QListWidget *m_inList;
+	QListWidget *m_outList;
+	QTableWidget *m_table;
+	QCheckBox *m_clockOutBox;
+	QDoubleSpinBox *m_clockTempoBox;
+	QCheckBox *m_clockSyncBox;
+};
+
+#endif // MIDIROUTINGDIALOG_H
@@ -76,6 +76,9 @@ Options::Options(ConfigLists *configlists) :
     consoleBufferSize = 1024;
     midiInterface = 0; // For internal CsoundQt MIDI control
     midiOutInterface = 0; // For internal CsoundQt MIDI control
+    midiClockOut = false;
+    midiClockTempo = 120.0;
+    midiClockSync = false;
 
     rtMidiApi = 0;
 
@@ -79,6 +79,12 @@ public:
 	QString midiInterfaceName;
 	int midiOutInterface;
 	QString midiOutInterfaceName;
+	QStringList midiInPorts;  // Opened besides midiInterfaceName
+	QStringList midiOutPorts; // Opened besides midiOutInterfaceName
+	QStringList midiRoutes;   // MidiRoute::toString()
+	bool midiClockOut;   // Send MIDI clock while running
+	double midiClockTempo; // Of the clock sent, in BPM
+	bool midiClockSync;  // Event sheet loops follow the received clock
 	int rtMidiApi; // "UNSPECIFIED" | "LINUX_ALSA" | "UNIX_JACK" | "MACOSX_CORE" | "WINDOWS_MM" see RtMidi.h
 	// Csound engine flags
 	bool noBuffer;
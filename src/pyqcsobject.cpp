@@ -632,3 +632,55 @@ void PyQcsObject::loadPreset(int presetIndex,int index)
 
 
 
+
+void PyQcsObject::sendMidi(QVariantList message, int index)
+{
+	CsoundEngine *e = m_qcs->getEngine(index);
+	if (e != NULL) {
+		std::vector<unsigned char> bytes;
+		bytes.reserve(message.size());
+		foreach (QVariant byte, message) {
+			bytes.push_back(byte.toInt() & 0xFF);
+		}
+		e->queueVirtualMidiIn(bytes);
+	}
+}
+
+void PyQcsObject::sendMidiOut(QVariantList message, int index)
+{
+	CsoundEngine *e = m_qcs->getEngine(index);
+	if (e != NULL) {
+		QVector<unsigned char> bytes;
+		bytes.reserve(message.size());
+		foreach (QVariant byte, message) {
+			bytes.append(byte.toInt() & 0xFF);
+		}
+		e->sendMidiOut(bytes);
+	}
+}
+
+QVariantList PyQcsObject::readMidi(int index)
+{
+	QVariantList messages;
+	CsoundEngine *e = m_qcs->getEngine(index);
+	if (e != NULL) {
+		foreach (QByteArray message, e->readScriptMidiIn()) {
+			QVariantList bytes;
+			for (int i = 0; i < message.size(); i++) {
+				bytes << (int) (unsigned char) message[i];
+			}
+			messages << QVariant(bytes);
+		}
+	}
+	return messages;
+}
+
+void PyQcsObject::startTrace()
+{
+	m_qcs->startTrace();
+}
+
+bool PyQcsObject::stopTrace(QString fileName)
+{
+	return m_qcs->stopTrace(fileName);
+}
@@ -158,9 +158,18 @@ public slots:
 	//    void writeArrayToTable(int ftable, QVariantList values, int offset = 0, int count = -1); // Numpy arrays
 	//    QVariantList readArrayToList(int ftable, int offset = 0, int count = -1); // Numpy arrays
 
+	// MIDI, messages are lists of bytes and can be SysEx
+	void sendMidi(QVariantList message, int index = -1); // To Csound, like the virtual keyboard
+	void sendMidiOut(QVariantList message, int index = -1); // To the MIDI out port
+	QVariantList readMidi(int index = -1); // Messages received from the MIDI in port since the last call
+
 	// Register callback
 	void registerProcessCallback(QString func, int skipPeriods = 0, int index = -1);
 
+	// Performance trace (Chrome trace event format)
+	void startTrace();
+	bool stopTrace(QString fileName = QString());
+
 private:
 	CsoundQt *m_qcs;
 	MYFLT **m_tablePtr;
@@ -34,6 +34,7 @@
 #include "qutesheet.h"
 
 #include "qutecsound.h"
+#include "tracer.h"
 
 PythonConsole::PythonConsole(QWidget *parent)
 	: QDockWidget(parent), m_pqcs(0), m_console(0)
@@ -57,6 +58,7 @@ PythonConsole::~PythonConsole()
 
 void PythonConsole::evaluate(QString evalCode, bool notify)
 {
+	QCS_TRACE_SCOPE("python evaluate");
 	PythonQtObjectPtr  mainContext = PythonQt::self()->getMainModule();
 	//  PythonQtObjectPtr  mainContext = m_pqcs->getMainModule();
 	mainContext.evalScript(evalCode.trimmed() + "\n");
@@ -40,6 +40,12 @@
 #include "midihandler.h"
 #include "midilearndialog.h"
 #include "livecodeeditor.h"
+#include "tracer.h"
+#include "memorydialog.h"
+#include "midiroutingdialog.h"
+#include "midiclock.h"
+#include "midiplayerdialog.h"
+#include "virtualmidiinput.h"
 #include "csoundhtmlview.h"
 #include <thread>
 
@@ -78,6 +84,9 @@ CsoundQt::CsoundQt(QStringList fileNames)
     m_closing = false;
     m_resetPrefs = false;
     utilitiesDialog = NULL;
+    m_memoryDialog = nullptr;
+    m_midiPlayerDialog = nullptr;
+    m_virtualMidiInput = nullptr;
     curCsdPage = -1;
     configureTab = 0;
     //	initialDir = QDir::current().path();
@@ -982,6 +991,44 @@ void CsoundQt::testAudioSetup()
 
 }
 
+void CsoundQt::recordTrace(bool record)
+{
+    if (record) {
+        startTrace();
+        return;
+    }
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Trace"),
+                                                    lastUsedDir + "csoundqt-trace.json",
+                                                    tr("Trace files (*.json)"));
+    stopTrace(fileName);
+}
+
+void CsoundQt::startTrace()
+{
+    Tracer::instance()->start();
+    traceAct->blockSignals(true);
+    traceAct->setChecked(true);
+    traceAct->blockSignals(false);
+    statusBarMessage(tr("Recording trace..."));
+}
+
+bool CsoundQt::stopTrace(QString fileName)
+{
+    Tracer::instance()->stop();
+    traceAct->blockSignals(true);
+    traceAct->setChecked(false);
+    traceAct->blockSignals(false);
+    if (fileName.isEmpty()) {
+        return false;
+    }
+    if (!Tracer::instance()->exportJson(fileName)) {
+        QMessageBox::warning(this, tr("Trace"), tr("Could not write trace file %1").arg(fileName));
+        return false;
+    }
+    statusBarMessage(tr("Trace saved to %1. It can be opened in ui.perfetto.dev").arg(fileName));
+    return true;
+}
+
 QString CsoundQt::getSaveFileName()
 {
     bool widgetsVisible = widgetPanel->isVisible();
@@ -1243,8 +1290,8 @@ void CsoundQt::onReadyRead()
 void CsoundQt::disableInternalRtMidi()
 {
 #ifdef QCS_RTMIDI
-    midiHandler->closeMidiInPort();
-    midiHandler->closeMidiOutPort();
+    midiHandler->closeMidiInPorts();
+    midiHandler->closeMidiOutPorts();
 #endif
 }
 
@@ -1665,6 +1712,27 @@ void CsoundQt::showUtilities(bool show)
     }
 }
 
+void CsoundQt::showMidiPlayer()
+{
+    if (m_midiPlayerDialog == nullptr) {
+        m_midiPlayerDialog = new MidiPlayerDialog(this);
+        m_midiPlayerDialog->setModal(false);
+    }
+    m_midiPlayerDialog->show();
+    m_midiPlayerDialog->raise();
+}
+
+void CsoundQt::showMemoryUsage()
+{
+    if (m_memoryDialog == nullptr) {
+        m_memoryDialog = new MemoryDialog(this, &documentPages);
+        m_memoryDialog->setModal(false);
+    }
+    m_memoryDialog->refresh();
+    m_memoryDialog->show();
+    m_memoryDialog->raise();
+}
+
 void CsoundQt::inToGet()
 {
     documentPages[curPage]->inToGet();
@@ -2081,16 +2149,34 @@ void CsoundQt::record(bool rec)
         if (!documentPages[curPage]->isRunning()) {
             play();
         }
-        int ret = documentPages[curPage]->record(m_options->sampleFormat);
+        int ret = documentPages[curPage]->record(m_options->sampleFormat,
+                                                 m_options->recordFileType);
         if (ret != 0) {
             recAct->setChecked(false);
         }
+        else {
+            updateRecordingStatus();
+        }
     }
     else {
         documentPages[curPage]->stopRecording();
+        statusBarMessage(tr("Recording stopped"));
     }
 }
 
+void CsoundQt::updateRecordingStatus()
+{
+    if (!recAct->isChecked()) {
+        return;
+    }
+    if (!documentPages[curPage]->isRecording()) {
+        recAct->setChecked(false); // Stopped after an error, reported in the console
+        return;
+    }
+    statusBarMessage(documentPages[curPage]->recordingStatus());
+    QTimer::singleShot(1000, this, SLOT(updateRecordingStatus()));
+}
+
 
 void CsoundQt::sendEvent(QString eventLine, double delay)
 {
@@ -2390,12 +2476,13 @@ void CsoundQt::showVirtualKeyboard(bool show)
         m_virtualKeyboardPointer = m_virtualKeyboard;  // guarded pointer to check if object is  alive
         m_virtualKeyboard->setWindowTitle(tr("CsoundQt Virtual Keyboard"));
         m_virtualKeyboard->setWindowFlags(Qt::Window);
+        if (m_virtualMidiInput == nullptr) {
+            m_virtualMidiInput = new VirtualMidiInput(this, this);
+        }
+        // Keys call it directly, so notes don't wait in the event loop
+        m_virtualKeyboard->rootContext()->setContextProperty("virtualMidi", m_virtualMidiInput);
         m_virtualKeyboard->setSource(QUrl("qrc:/QML/VirtualKeyboard.qml"));
-        QObject *rootObject = m_virtualKeyboard->rootObject();
         m_virtualKeyboard->setFocus();
-        connect(rootObject, SIGNAL(genNote(QVariant, QVariant, QVariant, QVariant)),
-                this, SLOT(virtualMidiIn(QVariant, QVariant, QVariant, QVariant)));
-        connect(rootObject, SIGNAL(newCCvalue(int,int,int)), this, SLOT(virtualCCIn(int, int, int)));
         m_virtualKeyboard->setVisible(true);
         connect(m_virtualKeyboard, SIGNAL(destroyed(QObject*)), this, SLOT(virtualKeyboardActOff(QObject*)));
     } else if (!m_virtualKeyboardPointer.isNull()) { // check if object still existing (i.e not on exit)
@@ -2503,25 +2590,30 @@ void CsoundQt::showMidiLearn()
     m_midiLearn->show();
 }
 
-void CsoundQt::virtualMidiIn(QVariant on, QVariant note, QVariant channel, QVariant velocity)
-{
-    std::vector<unsigned char> message;
-    unsigned char status = (8 << 4) | on.toInt() << 4 | (channel.toInt() -1);
-    message.push_back(status);
-    message.push_back(note.toInt());
-    message.push_back(velocity.toInt());
-    documentPages[curPage]->queueVirtualMidiIn(message);
-}
-
-void CsoundQt::virtualCCIn(int channel, int cc, int value)
+void CsoundQt::showMidiRouting()
 {
-    //qDebug()<<"CC event: "<<channel<< cc<<value;
-    std::vector<unsigned char> message;
-    unsigned char status = (11 << 4 | (channel - 1));
-    message.push_back(status);
-    message.push_back(cc);
-    message.push_back(value);
-    documentPages[curPage]->queueVirtualMidiIn(message);
+    MidiRoutingDialog dialog(this, midiHandler->availableMidiInPorts(),
+                             midiHandler->availableMidiOutPorts());
+    dialog.setPorts(m_options->midiInPorts, m_options->midiOutPorts);
+    QList<MidiRoute> routes;
+    foreach (QString route, m_options->midiRoutes) {
+        routes << MidiRoute::fromString(route);
+    }
+    dialog.setRoutes(routes);
+    dialog.setClock(m_options->midiClockOut, m_options->midiClockTempo, m_options->midiClockSync);
+    if (dialog.exec() == QDialog::Accepted) {
+        m_options->midiInPorts = dialog.inPorts();
+        m_options->midiOutPorts = dialog.outPorts();
+        m_options->midiRoutes.clear();
+        foreach (MidiRoute route, dialog.routes()) {
+            m_options->midiRoutes << route.toString();
+        }
+        m_options->midiClockOut = dialog.clockOut();
+        m_options->midiClockTempo = dialog.clockTempo();
+        m_options->midiClockSync = dialog.clockSync();
+        applySettings();
+        storeSettings();
+    }
 }
 
 void CsoundQt::handleTableSyntax(QString syntax)
@@ -2810,23 +2902,48 @@ void CsoundQt::applySettings()
         QString interfaceNotFoundMessage; // find midi interface by name; if not found, set to None
         // returns 9999 if not found
         m_options->midiInterface = midiHandler->findMidiInPortByName(m_options->midiInterfaceName);
-        midiHandler->setMidiInterface(m_options->midiInterface);
-        // close port, if 9999
+        QStringList inPorts = m_options->midiInPorts;
+        if (m_options->midiInterface != 9999) {
+            inPorts.prepend(m_options->midiInterfaceName);
+        }
+        inPorts.removeDuplicates();
+        // close ports not listed
+        foreach (QString name, midiHandler->setMidiInPorts(inPorts)) {
+            qDebug()<<"Midi In interface "<< name << " not found!";
+            interfaceNotFoundMessage += tr("Midi In interface ") + name + tr(" not found!\n");
+        }
         if (m_options->midiInterface==9999 && !m_options->midiInterfaceName.contains("None")) {
             qDebug()<<"Midi In interface "<< m_options->midiInterfaceName << " not found!";
-            interfaceNotFoundMessage = tr("Midi In interface ") +
+            interfaceNotFoundMessage += tr("Midi In interface ") +
                     m_options->midiInterfaceName +
                     tr(" not found!\n Switching to None.\n");
         }
 
         m_options->midiOutInterface = midiHandler->findMidiOutPortByName(m_options->midiOutInterfaceName);
-        midiHandler->setMidiOutInterface(m_options->midiOutInterface);
+        QStringList outPorts = m_options->midiOutPorts;
+        if (m_options->midiOutInterface != 9999) {
+            outPorts.prepend(m_options->midiOutInterfaceName);
+        }
+        outPorts.removeDuplicates();
+        foreach (QString name, midiHandler->setMidiOutPorts(outPorts)) {
+            qDebug()<<"Midi Out interface "<< name << " not found!";
+            interfaceNotFoundMessage += tr("Midi Out interface ") + name + tr(" not found!\n");
+        }
         if (m_options->midiOutInterface == 9999 && !m_options->midiOutInterfaceName.contains("None")) {
             qDebug()<<"Midi Out interface "<< m_options->midiOutInterfaceName << " not found!";
             interfaceNotFoundMessage += tr("Midi Out interface ") +
                     m_options->midiOutInterfaceName +
                     tr(" not found!\n Switching to None.");
         }
+        QList<MidiRoute> routes;
+        foreach (QString route, m_options->midiRoutes) {
+            routes << MidiRoute::fromString(route);
+        }
+        midiHandler->setRoutes(routes);
+        MidiClock *clock = MidiClock::instance();
+        clock->setSendEnabled(m_options->midiClockOut);
+        clock->setSendTempo(m_options->midiClockTempo);
+        clock->setSyncLoops(m_options->midiClockSync);
         //	if (!interfaceNotFoundMessage.isEmpty()) { // probably messagebox alwais is a bit too disturbing. Keep it quiet.
         //		QMessageBox::warning(this, tr("MIDI interface not found"),
         //							 interfaceNotFoundMessage);
@@ -3018,6 +3135,7 @@ void CsoundQt::runUtility(QString flags)
 
 void CsoundQt::updateInspector()
 {
+    QCS_TRACE_SCOPE("updateInspector");
     if (m_closing) {
         return;  // And don't call this again from the timer
     }
@@ -3523,6 +3641,21 @@ void CsoundQt::createActions()
                                     tr("Test Audio Setup"), this);
     connect(testAudioSetupAct, SIGNAL(triggered(bool)), this, SLOT(testAudioSetup()));
 
+    traceAct = new QAction(tr("Record Performance Trace"), this);
+    traceAct->setStatusTip(tr("Record a timeline of the engine, callbacks and GUI updates "
+                              "and save it as a Chrome trace (for Perfetto)"));
+    traceAct->setCheckable(true);
+    traceAct->setChecked(false);
+    connect(traceAct, SIGNAL(toggled(bool)), this, SLOT(recordTrace(bool)));
+
+    midiPlayerAct = new QAction(tr("MIDI File Player"), this);
+    midiPlayerAct->setStatusTip(tr("Play a MIDI file into the current document"));
+    connect(midiPlayerAct, SIGNAL(triggered()), this, SLOT(showMidiPlayer()));
+
+    showMemoryAct = new QAction(tr("Memory Usage"), this);
+    showMemoryAct->setStatusTip(tr("Show the memory used by each open document"));
+    connect(showMemoryAct, SIGNAL(triggered()), this, SLOT(showMemoryUsage()));
+
     externalPlayerAct = new QAction(QIcon(prefix + "playfile.png"), tr("Play Rendered Audiofile"), this);
     externalPlayerAct->setStatusTip(tr("Play rendered audiofile in external application"));
     externalPlayerAct->setIconText(tr("Ext. Player"));
@@ -3762,6 +3895,9 @@ void CsoundQt::createActions()
     midiLearnAct->setStatusTip(tr("Show MIDI Learn Window for widgets"));
     midiLearnAct->setShortcutContext(Qt::ApplicationShortcut);
     connect(midiLearnAct, SIGNAL(triggered()), this, SLOT(showMidiLearn()));
+    midiRoutingAct = new QAction(tr("MIDI Routing"), this);
+    midiRoutingAct->setStatusTip(tr("Open several MIDI ports and route them to documents"));
+    connect(midiRoutingAct, SIGNAL(triggered()), this, SLOT(showMidiRouting()));
 
     showOrcAct = new QAction(/*QIcon(prefix + "gksu-root-terminal.png"),*/ tr("Show Orchestra"), this);
     showOrcAct->setCheckable(true);
@@ -4239,11 +4375,13 @@ void CsoundQt::createMenus()
     controlMenu->addAction(recAct);
     controlMenu->addAction(stopAct);
     controlMenu->addAction(stopAllAct);
+    controlMenu->addAction(midiPlayerAct);
     controlMenu->addSeparator();
     controlMenu->addAction(externalEditorAct);
     controlMenu->addAction(externalPlayerAct);
     controlMenu->addSeparator();
     controlMenu->addAction(testAudioSetupAct);
+    controlMenu->addAction(traceAct);
 
 
     viewMenu = menuBar()->addMenu(tr("View"));
@@ -4267,6 +4405,8 @@ void CsoundQt::createMenus()
     viewMenu->addAction(showDebugAct);
 #endif
     viewMenu->addAction(midiLearnAct);
+    viewMenu->addAction(midiRoutingAct);
+    viewMenu->addAction(showMemoryAct);
 #ifdef USE_QT5
     viewMenu->addAction(showVirtualKeyboardAct);
     viewMenu->addAction(showTableEditorAct);
@@ -4979,6 +5119,12 @@ void CsoundQt::readSettings()
     m_options->midiInterfaceName = settings.value("midiInterfaceName", "None").toString();
     m_options->midiOutInterface = settings.value("midiOutInterface", 9999).toInt();
     m_options->midiOutInterfaceName = settings.value("midiOutInterfaceName", "None").toString();
+    m_options->midiInPorts = settings.value("midiInPorts", QStringList()).toStringList();
+    m_options->midiOutPorts = settings.value("midiOutPorts", QStringList()).toStringList();
+    m_options->midiRoutes = settings.value("midiRoutes", QStringList()).toStringList();
+    m_options->midiClockOut = settings.value("midiClockOut", false).toBool();
+    m_options->midiClockTempo = settings.value("midiClockTempo", 120.0).toDouble();
+    m_options->midiClockSync = settings.value("midiClockSync", false).toBool();
     m_options->noBuffer = settings.value("noBuffer", false).toBool();
     m_options->noPython = settings.value("noPython", false).toBool();
     m_options->noMessages = settings.value("noMessages", false).toBool();
@@ -5046,6 +5192,8 @@ void CsoundQt::readSettings()
     m_options->useCsoundMidi = settings.value("useCsoundMidi", false).toBool();
     m_options->simultaneousRun = settings.value("simultaneousRun", "").toBool();
     m_options->sampleFormat = settings.value("sampleFormat", 0).toInt();
+    m_options->recordFileType = settings.value("recordFileType", 0).toInt();
+    m_options->recordPreroll = settings.value("recordPreroll", 10).toInt();
     settings.endGroup();
     settings.beginGroup("Environment");
 #ifdef Q_OS_MAC
@@ -5213,6 +5361,12 @@ void CsoundQt::writeSettings(QStringList openFiles, int lastIndex)
         settings.setValue("midiInterfaceName", m_options->midiInterfaceName);
         settings.setValue("midiOutInterface", m_options->midiOutInterface);
         settings.setValue("midiOutInterfaceName", m_options->midiOutInterfaceName);
+        settings.setValue("midiInPorts", m_options->midiInPorts);
+        settings.setValue("midiOutPorts", m_options->midiOutPorts);
+        settings.setValue("midiRoutes", m_options->midiRoutes);
+        settings.setValue("midiClockOut", m_options->midiClockOut);
+        settings.setValue("midiClockTempo", m_options->midiClockTempo);
+        settings.setValue("midiClockSync", m_options->midiClockSync);
         settings.setValue("noBuffer", m_options->noBuffer);
         settings.setValue("noPython", m_options->noPython);
         settings.setValue("noMessages", m_options->noMessages);
@@ -5256,6 +5410,8 @@ void CsoundQt::writeSettings(QStringList openFiles, int lastIndex)
         settings.setValue("useCsoundMidi", m_options->useCsoundMidi);
         settings.setValue("simultaneousRun", m_options->simultaneousRun);
         settings.setValue("sampleFormat", m_options->sampleFormat);
+        settings.setValue("recordFileType", m_options->recordFileType);
+        settings.setValue("recordPreroll", m_options->recordPreroll);
     }
     else {
         settings.remove("");
@@ -5657,6 +5813,7 @@ bool CsoundQt::saveFile(const QString &fileName, bool saveWidgets)
     if (fileName != documentPages[curPage]->getFileName()) {
         documentPages[curPage]->setFileName(fileName);
         setCurrentFile(fileName);
+        midiHandler->updateRoutes(); // Routes match documents by file name
     }
     lastUsedDir = fileName;
     lastUsedDir.resize(fileName.lastIndexOf("/") + 1);
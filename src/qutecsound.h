@@ -28,6 +28,7 @@
 #ifdef USE_QT_GT_53
 #include <QQuickWidget>
 #include <QQuickItem>
+#include <QQmlContext>
 #endif
 #else
 #include <QtGui>
@@ -63,6 +64,9 @@ class Options;
 class ConfigLists;
 class DocumentPage;
 class UtilitiesDialog;
+class MemoryDialog;
+class MidiPlayerDialog;
+class VirtualMidiInput;
 class Curve;
 class GraphicWindow;
 class KeyboardShortcuts;
@@ -182,6 +186,8 @@ public slots:
 	//    void registerLiveEvent(QWidget *e);
 	void evaluateCsound(QString code = QString());
 	void breakpointReached();
+	void startTrace();
+	bool stopTrace(QString fileName = QString()); // Exports to fileName if not empty
 protected:
 	virtual void closeEvent(QCloseEvent *event);
 	//    virtual void keyPressEvent(QKeyEvent *event);
@@ -217,6 +223,8 @@ private slots:
 	void findString();  // Direct to current Page
 	bool join(bool ask = true);
 	void showUtilities(bool);
+	void showMemoryUsage();
+	void showMidiPlayer();
 	void getToIn();
 	void inToGet();
 	void updateCsladspaText();
@@ -240,8 +248,7 @@ private slots:
 	void showHtml5Gui(bool show);
 	void splitView(bool split);
 	void showMidiLearn();
-	void virtualMidiIn(QVariant on, QVariant note, QVariant channel, QVariant velocity);
-	void virtualCCIn(int channel, int cc, int value);
+	void showMidiRouting();
 	void handleTableSyntax(QString syntax);
 	void openManualExample(QString fileName);
 	void openExternalBrowser(QUrl url = QUrl());
@@ -283,6 +290,8 @@ private slots:
     void focusToTab(int tab);
     void ambiguosShortcut();
     void testAudioSetup();
+    void recordTrace(bool record);
+    void updateRecordingStatus();
 #ifdef QCS_DEBUGGER
 	void runDebugger();
 	void stopDebugger();
@@ -406,6 +415,9 @@ private:
 	QAction *editAct;
 	QAction *runAct;
     QAction *testAudioSetupAct;
+    QAction *traceAct;
+    QAction *showMemoryAct;
+    QAction *midiPlayerAct;
 	QAction *runTermAct;
 	QAction *pauseAct;
 	QAction *stopAct;
@@ -439,6 +451,7 @@ private:
     QAction *raiseHtml5Act;
 #endif
 	QAction *midiLearnAct;
+	QAction *midiRoutingAct;
 	QAction *splitViewAct;
 	QAction *showOrcAct;
 	QAction *showScoreAct;
@@ -495,6 +508,9 @@ private:
 	bool m_inspectorNeedsUpdate;
 	bool m_closing; // CsoundQt is closing (to inform timer threads)
 	UtilitiesDialog *utilitiesDialog;
+	MemoryDialog *m_memoryDialog;
+	MidiPlayerDialog *m_midiPlayerDialog;
+	VirtualMidiInput *m_virtualMidiInput; // For the virtual keyboard
 	QIcon modIcon;
 	QString currentAudioFile;
 	QString initialDir;
@@ -23,11 +23,25 @@
 #include "qutegraph.h"
 #include "curve.h"
 #include <cmath>
+#include <cstring>
 #include <QPalette>
+#include <QtConcurrent>
 
 
 #include <QColorDialog>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QCS_GRAPH_SSE2
+#endif
+
+// 20 / ln(10), dB per neper
+#define QCS_DB_PER_NEPER 8.685889638065035
+// Lowest level drawn in spectrum graphs
+#define QCS_SPECTRUM_FLOOR_DB -110.0f
+// Larger ftables have their level of detail built on a worker thread
+#define QCS_TABLE_LOD_SYNC_SIZE 65536
+
 
 enum CsoundEngineStatus {
     Running=0,
@@ -55,6 +69,65 @@ inline CsoundEngineStatus csoundEngineStatus(CsoundUserData *ud) {
     return CsoundEngineStatus::Running;
 }
 
+// Natural logarithm of a positive normal float, error below 3e-6. The
+// exponent is taken from the bits and the mantissa m (1 to 2) goes through
+// the series ln(m) = 2 atanh((m - 1) / (m + 1))
+static inline float fastLn(float x)
+{
+    quint32 bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float) ((int) (bits >> 23) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    float s = (m - 1) / (m + 1);
+    float s2 = s * s;
+    float series = s * (2 + s2 * (2.0f / 3 + s2 * (2.0f / 5 + s2 * (2.0f / 7 + s2 * (2.0f / 9)))));
+    return exponent * 0.6931471805599453f + series;
+}
+
+// Replaces magnitudes by their level in dB relative to reference, no lower
+// than floorDb
+static void magnitudesToDb(float *values, int count, float reference, float floorDb)
+{
+    float floor = std::pow(10.0f, floorDb / 20) * reference;
+    float offset = (float) (-QCS_DB_PER_NEPER * std::log(reference));
+    int i = 0;
+#ifdef QCS_GRAPH_SSE2
+    const __m128 vFloor = _mm_set1_ps(floor);
+    const __m128 vOffset = _mm_set1_ps(offset);
+    const __m128 vDb = _mm_set1_ps((float) QCS_DB_PER_NEPER);
+    const __m128 ln2 = _mm_set1_ps(0.6931471805599453f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i mantissaMask = _mm_set1_epi32(0x007FFFFF);
+    const __m128i exponentOne = _mm_set1_epi32(0x3F800000);
+    const __m128i bias = _mm_set1_epi32(127);
+    const __m128 c1 = _mm_set1_ps(2.0f);
+    const __m128 c3 = _mm_set1_ps(2.0f / 3);
+    const __m128 c5 = _mm_set1_ps(2.0f / 5);
+    const __m128 c7 = _mm_set1_ps(2.0f / 7);
+    const __m128 c9 = _mm_set1_ps(2.0f / 9);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_max_ps(_mm_loadu_ps(values + i), vFloor); // Also replaces NaN
+        __m128i bits = _mm_castps_si128(x);
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), exponentOne));
+        __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+        __m128 s2 = _mm_mul_ps(s, s);
+        __m128 series = _mm_add_ps(c7, _mm_mul_ps(s2, c9));
+        series = _mm_add_ps(c5, _mm_mul_ps(s2, series));
+        series = _mm_add_ps(c3, _mm_mul_ps(s2, series));
+        series = _mm_add_ps(c1, _mm_mul_ps(s2, series));
+        __m128 ln = _mm_add_ps(_mm_mul_ps(exponent, ln2), _mm_mul_ps(s, series));
+        _mm_storeu_ps(values + i, _mm_add_ps(_mm_mul_ps(ln, vDb), vOffset));
+    }
+#endif
+    for (; i < count; i++) {
+        float x = values[i] > floor ? values[i] : floor;
+        values[i] = (float) QCS_DB_PER_NEPER * fastLn(x) + offset;
+    }
+}
+
 
 // -----------------------------------------------------------------------------------------
 
@@ -62,6 +135,12 @@ QuteGraph::QuteGraph(QWidget *parent) : QuteWidget(parent)
 {
 	m_widget = new StackedLayoutWidget(this);
 	m_widget->show();
+	// A single view shows the scene of the current curve
+	m_view = new QGraphicsView(m_widget);
+	m_view->setContextMenuPolicy(Qt::NoContextMenu);
+	m_view->setResizeAnchor(QGraphicsView::NoAnchor);
+	static_cast<StackedLayoutWidget *>(m_widget)->addWidget(m_view);
+	m_currentIndex = -1;
 	//  m_widget->setAutoFillBackground(true);
 	m_widget->setMouseTracking(true); // Necessary to pass mouse tracking to widget panel for _MouseX channels
 	m_widget->setContextMenuPolicy(Qt::NoContextMenu);
@@ -80,6 +159,7 @@ QuteGraph::QuteGraph(QWidget *parent) : QuteWidget(parent)
 	m_label->setFocusPolicy(Qt::NoFocus);
     m_drawGrid = true;
     m_drawTableInfo = true;
+    m_shownCurve = nullptr;
 	canFocus(false);
 	connect(m_pageComboBox, SIGNAL(currentIndexChanged(int)),
 			this, SLOT(indexChanged(int)));
@@ -106,6 +186,9 @@ QuteGraph::QuteGraph(QWidget *parent) : QuteWidget(parent)
 
 QuteGraph::~QuteGraph()
 {
+	foreach (TableLod *lod, m_tableLods) {
+		delete lod;
+	}
 }
 
 QString QuteGraph::getWidgetLine()
@@ -167,7 +250,10 @@ void QuteGraph::setWidgetGeometry(int x,int y,int width,int height)
 {
 	QuteWidget::setWidgetGeometry(x,y,width, height);
 	static_cast<StackedLayoutWidget *>(m_widget)->setWidgetGeometry(0,0,width, height);
-	int index = static_cast<StackedLayoutWidget *>(m_widget)->currentIndex();
+	int index = m_currentIndex;
+    if (index >= 0 && index < curves.size() && graphtypes[index] == GraphType::GRAPH_FTABLE) {
+        drawFtablePath(curves[index], index);  // The detail drawn depends on the width
+    }
     changeCurve(-2);
 
     if (index < 0)
@@ -315,6 +401,12 @@ void QuteGraph::createPropertiesDialog()
     showTableInfoCheckBox->setToolTip("Show the grid. Has effect only for spectral graphs");
     layout->addWidget(showTableInfoCheckBox, 9, 2, Qt::AlignRight|Qt::AlignVCenter);
 
+    logFrequencyCheckBox = new QCheckBox(dialog);
+    logFrequencyCheckBox->setText("Log Frequency");
+    logFrequencyCheckBox->setChecked(property("QCS_modex").toString() == "log");
+    logFrequencyCheckBox->setToolTip("Logarithmic frequency axis. Has effect only for spectral graphs");
+    layout->addWidget(logFrequencyCheckBox, 9, 3, Qt::AlignRight|Qt::AlignVCenter);
+
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.lockForRead();
 #endif
@@ -337,7 +429,7 @@ void QuteGraph::applyProperties()
 	setProperty("QCS_zoomy", zoomyBox->value());
 	setProperty("QCS_dispx", 1);
 	setProperty("QCS_dispy", 1);
-	setProperty("QCS_modex", "lin");
+	setProperty("QCS_modex", logFrequencyCheckBox->isChecked() ? "log" : "lin");
 	setProperty("QCS_modey", "lin");
 	setProperty("QCS_all", true);
     setProperty("QCS_showSelector", showSelectorCheckBox->checkState());
@@ -356,10 +448,8 @@ void QuteGraph::changeCurve(int index)
     if(curves.size() <= 0)
         return;
 
-    int origRequest = index;
-    StackedLayoutWidget *stacked =  static_cast<StackedLayoutWidget *>(m_widget);
     if (index == -1) { // goto last curve
-        index = stacked->count() - 1;
+        index = curves.size() - 1;
 	}
 	else if (index == -2) { // update curve but don't change which
         if (m_value < 0)
@@ -367,20 +457,19 @@ void QuteGraph::changeCurve(int index)
         else
 			index = (int) m_value;
 	}
-    else if (stacked->currentIndex() == index) {
+    else if (m_currentIndex == index) {
         return;
-    } else if (index >= stacked->count()) {
-        qDebug() << "changeCurve: index out of range. Num indices:"<<stacked->size();
+    } else if (index >= curves.size()) {
+        qDebug() << "changeCurve: index out of range. Num indices:"<<curves.size();
         return;
-    } else {
-        qDebug()<<"changeCurve"<<index;
-
+    }
+    bool switched = index >= 0 && index < curves.size() && index != m_currentIndex;
+    if (switched) {
         // change curve
-        auto view = stacked->currentWidget();
-        view->hide();
-        stacked->blockSignals(true);
-        stacked->setCurrentIndex(index);
-        stacked->blockSignals(false);
+        m_currentIndex = index;
+        m_view->setRenderHint(QPainter::Antialiasing,
+                              graphtypes[index] != GraphType::GRAPH_AUDIOSIGNAL);
+        m_view->setScene(getScene(index));
         m_pageComboBox->blockSignals(true);
         m_pageComboBox->setCurrentIndex(index);
         m_pageComboBox->blockSignals(false);
@@ -390,6 +479,10 @@ void QuteGraph::changeCurve(int index)
         return;
 
     m_value = index;
+    if (curves[index] != m_shownCurve) {
+        m_shownCurve = curves[index];
+        emit showingCurve(this, m_shownCurve);
+    }
     switch(graphtypes[index]) {
     case GraphType::GRAPH_FTABLE: {
         int ftable = getTableNumForIndex(index);
@@ -406,8 +499,6 @@ void QuteGraph::changeCurve(int index)
             m_label->setText(text);
             m_label->show();
         }
-        if(origRequest >= 0)
-            drawGraph(curves[index], index);
         break;
     }
     case GraphType::GRAPH_SPECTRUM:
@@ -419,6 +510,13 @@ void QuteGraph::changeCurve(int index)
         m_label->hide();
         break;
     }
+    // Curves changed while hidden were only marked by their version. Ftables
+    // are drawn again anyway, as their detail depends on the current zoom
+    if (switched && (m_drawnVersion[index] != curves[index]->get_version()
+                     || graphtypes[index] == GraphType::GRAPH_FTABLE)) {
+        drawGraph(curves[index], index);  // Scales the graph
+        return;
+    }
     scaleGraph(index);
 }
 
@@ -453,51 +551,92 @@ void QuteGraph::indexChanged(int index)
 void QuteGraph::clearCurves()
 {
 	//  curveLock.lock();
-	m_widget->blockSignals(true);
-	static_cast<StackedLayoutWidget *>(m_widget)->clearCurves();
-	m_widget->blockSignals(false);
+	m_view->setScene(nullptr);
+	qDeleteAll(m_scenes);
+	m_scenes.clear();
+	m_drawnVersion.clear();
+	m_currentIndex = -1;
 	m_pageComboBox->blockSignals(true);
 	m_pageComboBox->clear();
 	m_pageComboBox->blockSignals(false);
 	curves.clear();
+	m_curveIndex.clear();
+	m_tableIndex.clear();
+	if (m_shownCurve != nullptr) {
+		m_shownCurve = nullptr;
+		emit showingCurve(this, nullptr);
+	}
+	foreach (TableLod *lod, m_tableLods) {
+		delete lod;  // A build still running finishes on its own
+	}
+	m_tableLods.clear();
 	lines.clear();
 	polygons.clear();
 	m_gridlines.clear();
     m_gridtext.clear();
+    m_gridLabelRate.clear();
+    graphtypes.clear();
 	//  curveLock.unlock();
 }
 
 void QuteGraph::addCurve(Curve * curve)
 {
     Q_ASSERT(curve != nullptr);
-	QGraphicsView *view = new QGraphicsView(m_widget);
-	QGraphicsScene *scene = new QGraphicsScene(view);
-	view->setContextMenuPolicy(Qt::NoContextMenu);
-    view->setScene(scene);
-    view->setObjectName(curve->get_caption());
-    view->show();
-    scene->setBackgroundBrush(QBrush(Qt::black));
-    lines.append(QVector<QGraphicsLineItem *>());
-	QVector<QGraphicsLineItem *> gridLinesVector;
-	QVector<QGraphicsTextItem *> gridTextVector;
-    int numTicksX = 12;
-    int numTicksY = 6;
-    auto gridpen = QPen(QColor(90, 90, 90));
-    gridpen.setCosmetic(true);
-
     QString caption = curve->get_caption();
     GraphType graphType;
     if(caption.contains("fft")) {
         graphType = GraphType::GRAPH_SPECTRUM;
-        view->setRenderHint(QPainter::Antialiasing);
     } else if(caption.contains("ftable")) {
         graphType = GraphType::GRAPH_FTABLE;
-        view->setRenderHint(QPainter::Antialiasing);
     } else {
         graphType = GraphType::GRAPH_AUDIOSIGNAL;
     }
+    // The scene and its items are created when the curve is first shown
+    m_scenes.append(nullptr);
+    m_drawnVersion.append(0);
+    lines.append(QVector<QGraphicsLineItem *>());
+    m_gridlines.append(QVector<QGraphicsLineItem *>());
+    m_gridtext.append(QVector<QGraphicsTextItem *>());
+    m_gridLabelRate.append(-1);  // Labels are set when first drawn
+    m_tableLods.append(nullptr);
+    polygons.append(nullptr);
+    graphtypes.append(graphType);
 
-    if(graphType == GraphType::GRAPH_SPECTRUM) {
+	m_pageComboBox->blockSignals(true);
+	m_pageComboBox->addItem(curve->get_caption());
+	m_pageComboBox->blockSignals(false);
+	//  curveLock.lock();
+    m_curveIndex.insert(curve, curves.size());
+    if (graphType == GraphType::GRAPH_FTABLE) {
+        QStringList parts = caption.split(QRegExp("[ :]"), QString::SkipEmptyParts);
+        if (parts.size() > 1 && !m_tableIndex.contains(parts.last().toInt())) {
+            m_tableIndex.insert(parts.last().toInt(), curves.size());
+        }
+    }
+    curves.append(curve);
+    if (m_value == curves.size() - 1) {
+        // If new curve created corresponds to current stored value
+		changeCurve(m_value);
+	}
+}
+
+// Scenes hold the items drawn for each curve, so switching curves only
+// swaps the scene shown by the view
+QGraphicsScene *QuteGraph::getScene(int index)
+{
+    if (m_scenes[index] != nullptr) {
+        return m_scenes[index];
+    }
+    QGraphicsScene *scene = new QGraphicsScene(this);
+    scene->setBackgroundBrush(QBrush(Qt::black));
+	QVector<QGraphicsLineItem *> gridLinesVector;
+	QVector<QGraphicsTextItem *> gridTextVector;
+    int numTicksX = 12;
+    int numTicksY = 6;
+    auto gridpen = QPen(QColor(90, 90, 90));
+    gridpen.setCosmetic(true);
+
+    if(graphtypes[index] == GraphType::GRAPH_SPECTRUM) {
 
 
         for (int i = 0 ; i < numTicksX; i++) {
@@ -508,11 +647,6 @@ void QuteGraph::addCurve(Curve * curve)
             QGraphicsTextItem *gridText = new QGraphicsTextItem();
             gridText->setDefaultTextColor(Qt::gray);
             gridText->setFlags(QGraphicsItem::ItemIgnoresTransformations);
-            if (i > 0) {
-                double kHz = i*((numTicksX-1.0)/numTicksX) * 2.0;
-                gridText->setHtml(QString("<div style=\"background:#000000;\">%1k</p>"
-                                          ).arg(kHz, 2, 'f', 1));
-            }
             gridText->setFont(QFont("Sans", 6));
             gridText->setVisible(false);
             scene->addItem(gridText);
@@ -537,54 +671,30 @@ void QuteGraph::addCurve(Curve * curve)
         }
     }
 
-    m_gridlines.append(gridLinesVector);
-    m_gridtext.append(gridTextVector);
-
-    graphtypes.append(graphType);
+    m_gridlines[index] = gridLinesVector;
+    m_gridtext[index] = gridTextVector;
 
     QGraphicsPolygonItem * item = new QGraphicsPolygonItem();
     auto graphPen = QPen(Qt::yellow);
     graphPen.setCosmetic(true);
     item->setPen(graphPen);
     item->show();
-    polygons.append(item);
+    polygons[index] = item;
     scene->addItem(item);
-    view->setResizeAnchor (QGraphicsView::NoAnchor);
-    // view->setFocusPolicy(Qt::NoFocus);
-	m_pageComboBox->blockSignals(true);
-	m_pageComboBox->addItem(curve->get_caption());
-	m_pageComboBox->blockSignals(false);
-	//  curveLock.lock();
-	static_cast<StackedLayoutWidget *>(m_widget)->addWidget(view);
-    curves.append(curve);
-    if (m_value == curves.size() - 1) {
-        // If new curve created corresponds to current stored value
-		changeCurve(m_value);
-	}
+    m_scenes[index] = scene;
+    return scene;
 }
 
 int QuteGraph::getCurveIndex(Curve * curve)
 {
     Q_ASSERT(curve != nullptr);
-	int index = -1;
-	for (int i = 0; i < curves.size(); i++) {
-		if (curves[i] == curve) {
-			index = i;
-			break;
-		}
-	}
-    return index;
-}
-
-QGraphicsView * QuteGraph::getView(int index) {
-    StackedLayoutWidget *widget_ = static_cast<StackedLayoutWidget *>(m_widget);
-    QGraphicsView *view = static_cast<QGraphicsView *>(widget_->widget(index));
-    return view;
+    return m_curveIndex.value(curve, -1);
 }
 
 void QuteGraph::drawGraph(Curve *curve, int index) {
     // QString caption = curve->get_caption();
-    // auto view = getView(index);
+    getScene(index);
+    m_drawnVersion[index] = curve->get_version();
 
     switch(graphtypes[index]) {
     case GraphType::GRAPH_FTABLE:
@@ -614,11 +724,10 @@ void QuteGraph::setCurveData(Curve * curve)
 
     if (index >= curves.size() ||
         index < 0 ||
-        index != m_value) {
-        return;
+        index != m_currentIndex) {
+        return;  // Hidden curves are drawn when shown, see changeCurve()
 	}
-    StackedLayoutWidget *widget_ = static_cast<StackedLayoutWidget *>(m_widget);
-	QGraphicsView *view = static_cast<QGraphicsView *>(widget_->widget(index));
+    QGraphicsView *view = m_view;
     // Refitting curves in view resets the scrollbar so we need the previous value
 	int viewPosx = view->horizontalScrollBar()->value();
 	int viewPosy = view->verticalScrollBar()->value();
@@ -635,31 +744,102 @@ void QuteGraph::applyInternalProperties()
         m_pageComboBox->show();
     } else {
         m_pageComboBox->hide();
+    }
+    int index = m_currentIndex;
+    if (index >= 0 && index < curves.size() && graphtypes[index] == GraphType::GRAPH_FTABLE) {
+        drawFtablePath(curves[index], index);  // Zoom changes the detail drawn
     }
 	changeCurve(-2);  // Redraw
     m_drawGrid = property("QCS_showGrid").toBool();
     m_drawTableInfo = property("QCS_showTableInfo").toBool();
 }
 
+// Updates a copy of the pyramid, run on a worker thread for large tables
+static TablePyramid buildTablePyramid(TablePyramid pyramid, QVector<MYFLT> data)
+{
+    pyramid.setData(data);
+    return pyramid;
+}
+
+// Draws at most one vertical segment per pixel column, spanning the minimum
+// and maximum of the samples under it, so the cost depends on the width of
+// the view and not on the size of the table. The table's pyramid is only
+// updated when the curve changes, on a worker thread for large tables; the
+// previous one is drawn until it is ready.
 void QuteGraph::drawFtablePath(Curve *curve, int index) {
     Q_ASSERT(index >= 0);
-    QGraphicsScene *scene = static_cast<QGraphicsView *>(static_cast<StackedLayoutWidget *>(m_widget)->widget(index))->scene();
-    double max = curve->get_max();
-    max = max == 0 ? 1: max;
+    TableLod *lod = m_tableLods[index];
+    if (lod == nullptr) {
+        lod = new TableLod;
+        connect(&lod->watcher, SIGNAL(finished()), this, SLOT(tablePyramidReady()));
+        lod->item = getScene(index)->addPath(QPainterPath(), QPen(QColor(255, 45, 7), 0.02));
+        m_tableLods[index] = lod;
+    }
     int size = (int) curve->get_size();
-    int decimate = size /1024;
-    if (decimate == 0) {
-        decimate = 1;
+    if (curve->get_version() != lod->version && lod->pendingVersion == 0) {
+        QVector<MYFLT> data(size);
+        memcpy(data.data(), curve->get_data(), size * sizeof(MYFLT));
+        if (size <= QCS_TABLE_LOD_SYNC_SIZE) {
+            lod->pyramid.setData(data);
+            lod->version = curve->get_version();
+        }
+        else {
+            lod->pendingVersion = curve->get_version();
+            lod->watcher.setFuture(QtConcurrent::run(buildTablePyramid, lod->pyramid, data));
+        }
     }
-    int curveSize = curve->get_size();
-    auto pen = QPen(QColor(255, 45, 7), 0.02);
+    const TablePyramid &pyramid = lod->pyramid;
+    int count = pyramid.size();
     QPainterPath path;
-    for (int i = 0; i < (int) curveSize; i++) {
-        double value = curve->get_data(i);
-        path.lineTo(QPointF(i, -value));
+    if (count == 0) {
+        lod->item->setPath(path);
+        lod->drawnColumns = 0;
+        return;
+    }
+    int columns = qMax(1, (int) (m_view->viewport()->width() * property("QCS_zoomx").toDouble()));
+    if (lod->drawnVersion == lod->version && lod->drawnColumns == columns) {
+        return;  // Already shown, e.g. redrawn by changeCurve() after a resize
+    }
+    double samplesPerColumn = count / (double) columns;
+    if (samplesPerColumn <= 2) {
+        const MYFLT *data = pyramid.data();
+        path.moveTo(0, -data[0]);
+        for (int i = 1; i < count; i++) {
+            path.lineTo(i, -data[i]);
+        }
+    }
+    else {
+        m_tableMinimum.resize(columns);
+        m_tableMaximum.resize(columns);
+        pyramid.columnRange(0, samplesPerColumn, columns,
+                            m_tableMinimum.data(), m_tableMaximum.data());
+        path.moveTo(0.5 * samplesPerColumn, -m_tableMaximum[0]);
+        path.lineTo(0.5 * samplesPerColumn, -m_tableMinimum[0]);
+        for (int c = 1; c < columns; c++) {
+            double x = (c + 0.5) * samplesPerColumn;
+            path.lineTo(x, -m_tableMaximum[c]);
+            path.lineTo(x, -m_tableMinimum[c]);
+        }
+    }
+    lod->item->setPath(path);
+    lod->drawnVersion = lod->version;
+    lod->drawnColumns = columns;
+}
+
+void QuteGraph::tablePyramidReady()
+{
+    for (int i = 0; i < m_tableLods.size(); i++) {
+        TableLod *lod = m_tableLods[i];
+        if (lod != nullptr && &lod->watcher == sender()) {
+            lod->pyramid = lod->watcher.result();
+            lod->version = lod->pendingVersion;
+            lod->pendingVersion = 0;
+            if (i == m_currentIndex) {
+                drawGraph(curves[i], i);  // Also starts a new build if the table changed meanwhile
+            }
+            return;
+        }
     }
-    scene->clear();
-    scene->addPath(path, pen);
 }
 
 
@@ -672,7 +852,7 @@ void QuteGraph::drawFtable(Curve * curve, int index)
     if (caption.isEmpty()) {
         return;
     }
-    QGraphicsScene *scene = static_cast<QGraphicsView *>(static_cast<StackedLayoutWidget *>(m_widget)->widget(index))->scene();
+    QGraphicsScene *scene = getScene(index);
     double max = curve->get_max();
     max = max == 0 ? 1: max;
     int size = (int) curve->get_size();
@@ -708,7 +888,7 @@ void QuteGraph::drawFtable(Curve * curve, int index)
 
 void QuteGraph::drawSpectrumPath(Curve *curve, int index) {
     int curveSize = curve->get_size();
-    QGraphicsScene *scene = static_cast<QGraphicsView *>(static_cast<StackedLayoutWidget *>(m_widget)->widget(index))->scene();
+    QGraphicsScene *scene = getScene(index);
     QPainterPath path;
 
     double db0 = m_ud->zerodBFS;
@@ -746,20 +926,91 @@ void QuteGraph::drawSpectrumPath(Curve *curve, int index) {
 }
 
 
+void QuteGraph::setSpectrumGridLabels(int index, double logSampleRate) {
+    int numTicksX = 12;
+    m_gridLabelRate[index] = logSampleRate;
+    for (int i = 1; i < numTicksX; i++) {
+        double kHz;
+        if (logSampleRate > 0) {
+            double nyquist = logSampleRate / 2;
+            double position = i / double(numTicksX);
+            kHz = QCS_SPECTRUM_MIN_FREQUENCY
+                    * std::pow(nyquist / QCS_SPECTRUM_MIN_FREQUENCY, position) / 1000;
+        }
+        else {
+            kHz = i*((numTicksX-1.0)/numTicksX) * 2.0;
+        }
+        m_gridtext[index][i]->setHtml(QString("<div style=\"background:#000000;\">%1k</p>"
+                                              ).arg(kHz, 2, 'f', kHz < 1 ? 2 : 1));
+    }
+}
+
+// Large spectra are reduced to one point per pixel column before converting
+// to dB, keeping the largest bin of each column, so the cost follows the
+// width of the graph rather than the FFT size. With QCS_modex set to "log"
+// the columns are spaced logarithmically in frequency.
 void QuteGraph::drawSpectrum(Curve *curve, int index) {
     int curveSize = curve->get_size();
-    QVector<QPointF> polygonPoints;
-    polygonPoints.resize(curveSize + 2);
+    if (curveSize < 2) {
+        return;
+    }
+    const MYFLT *data = curve->get_data();
+    double zoomx = property("QCS_zoomx").toDouble();
+    int columns = qMax(1, (int) (m_view->viewport()->width() * zoomx));
+    double sampleRate = m_ud != nullptr ? m_ud->sampleRate : 0;
+    bool logx = property("QCS_modex").toString() == "log" && sampleRate > 0;
+    double db0 = m_ud != nullptr ? m_ud->zerodBFS : 1.0;
+
+    int points;
+    double step; // Scene units (bins) per point
+    double offset;
+    if (!logx && columns >= curveSize) {
+        points = curveSize;
+        step = 1;
+        offset = 0;
+        m_spectrumDb.resize(points);
+        float *out = m_spectrumDb.data();
+        for (int i = 0; i < points; i++) {
+            out[i] = (float) fabs(data[i]);
+        }
+    }
+    else {
+        points = columns;
+        step = curveSize / double(columns);
+        offset = step / 2;
+        m_spectrumBins.resize(curveSize);
+        double *bins = m_spectrumBins.data();
+        for (int i = 0; i < curveSize; i++) {
+            bins[i] = fabs(data[i]);
+        }
+        // Only the ratio to the sample rate matters on a linear axis
+        m_spectrumScale.setup(columns, curveSize, logx ? sampleRate : 2.0 * curveSize, logx);
+        m_spectrumColumns.resize(columns);
+        m_spectrumScale.map(bins, m_spectrumColumns.data());
+        m_spectrumDb.resize(points);
+        for (int i = 0; i < points; i++) {
+            m_spectrumDb[i] = (float) m_spectrumColumns[i];
+        }
+    }
+    magnitudesToDb(m_spectrumDb.data(), points, (float) db0, QCS_SPECTRUM_FLOOR_DB);
+
+    // Drop the item's reference first, so the polygon is refilled in place
+    // instead of detaching
+    polygons[index]->setPolygon(QPolygonF());
+    m_spectrumPolygon.resize(points + 2);
+    QPointF *polygonPoints = m_spectrumPolygon.data();
+    const float *db = m_spectrumDb.constData();
     polygonPoints[0] = QPointF(0,110);
-    double db0 = m_ud->zerodBFS;
-
-    for (int i = 0; i < (int) curveSize; i++) {
-        double value = 20.0*log10(fabs(curve->get_data(i))/db0);
-        polygonPoints[i+1] = QPointF(i, -value); //skip first item, which is base line
+    for (int i = 0; i < points; i++) {
+        polygonPoints[i + 1] = QPointF(i * step + offset, -db[i]); //skip first item, which is base line
     }
+    polygonPoints[points + 1] = QPointF(curveSize - 1,110);
+    polygons[index]->setPolygon(m_spectrumPolygon);
 
-    polygonPoints.back() = QPointF(curveSize - 1,110);
-    polygons[index]->setPolygon(QPolygonF(polygonPoints));
+    double labelRate = logx ? sampleRate : 0;
+    if (m_gridLabelRate[index] != labelRate) {
+        setSpectrumGridLabels(index, labelRate);
+    }
 
     // m_pageComboBox->setItemText(index, curve->get_caption());
     // draw Grid
@@ -799,7 +1050,7 @@ void QuteGraph::drawSpectrum(Curve *curve, int index) {
 void QuteGraph::drawSignalPath(Curve *curve, int index) {
     int curveSize = curve->get_size();
     QPainterPath path;
-    auto zerodbfs = m_ud->zerodBFS;
+    auto zerodbfs = m_ud != nullptr ? m_ud->zerodBFS : 1.0;  // Can be drawn before the engine sets m_ud
     for(int i=0; i<curveSize; i++) {
         auto value = curve->get_data(i)/zerodbfs;
         path.lineTo(i, value);
@@ -808,9 +1059,10 @@ void QuteGraph::drawSignalPath(Curve *curve, int index) {
     grid.moveTo(0, 0);
     grid.lineTo(curveSize, 0);
 
-    QGraphicsScene *scene = static_cast<QGraphicsView *>(static_cast<StackedLayoutWidget *>(m_widget)->widget(index))->scene();
+    QGraphicsScene *scene = getScene(index);
     auto pen = QPen(QColor(255, 193, 7), 0);
     scene->clear();
+    polygons[index] = nullptr;  // Deleted by clear()
     scene->addPath(grid, QPen(QColor(40, 40, 40), 0));
     scene->addPath(path, pen);
 }
@@ -845,7 +1097,7 @@ void QuteGraph::scaleGraph(int index)
 	//  double span = max - min;
     //  FIXME implement dispx, dispy and modex, modey
     int size = curve->get_size();
-    auto view = (QGraphicsView *) static_cast<StackedLayoutWidget *>(m_widget)->currentWidget();
+    auto view = m_view;
 	//  view->setResizeAnchor(QGraphicsView::NoAnchor);
     auto graphType = graphtypes[index];
     if(graphType == GraphType::GRAPH_FTABLE && max != min) {
@@ -878,21 +1130,7 @@ int QuteGraph::getTableNumForIndex(int index) {
 
 int QuteGraph::getIndexForTableNum(int ftable)
 {
-	int index = -1;
-	for (int i = 0; i < curves.size(); i++) {
-		QString text = curves[i]->get_caption();
-		if (text.contains("ftable")) {
-			QStringList parts = text.split(QRegExp("[ :]"), QString::SkipEmptyParts);
-            if (parts.size() > 1) {
-				int num = parts.last().toInt();
-				if (ftable == num) {
-					index = i;
-					break;
-				}
-			}
-		}
-	}
-	return index;
+	return m_tableIndex.value(ftable, -1);
 }
 
 void QuteGraph::setInternalValue(double value)
@@ -913,10 +1151,11 @@ void QuteTableWidget::reset() {
     m_tabsize = 0;
     if(m_autorange)
         m_maxy = 1.0;
-    if(m_path != nullptr) {
-        delete m_path;
-        m_path = nullptr;
-    }
+    m_path = QPainterPath();
+    m_version = 0;
+    m_columnMinimum.clear();
+    m_columnMaximum.clear();
+    m_columnsTabsize = 0;
 }
 
 void QuteTableWidget::paintGrid(QPainter *painter) {
@@ -983,18 +1222,25 @@ void QuteTableWidget::paintEvent(QPaintEvent *event) {
     painter.setBrush(QColor(24, 24, 24));
     painter.drawRect(this->rect());
     painter.setBrush(Qt::NoBrush);
-    if(m_path == nullptr)
-        return;
     mutex.lock();
+    if(m_path.isEmpty()) {
+        mutex.unlock();
+        return;
+    }
     if(m_showGrid) {
         this->paintGrid(&painter);
     }
     painter.setPen(QPen(m_color, 0));
-    painter.drawPath(*m_path);
+    painter.drawPath(m_path);
 
     mutex.unlock();
 }
 
+void QuteTableWidget::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    updatePath();  // The columns depend on the width
+}
+
 void QuteTableWidget::setRange(double maxy) {
     if(maxy == 0.0) {
         m_autorange = true;
@@ -1004,8 +1250,14 @@ void QuteTableWidget::setRange(double maxy) {
     }
 }
 
-void QuteTableWidget::updatePath() {
-    if(m_tabnum <= 0 && m_data == nullptr)
+// Only the samples between first and last are read again. Tables wider
+// than the widget are drawn as one vertical min/max segment per pixel
+// column, cached between updates, so the path never has more points than
+// the widget has pixels. The column cache is shared by every caller
+// (refresh, resize, "@set"), so the whole update holds the mutex.
+void QuteTableWidget::updatePath(int first, int last) {
+    QMutexLocker locker(&mutex);
+    if(m_tabnum <= 0 || m_data == nullptr || m_tabsize <= 0)
         return;
     if(csoundEngineStatus(m_ud) != CsoundEngineStatus::Running)
         return;
@@ -1013,35 +1265,89 @@ void QuteTableWidget::updatePath() {
     auto rect = this->rect();
     auto width = rect.width() - margin*2;
     auto height = rect.height() - margin*2;
+    if(width <= 0)
+        return;
     double maxy = this->m_maxy;
     double newmaxy = maxy;
     double xscale = width / (double)m_tabsize;
     double yscale = height * 0.5 / maxy;
     double y0 = rect.y() + margin;
     double x0 = rect.x() + margin;
-    int step = m_tabsize / width;
-    if(step == 0)
-        step = 1;
 
-    auto path = new QPainterPath();
-    double ydata = m_data[0];
-    path->moveTo(x0, (ydata+maxy)*yscale+y0);
-    for(int i=0; i < m_tabsize; i+=step) {
-        ydata = m_data[i];
-        double x2 = i*xscale + x0;
-        double y2 = (ydata+maxy)*yscale + y0;
-        path->lineTo(x2, y2);
-        if(ydata > newmaxy)
-            newmaxy = ydata;
+    QPainterPath path;
+    if(m_tabsize <= width) {
+        double ydata = m_data[0];
+        path.moveTo(x0, (ydata+maxy)*yscale+y0);
+        for(int i=0; i < m_tabsize; i++) {
+            ydata = m_data[i];
+            path.lineTo(i*xscale + x0, (ydata+maxy)*yscale + y0);
+            if(ydata > newmaxy)
+                newmaxy = ydata;
+        }
+    } else {
+        if(m_columnMinimum.size() != width || m_columnsTabsize != m_tabsize) {
+            m_columnMinimum.resize(width);
+            m_columnMaximum.resize(width);
+            m_columnsTabsize = m_tabsize;
+            first = 0;
+            last = INT_MAX;
+        }
+        first = qMax(first, 0);
+        last = qMin(last, m_tabsize - 1);
+        int firstColumn = (int)((qint64)first * width / m_tabsize);
+        int lastColumn = (int)((qint64)last * width / m_tabsize);
+        for(int c = firstColumn; c <= lastColumn; c++) {
+            int start = (int)((qint64)c * m_tabsize / width);
+            int end = qMax(start + 1, (int)((qint64)(c + 1) * m_tabsize / width));
+            MYFLT low = m_data[start];
+            MYFLT high = m_data[start];
+            for(int i = start + 1; i < end; i++) {
+                low = qMin(low, m_data[i]);
+                high = qMax(high, m_data[i]);
+            }
+            m_columnMinimum[c] = low;
+            m_columnMaximum[c] = high;
+        }
+        const MYFLT *low = m_columnMinimum.constData();
+        const MYFLT *high = m_columnMaximum.constData();
+        path.moveTo(x0, (high[0]+maxy)*yscale+y0);
+        for(int c = 0; c < width; c++) {
+            double x = c + x0;
+            path.lineTo(x, (high[c]+maxy)*yscale + y0);
+            path.lineTo(x, (low[c]+maxy)*yscale + y0);
+            if(high[c] > newmaxy)
+                newmaxy = high[c];
+        }
     }
-    mutex.lock();
     if(m_autorange) {
         m_maxy = ceil(newmaxy);
     }
-    if(m_path != nullptr)
-        delete m_path;
     m_path = path;
-    mutex.unlock();
+}
+
+void QuteTableWidget::updateChanges() {
+    if(m_tabnum <= 0 || m_data == nullptr || m_ud == nullptr)
+        return;
+    int first, last;
+    quint64 version = m_ud->tableChanges->changedRange(m_tabnum, m_version, &first, &last);
+    if(version == m_version)
+        return;
+    m_version = version;
+    if(first <= 0 && last >= m_tabsize - 1) {
+        // The table may have been replaced, get it again
+        MYFLT *data;
+        int tabsize = csoundGetTable(m_ud->csound, &data, m_tabnum);
+        if(tabsize == 0 || data == nullptr) {
+            qDebug() << "Table" << m_tabnum << "not found";
+            return;
+        }
+        mutex.lock();
+        m_data = data;
+        m_tabsize = tabsize;
+        mutex.unlock();
+    }
+    this->updatePath(first, last);
+    this->update();
 }
 
 void QuteTableWidget::updateData(int tabnum, bool check) {
@@ -1054,8 +1360,7 @@ void QuteTableWidget::updateData(int tabnum, bool check) {
             qDebug() << "Table not set, can't update";
             return;
         }
-        this->updatePath();
-        this->update();
+        this->updateChanges();
         return;
     }
     // Asked to change table ( or set for the first time )
@@ -1073,6 +1378,8 @@ void QuteTableWidget::updateData(int tabnum, bool check) {
         m_maxy = 1.0;
     }
     m_tabnum = tabnum;
+    m_version = m_ud->tableChanges->version(tabnum);
+    m_columnsTabsize = 0;  // Read the whole table
     mutex.unlock();
     this->updatePath();
     this->update();
@@ -1090,6 +1397,7 @@ QuteTable::QuteTable(QWidget *parent) : QuteWidget(parent) {
     m_widget = new QuteTableWidget(this);
     m_value = 0;
     m_tabnum = 0;
+    m_pendingUpdate.store(QCS_TABLE_NO_UPDATE, std::memory_order_relaxed);
     // auto w = static_cast<QuteTableWidget*>(m_widget);
     setProperty("QCS_randomizable", false);
     m_widget->setContextMenuPolicy(Qt::NoContextMenu);
@@ -1276,6 +1584,34 @@ void QuteTable::setValue(double value) {
 
 };
 
+void QuteTable::updateData() {
+    QMutexLocker locker(&mutex);
+    quint64 pending = m_pendingUpdate.exchange(QCS_TABLE_NO_UPDATE, std::memory_order_acquire);
+    if(m_tabnum <= 0 || csoundEngineStatus(m_csoundUserData) != CsoundEngineStatus::Running)
+        return;
+    int first = (int)(pending >> 32);
+    int last = (int)(pending & 0xFFFFFFFF);
+    if(first <= last) {
+        m_csoundUserData->tableChanges->markDirty(m_tabnum, first, last);
+    }
+    static_cast<QuteTableWidget*>(m_widget)->updateChanges();
+}
+
+// "@update" usually comes from the performance thread, which must not lock
+// or allocate in TableChanges. The range is merged here without locking
+void QuteTable::queueUpdate(int first, int last) {
+    first = qMax(first, 0);
+    last = qMax(last, 0);
+    quint64 pending = m_pendingUpdate.load(std::memory_order_relaxed);
+    quint64 merged;
+    do {
+        int pendingFirst = (int)(pending >> 32);
+        int pendingLast = (int)(pending & 0xFFFFFFFF);
+        merged = ((quint64)qMin(first, pendingFirst) << 32) | (quint32)qMax(last, pendingLast);
+    } while(!m_pendingUpdate.compare_exchange_weak(pending, merged, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+}
+
 void QuteTable::setValue(QString s) {
     if(s.isEmpty())
         return;
@@ -1290,7 +1626,15 @@ void QuteTable::setValue(QString s) {
         int tabnum = parts[1].toInt();
         setValue((double)tabnum);
     } else if (parts[0] == "@update") {
-        setValue(-1);
+        // "@update" for the whole table, "@update first last" for the indexes changed.
+        // Redrawn by updateData() on the next GUI refresh
+        if(m_tabnum > 0) {
+            if(parts.size() == 3) {
+                queueUpdate(parts[1].toInt(), parts[2].toInt());
+            } else {
+                queueUpdate(0, INT_MAX);
+            }
+        }
     } else
         qDebug() << "Message not supported:" << s;
 }
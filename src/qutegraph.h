@@ -26,9 +26,17 @@
 #include "qutewidget.h"
 #include "csoundengine.h"  //necessary for the CsoundUserData struct
 #include "selectcolorbutton.h"
+#include "spectrumworker.h"  // For SpectrumScale
+#include "tablepyramid.h"
+
+#include <QFutureWatcher>
+#include <atomic>
 
 class Curve;
 
+// Pending "@update" range of a QuteTable, first << 32 | last. first > last when empty
+#define QCS_TABLE_NO_UPDATE (Q_UINT64_C(0x7FFFFFFF) << 32)
+
 enum GraphType { GRAPH_FTABLE=1, GRAPH_AUDIOSIGNAL=2, GRAPH_SPECTRUM=3 };
 
 
@@ -78,7 +86,12 @@ protected:
     QCheckBox *showSelectorCheckBox;
     QCheckBox *showGridCheckBox;
     QCheckBox *showTableInfoCheckBox;
+    QCheckBox *logFrequencyCheckBox;
 	QVector<Curve *> curves;
+	QGraphicsView *m_view;              // Shared by all curves
+	int m_currentIndex;                 // Curve whose scene is shown, -1 if none
+	QVector<QGraphicsScene *> m_scenes; // Per curve, nullptr until first shown
+	QVector<quint64> m_drawnVersion;    // Curve version last drawn in its scene
 	QVector<QVector <QGraphicsLineItem *> > lines;
 	QVector<QGraphicsPolygonItem *> polygons;
     QVector<QPainterPath *>painterPaths;
@@ -86,6 +99,10 @@ protected:
 
 	QVector<QVector <QGraphicsLineItem *> > m_gridlines;
 	QVector<QVector <QGraphicsTextItem *> > m_gridtext;
+    QVector<double> m_gridLabelRate; // Sample rate of log frequency labels, 0 for linear
+    QHash<Curve *, int> m_curveIndex;
+    QHash<int, int> m_tableIndex;    // Index of the first curve for each ftable number
+    Curve *m_shownCurve;
 
     QPainterPath *gridPath;
 
@@ -98,12 +115,16 @@ public slots:
 	void changeCurve(int index);
 	void indexChanged(int index);
 
+private slots:
+    void tablePyramidReady();
+
 private:
 	void drawFtable(Curve * curve, int index);
     void drawFtablePath(Curve * curve, int index);
 
     void drawSpectrum(Curve * curve, int index);
     void drawSpectrumPath(Curve * curve, int index);
+    void setSpectrumGridLabels(int index, double logSampleRate);
 
     void drawSignal(Curve * curve, int index);
     void drawSignalPath(Curve * curve, int index);
@@ -114,7 +135,7 @@ private:
 	void setInternalValue(double value);
     void drawGraph(Curve *curve, int index);
 
-    QGraphicsView* getView(int index);
+    QGraphicsScene *getScene(int index);
 
 	//    QMutex curveLock;
 	bool m_grid;
@@ -123,8 +144,30 @@ private:
     bool m_drawGrid;
     bool m_drawTableInfo;
 
+    // Reused by drawSpectrum(), only the curve shown is drawn
+    SpectrumScale m_spectrumScale;
+    QVector<double> m_spectrumBins;
+    QVector<double> m_spectrumColumns;
+    QVector<float> m_spectrumDb;
+    QPolygonF m_spectrumPolygon;
+
+    // Level of detail for ftable graphs, created when the table is first drawn
+    struct TableLod {
+        TableLod() : version(0), pendingVersion(0), drawnVersion(0), drawnColumns(0), item(nullptr) {}
+        TablePyramid pyramid;
+        quint64 version;        // Curve version the pyramid holds
+        quint64 pendingVersion; // Curve version being built on a worker, 0 if none
+        quint64 drawnVersion;   // Pyramid version and column count of the path shown
+        int drawnColumns;
+        QFutureWatcher<TablePyramid> watcher;
+        QGraphicsPathItem *item;
+    };
+    QVector<TableLod *> m_tableLods;
+    QVector<MYFLT> m_tableMinimum;
+    QVector<MYFLT> m_tableMaximum;
+
 signals:
-    void requestUpdateCurve(Curve *curve);
+    void showingCurve(QuteGraph *graph, Curve *curve);  // curve is nullptr when cleared
 
 };
 
@@ -144,15 +187,6 @@ public:
 		setMaximumSize(width, height);
 	}
 
-	void clearCurves()
-	{
-		QWidget *widget;
-		widget = currentWidget();
-		while (widget != 0) {
-			removeWidget(widget);
-			widget = currentWidget();
-		}
-	}
 	/*
   protected:
 	virtual void contextMenuEvent(QContextMenuEvent *event)
@@ -181,14 +215,16 @@ public:
         , m_margin(8)
         , m_maxy(1.0)
         , m_autorange(true)
-        , m_path(nullptr)
         , m_showGrid(true)
+        , m_version(0)
+        , m_columnsTabsize(0)
     {}
     virtual ~QuteTableWidget() override;
     void setUserData(CsoundUserData *ud) { m_ud = ud; }
     void updateData(int tabnum, bool check=true);
+    void updateChanges(); // Redraws what changed since the last update, see TableChanges
     int currentTableNumber() { return m_tabnum; }
-    void updatePath();
+    void updatePath(int first = 0, int last = INT_MAX);
     void setColor(QColor color) { m_color = color; }
     void setRange(double maxy=1.0);
     void showGrid(bool show) { m_showGrid = show; }
@@ -197,6 +233,7 @@ public:
 
 protected:
     virtual void paintEvent(QPaintEvent *event) override;
+    virtual void resizeEvent(QResizeEvent *event) override;
 
 private:
     int m_tabnum;
@@ -208,9 +245,14 @@ private:
     int m_margin;
     double m_maxy;
     bool m_autorange;
-    QPainterPath *m_path;
+    QPainterPath m_path;
     QMutex mutex;
     bool m_showGrid;
+    quint64 m_version;  // Of the table in TableChanges when last read
+    // Range of the samples under each pixel column, for tables larger than the widget
+    QVector<MYFLT> m_columnMinimum;
+    QVector<MYFLT> m_columnMaximum;
+    int m_columnsTabsize;
 
 // public slot:
 
@@ -235,12 +277,16 @@ public:
     virtual void setValue(double value);
     virtual void setValue(QString s);
     virtual void setColor(QColor color);
+    void updateData(); // Called on every GUI refresh, redraws tables written by the host
 
 public slots:
     void onStop();
 
 private:
+    void queueUpdate(int first, int last);
+
     int m_tabnum;
+    std::atomic<quint64> m_pendingUpdate; // Marked in TableChanges by updateData()
 
 protected:
     // virtual void mousePressEvent(QMouseEvent *event);
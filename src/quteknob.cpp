@@ -173,6 +173,16 @@ void QuteKnob::setMidiValue(int value)
 	emit newValue(channelValue);
 }
 
+void QuteKnob::setMidiValue14(int value)
+{
+	double max = property("QCS_maximum").toDouble();
+	double min = property("QCS_minimum").toDouble();
+	double newval = min + ((value / 16383.0)* (max - min));
+	setValue(newval);
+	QPair<QString, double> channelValue(m_channel, newval);
+	emit newValue(channelValue);
+}
+
 void QuteKnob::refreshWidget()
 {
 #ifdef  USE_WIDGET_MUTEX
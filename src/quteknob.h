@@ -134,6 +134,7 @@ public:
     //    virtual void setResolution(double resolution);
 	void setRange(double min, double max);
 	virtual void setMidiValue(int value);
+	virtual void setMidiValue14(int value);
 	virtual bool acceptsMidi() {return true;}
 
 	virtual void refreshWidget();
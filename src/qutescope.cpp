@@ -25,6 +25,11 @@
 #include "types.h"  //necessary for the userdata struct
 #include "qutecsound.h"  //necessary for the userdata struct
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QCS_SCOPE_SSE2
+#endif
+
 
 QuteScope::QuteScope(QWidget *parent) : QuteWidget(parent)
 {
@@ -73,6 +78,13 @@ QuteScope::QuteScope(QWidget *parent) : QuteWidget(parent)
 	setProperty("QCS_dispx", 1.0);
 	setProperty("QCS_dispy", 1.0);
 	setProperty("QCS_mode", "lin");
+	setProperty("QCS_trigger", "free");
+	setProperty("QCS_triggerslope", "rising");
+	setProperty("QCS_triggerlevel", 0.0);
+	setProperty("QCS_hysteresis", 0.01);
+	setProperty("QCS_holdoff", 0.0);
+	setProperty("QCS_pretrigger", 10.0);
+	setProperty("QCS_interpolate", false);
 }
 
 QuteScope::~QuteScope()
@@ -116,6 +128,13 @@ QString QuteScope::getWidgetXmlText()
 	s.writeTextElement("dispx", QString::number(property("QCS_dispx").toDouble(), 'f', 8));
 	s.writeTextElement("dispy", QString::number(property("QCS_dispy").toDouble(), 'f', 8));
     s.writeTextElement("mode",  QString::number(property("QCS_mode").toDouble(), 'f', 8));
+	s.writeTextElement("trigger", property("QCS_trigger").toString());
+	s.writeTextElement("triggerslope", property("QCS_triggerslope").toString());
+	s.writeTextElement("triggerlevel", QString::number(property("QCS_triggerlevel").toDouble(), 'f', 8));
+	s.writeTextElement("hysteresis", QString::number(property("QCS_hysteresis").toDouble(), 'f', 8));
+	s.writeTextElement("holdoff", QString::number(property("QCS_holdoff").toDouble(), 'f', 8));
+	s.writeTextElement("pretrigger", QString::number(property("QCS_pretrigger").toDouble(), 'f', 8));
+	s.writeTextElement("interpolate", property("QCS_interpolate").toBool() ? "true" : "false");
 
 	s.writeEndElement();
 #ifdef  USE_WIDGET_MUTEX
@@ -176,6 +195,15 @@ void QuteScope::applyInternalProperties()
 	QuteWidget::applyInternalProperties();
 	setType(property("QCS_type").toString());
 	setValue(property("QCS_value").toDouble());
+	// Loaded properties are strings, QVariant converts them
+	m_scopeData->setTrigger(ScopeTrigger::modeFromName(property("QCS_trigger").toString()),
+							property("QCS_triggerslope").toString() == "falling" ?
+								ScopeTrigger::Falling : ScopeTrigger::Rising,
+							property("QCS_triggerlevel").toDouble(),
+							property("QCS_hysteresis").toDouble(),
+							property("QCS_holdoff").toDouble(),
+							property("QCS_pretrigger").toDouble() / 100.0,
+							property("QCS_interpolate").toBool());
 }
 
 void QuteScope::createPropertiesDialog()
@@ -220,6 +248,53 @@ void QuteScope::createPropertiesDialog()
 	zoomyBox = new QDoubleSpinBox(dialog);
 	zoomyBox->setRange(1, 20);
 	layout->addWidget(zoomyBox, 8, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Trigger"));
+	layout->addWidget(label, 9, 0, Qt::AlignRight|Qt::AlignVCenter);
+	triggerModeBox = new QComboBox(dialog);
+	triggerModeBox->addItem(tr("Free running"), QVariant(ScopeTrigger::modeName(ScopeTrigger::Free)));
+	triggerModeBox->addItem(tr("Auto"), QVariant(ScopeTrigger::modeName(ScopeTrigger::Auto)));
+	triggerModeBox->addItem(tr("Normal"), QVariant(ScopeTrigger::modeName(ScopeTrigger::Normal)));
+	triggerModeBox->addItem(tr("Single"), QVariant(ScopeTrigger::modeName(ScopeTrigger::Single)));
+	triggerModeBox->setToolTip(tr("Oscilloscope only. In single mode, click the scope to wait for a new sweep"));
+	layout->addWidget(triggerModeBox, 9, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Slope"));
+	layout->addWidget(label, 9, 2, Qt::AlignRight|Qt::AlignVCenter);
+	triggerSlopeBox = new QComboBox(dialog);
+	triggerSlopeBox->addItem(tr("Rising"), QVariant(QString("rising")));
+	triggerSlopeBox->addItem(tr("Falling"), QVariant(QString("falling")));
+	layout->addWidget(triggerSlopeBox, 9, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Level"));
+	layout->addWidget(label, 10, 0, Qt::AlignRight|Qt::AlignVCenter);
+	triggerLevelBox = new QDoubleSpinBox(dialog);
+	triggerLevelBox->setRange(-1, 1);
+	triggerLevelBox->setDecimals(3);
+	triggerLevelBox->setSingleStep(0.01);
+	layout->addWidget(triggerLevelBox, 10, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Hysteresis"));
+	layout->addWidget(label, 10, 2, Qt::AlignRight|Qt::AlignVCenter);
+	hysteresisBox = new QDoubleSpinBox(dialog);
+	hysteresisBox->setRange(0, 1);
+	hysteresisBox->setDecimals(3);
+	hysteresisBox->setSingleStep(0.01);
+	layout->addWidget(hysteresisBox, 10, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Holdoff (ms)"));
+	layout->addWidget(label, 11, 0, Qt::AlignRight|Qt::AlignVCenter);
+	holdoffBox = new QDoubleSpinBox(dialog);
+	holdoffBox->setRange(0, 1000);
+	layout->addWidget(holdoffBox, 11, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Pre-trigger (%)"));
+	layout->addWidget(label, 11, 2, Qt::AlignRight|Qt::AlignVCenter);
+	pretriggerBox = new QDoubleSpinBox(dialog);
+	pretriggerBox->setRange(0, 100);
+	layout->addWidget(pretriggerBox, 11, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	interpolateCheckBox = new QCheckBox(tr("Sub-sample trigger position"), dialog);
+	layout->addWidget(interpolateCheckBox, 12, 1, 1, 2, Qt::AlignLeft|Qt::AlignVCenter);
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.lockForRead();
 #endif
@@ -227,6 +302,13 @@ void QuteScope::createPropertiesDialog()
 	channelBox->setCurrentIndex(channelBox->findData(QVariant((int) m_value)));
 	zoomxBox->setValue(property("QCS_zoomx").toDouble());
 	zoomyBox->setValue(property("QCS_zoomy").toDouble());
+	triggerModeBox->setCurrentIndex(qMax(0, triggerModeBox->findData(property("QCS_trigger").toString())));
+	triggerSlopeBox->setCurrentIndex(qMax(0, triggerSlopeBox->findData(property("QCS_triggerslope").toString())));
+	triggerLevelBox->setValue(property("QCS_triggerlevel").toDouble());
+	hysteresisBox->setValue(property("QCS_hysteresis").toDouble());
+	holdoffBox->setValue(property("QCS_holdoff").toDouble());
+	pretriggerBox->setValue(property("QCS_pretrigger").toDouble());
+	interpolateCheckBox->setChecked(property("QCS_interpolate").toBool());
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.unlock();
 #endif
@@ -241,6 +323,13 @@ void QuteScope::applyProperties()
 	setProperty("QCS_zoomx", zoomxBox->value());
 	setProperty("QCS_zoomy", zoomyBox->value());
 	setProperty("QCS_value", channelBox->itemData(channelBox->currentIndex()).toInt());
+	setProperty("QCS_trigger", triggerModeBox->itemData(triggerModeBox->currentIndex()).toString());
+	setProperty("QCS_triggerslope", triggerSlopeBox->itemData(triggerSlopeBox->currentIndex()).toString());
+	setProperty("QCS_triggerlevel", triggerLevelBox->value());
+	setProperty("QCS_hysteresis", hysteresisBox->value());
+	setProperty("QCS_holdoff", holdoffBox->value());
+	setProperty("QCS_pretrigger", pretriggerBox->value());
+	setProperty("QCS_interpolate", interpolateCheckBox->isChecked());
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.unlock();
 #endif
@@ -301,18 +390,112 @@ void ScopeItem::setSize(int width, int height)
 	prepareGeometryChange();
 }
 
+ScopeTraceItem::ScopeTraceItem(int width, int height)
+{
+	m_width = width;
+	m_height = height;
+}
+
+void ScopeTraceItem::paint(QPainter *p,
+						   const QStyleOptionGraphicsItem */*option*/,
+						   QWidget */*widget*/)
+{
+	p->setPen(m_pen);
+	p->drawPolyline(m_vertices.constData(), m_vertices.size());
+}
+
+void ScopeTraceItem::setPen(const QPen & pen)
+{
+	m_pen = pen;
+}
+
+void ScopeTraceItem::setSize(int width, int height)
+{
+	prepareGeometryChange();
+	m_width = width;
+	m_height = height;
+}
+
+// ud without an engine is fed directly by the host (e.g. the benchmarks)
+static bool canUpdate(CsoundUserData *ud)
+{
+	return ud != 0 && (ud->csEngine == 0 || ud->csEngine->isRunning());
+}
+
+// Minimum and maximum of each group of perColumn consecutive values
+static void columnMinMax(const MYFLT *data, int columns, int perColumn,
+						 MYFLT *minimum, MYFLT *maximum)
+{
+	for (int c = 0; c < columns; c++) {
+		const MYFLT *p = data + c * perColumn;
+		MYFLT low = p[0];
+		MYFLT high = p[0];
+		int i = 1;
+#ifdef QCS_SCOPE_SSE2
+#ifdef USE_DOUBLE
+		if (perColumn >= 4) {
+			__m128d vlow = _mm_loadu_pd(p);
+			__m128d vhigh = vlow;
+			for (i = 2; i + 2 <= perColumn; i += 2) {
+				__m128d v = _mm_loadu_pd(p + i);
+				vlow = _mm_min_pd(vlow, v);
+				vhigh = _mm_max_pd(vhigh, v);
+			}
+			double l[2], h[2];
+			_mm_storeu_pd(l, vlow);
+			_mm_storeu_pd(h, vhigh);
+			low = qMin(l[0], l[1]);
+			high = qMax(h[0], h[1]);
+		}
+#else
+		if (perColumn >= 8) {
+			__m128 vlow = _mm_loadu_ps(p);
+			__m128 vhigh = vlow;
+			for (i = 4; i + 4 <= perColumn; i += 4) {
+				__m128 v = _mm_loadu_ps(p + i);
+				vlow = _mm_min_ps(vlow, v);
+				vhigh = _mm_max_ps(vhigh, v);
+			}
+			float l[4], h[4];
+			_mm_storeu_ps(l, vlow);
+			_mm_storeu_ps(h, vhigh);
+			low = qMin(qMin(l[0], l[1]), qMin(l[2], l[3]));
+			high = qMax(qMax(h[0], h[1]), qMax(h[2], h[3]));
+		}
+#endif
+#endif
+		for (; i < perColumn; i++) {
+			low = qMin(low, p[i]);
+			high = qMax(high, p[i]);
+		}
+		minimum[c] = low;
+		maximum[c] = high;
+	}
+}
+
 ScopeData::ScopeData(ScopeParams *params) : DataDisplay(params)
 {
-	curveData.resize(m_params->width + 2);
-	curve = new QGraphicsPolygonItem(/*&curveData*/);
-    curve->setPen(QPen(Qt::green, 0));
+	curve = new ScopeTraceItem(m_params->width, m_params->height);
+	curve->setPen(QPen(Qt::green, 0));
 	curve->hide();
 	m_params->scene->addItem(curve);
+	m_readPosition = 0;
+	m_triggerChannel = 0;
+	m_holdoffMs = 0;
+	m_pretrigger = 0.1;
 }
 
 void ScopeData::resize()
 {
-	curveData.resize(m_params->width + 2);
+	curve->setSize(m_params->width, m_params->height);
+}
+
+void ScopeData::setTrigger(int mode, int slope, double level, double hysteresis,
+						   double holdoffMs, double pretrigger, bool interpolate)
+{
+	m_trigger.setMode(mode, slope, level, hysteresis, interpolate);
+	m_holdoffMs = holdoffMs;
+	m_pretrigger = qBound(0.0, pretrigger, 1.0);
 }
 
 void ScopeData::updateData(int channel, double zoomx, double zoomy, bool freeze)
@@ -320,14 +503,16 @@ void ScopeData::updateData(int channel, double zoomx, double zoomy, bool freeze)
 	CsoundUserData *ud = m_params->ud;
 	int width = m_params->width;
 	int height = m_params->height;
-    if (ud == 0 || !ud->csEngine->isRunning() )
+    if (!canUpdate(ud))
 		return;
+	if (m_params->widget->rearm) {
+		m_params->widget->rearm = false;
+		m_trigger.arm();
+	}
 	if (freeze)
 		return;
-	double value;
 	int numChnls = ud->numChnls;
-	MYFLT newValue;
-    if (channel == 0 || channel > numChnls ) {
+    if (channel == 0 || channel > numChnls || width <= 0) {
         return;
 	}
 	channel = (channel < 0 ? -1: channel - 1);
@@ -336,47 +521,109 @@ void ScopeData::updateData(int channel, double zoomx, double zoomy, bool freeze)
     QReadWriteLock *mutex = m_params->mutex;
 	mutex->lockForWrite();
 #endif
-    // FIXME how to make sure the buffer is read before it is flushed when recorded?
-    // Have another buffer?
+	// Each pixel column shows the range of zoomx frames. Only the latest
+	// frames are read, at most as many as the output buffer holds
 	RingBuffer *buffer = &ud->audioOutputBuffer;
-	buffer->lock();
-	QList<MYFLT> list = buffer->buffer;
-	buffer->unlock();
-	long listSize = list.size();
-    // long offset = buffer->currentPos;
-    long offset = buffer->currentReadPos;
-	for (int i = 0; i < width; i++) {
-		value = 0;
-        for (int j = 0; j < (int) zoomx; j++) {
-			if (channel == -1) {
-                // all channels
-				newValue = 0;
-				for (int k = 0; k < numChnls; k++) {
-                    int bufIdx = (int)((((i*zoomx)+j)*numChnls) + offset + k) % listSize;
-                    newValue += list[bufIdx];
-				}
-				newValue /= numChnls;
-				if (fabs(newValue) > fabs(value))
-					value = -(double) newValue;
-			}
-			else {
-                int bufIdx = (int)((((i*zoomx)+j)*numChnls) + offset + channel) % listSize;
-                if (fabs(list[bufIdx]) > fabs(value))
-                    value = (double) -list[bufIdx];
-			}
+	int maxFrames = buffer->size / numChnls;
+	int columns = qMin(width, maxFrames);
+	int perColumn = qMax(1, qMin((int) zoomx, maxFrames / columns));
+	int frames = columns * perColumn;
+	if (m_trigger.mode() != ScopeTrigger::Free) {
+		if (readTriggered(ud, channel, frames)) {
+			drawTrace(m_trigger.sweep(), columns, perColumn, m_trigger.sweepOffset(), zoomy);
+		}
+	}
+	else {
+		m_window.resize(frames * numChnls);
+		if (buffer->copyLatest(m_window.data(), m_window.size())) {
+			extractChannel(channel, numChnls, frames);
+			drawTrace(m_samples.constData(), columns, perColumn, 0, zoomy);
 		}
-        curveData[i+1] = QPoint(i, zoomy*value*height/2);
 	}
-    buffer->currentReadPos += width;
-	m_params->widget->setSceneRect(0, -height/2, width, height );
-	curveData.last() = QPoint(width-4, 0);
-	curveData.first() = QPoint(0, 0);
-	curve->setPolygon(curveData);
 #ifdef  USE_WIDGET_MUTEX
 	mutex->unlock();
 #endif
 }
 
+// Copies channel (or the mix of all channels if -1) of the frames in m_window to m_samples
+void ScopeData::extractChannel(int channel, int numChnls, int frames)
+{
+	m_samples.resize(frames);
+	const MYFLT *in = m_window.constData();
+	MYFLT *out = m_samples.data();
+	if (channel == -1) {  // all channels
+		MYFLT scale = 1.0 / numChnls;
+		for (int i = 0; i < frames; i++) {
+			MYFLT sum = 0;
+			for (int k = 0; k < numChnls; k++) {
+				sum += in[i * numChnls + k];
+			}
+			out[i] = sum * scale;
+		}
+	}
+	else {
+		for (int i = 0; i < frames; i++) {
+			out[i] = in[i * numChnls + channel];
+		}
+	}
+}
+
+// Feeds everything written since the last call to the trigger. Returns true
+// if a new sweep is ready
+bool ScopeData::readTriggered(CsoundUserData *ud, int channel, int sweepFrames)
+{
+	int sampleRate = ud->sampleRate > 0 ? ud->sampleRate : 44100;
+	m_trigger.setTiming(sweepFrames, (int) (sweepFrames * m_pretrigger),
+						(int) (m_holdoffMs * sampleRate / 1000),
+						sampleRate / 10);  // Auto mode free runs after 100 ms without trigger
+	if (channel != m_triggerChannel) {
+		m_triggerChannel = channel;
+		m_trigger.reset();
+	}
+	int numChnls = ud->numChnls;
+	int chunkFrames = 4096;
+	m_window.resize(chunkFrames * numChnls);
+	bool completed = false;
+	while (true) {
+		bool skipped;
+		long count = ud->audioOutputBuffer.copySince(m_readPosition, m_window.data(),
+													 m_window.size(), numChnls, &skipped);
+		if (skipped) {
+			m_trigger.reset(); // The audio is not continuous
+		}
+		if (count == 0) {
+			break;
+		}
+		int frames = count / numChnls;
+		extractChannel(channel, numChnls, frames);
+		completed = m_trigger.process(m_samples.constData(), frames) || completed;
+	}
+	return completed;
+}
+
+// Draws columns pixel columns, each spanning the range of perColumn samples.
+// offset shifts the trace right, in samples
+void ScopeData::drawTrace(const MYFLT *samples, int columns, int perColumn, double offset,
+						  double zoomy)
+{
+	int width = m_params->width;
+	int height = m_params->height;
+	m_minimum.resize(columns);
+	m_maximum.resize(columns);
+	columnMinMax(samples, columns, perColumn, m_minimum.data(), m_maximum.data());
+	// Zig-zag between the top and bottom of each column
+	QVector<QPointF> &vertices = curve->vertices();
+	vertices.resize(columns * 2);
+	double scale = zoomy * height / 2;
+	double shift = offset / perColumn;
+	for (int i = 0; i < columns; i++) {
+		vertices[2 * i] = QPointF(i + shift, -m_maximum[i] * scale);
+		vertices[2 * i + 1] = QPointF(i + shift, -m_minimum[i] * scale);
+	}
+	m_params->widget->setSceneRect(0, -height/2, width, height );
+	curve->verticesChanged();
+}
+
 void ScopeData::show()
 {
 	curve->show();
@@ -412,7 +659,7 @@ void LissajouData::updateData(int channel, double zoomx, double zoomy, bool free
 	CsoundUserData *ud = m_params->ud;
 	int width = m_params->width;
 	int height = m_params->height;
-    if (ud == nullptr || !ud->csEngine->isRunning())
+    if (!canUpdate(ud))
 		return;
 	if (freeze)
 		return;
@@ -429,16 +676,14 @@ void LissajouData::updateData(int channel, double zoomx, double zoomy, bool free
 	mutex->lockForWrite();
 #endif
 	RingBuffer *buffer = &ud->audioOutputBuffer;
-	buffer->lock();
-	QList<MYFLT> list = buffer->buffer;
-	buffer->unlock();
-	long listSize = list.size();
-	long offset = buffer->currentPos;
-	for (int i = 0; i < curveData.size(); i++) {
-		int bufferIndex = (int)((i*numChnls) + offset + channel) % listSize;
-		x = (double)list[bufferIndex];
-		bufferIndex = (bufferIndex + 1) % listSize;
-		y = (double) -list[bufferIndex];
+	int points = qMin(curveData.size(), buffer->size / numChnls);
+	m_window.resize(points * numChnls);
+	if (!buffer->copyLatest(m_window.data(), m_window.size())) {
+		points = 0;
+	}
+	for (int i = 0; i < points; i++) {
+		x = (double) m_window[i*numChnls + channel];
+		y = (double) -m_window[i*numChnls + channel + 1];
 		curveData[i] = QPoint(x*width*zoomx/4, y*height*zoomy/4);
 	}
 	m_params->widget->setSceneRect(-width/2, -height/2, width, height );
@@ -481,7 +726,7 @@ void PoincareData::updateData(int channel, double zoomx, double zoomy, bool free
 	CsoundUserData *ud = m_params->ud;
 	int width = m_params->width;
 	int height = m_params->height;
-    if (ud == 0 || !ud->csEngine->isRunning() )
+    if (!canUpdate(ud))
 		return;
 	if (freeze)
 		return;
@@ -496,14 +741,14 @@ void PoincareData::updateData(int channel, double zoomx, double zoomy, bool free
 	mutex->lockForWrite();
 #endif
 	RingBuffer *buffer = &ud->audioOutputBuffer;
-	buffer->lock();
-	QList<MYFLT> list = buffer->buffer;
-	buffer->unlock();
-	long listSize = list.size();
-	long offset = buffer->currentPos;
-	for (int i = 0; i < curveData.size(); i++) {
-		int bufferIndex = (int)((i*zoomx*numChnls) + offset + channel) % listSize;
-		value = (double)list[bufferIndex];
+	int maxFrames = buffer->size / numChnls;
+	int points = qMin(curveData.size(), (int) ((maxFrames - 1) / zoomx) + 1);
+	m_window.resize(((int) ((points - 1) * zoomx) + 1) * numChnls);
+	if (!buffer->copyLatest(m_window.data(), m_window.size())) {
+		points = 0;
+	}
+	for (int i = 0; i < points; i++) {
+		value = (double) m_window[(int) (i*zoomx) * numChnls + channel];
 		curveData[i] = QPoint(lastValue*width*zoomx/2, -value*height*zoomy/2);
 		lastValue = value;
 	}
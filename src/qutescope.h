@@ -25,6 +25,7 @@
 
 #include "qutewidget.h"
 #include "csoundengine.h"  //necessary for the CsoundUserData struct
+#include "scopetrigger.h"
 
 class ScopeParams;
 class DataDisplay;
@@ -70,6 +71,13 @@ protected:
 	QComboBox *channelBox;
 	QDoubleSpinBox *zoomxBox;
 	QDoubleSpinBox *zoomyBox;
+	QComboBox *triggerModeBox;
+	QComboBox *triggerSlopeBox;
+	QDoubleSpinBox *triggerLevelBox;
+	QDoubleSpinBox *hysteresisBox;
+	QDoubleSpinBox *holdoffBox;
+	QDoubleSpinBox *pretriggerBox;
+	QCheckBox *interpolateCheckBox;
 	ScopeParams *m_params;
 	DataDisplay *m_dataDisplay;
 	ScopeData *m_scopeData;
@@ -96,10 +104,12 @@ public:
 		setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 		setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 		freeze = false;
+		rearm = false;
 	}
 	~ScopeWidget() {}
 
 	bool freeze;
+	bool rearm; // Clicked, arms a single sweep trigger again
 
 protected:
 	//     virtual void contextMenuEvent(QContextMenuEvent *event)
@@ -112,6 +122,7 @@ protected:
     virtual void mouseReleaseEvent(QMouseEvent * /* event */)
 	{
 		freeze = false;
+		rearm = true;
 	}
 
 	//   signals:
@@ -178,6 +189,32 @@ protected:
 };
 
 
+//
+// Oscilloscope trace. The vertices are filled in place by ScopeData and
+// drawn as a single polyline, so no polygon is copied or allocated per frame
+//
+class ScopeTraceItem : public QGraphicsItem
+{
+public:
+	ScopeTraceItem(int width, int height);
+	QRectF boundingRect() const
+	{
+		return QRectF(0, -m_height/2, m_width, m_height);
+	}
+	void paint(QPainter *p, const QStyleOptionGraphicsItem *option, QWidget *widget);
+	void setPen(const QPen & pen);
+	void setSize(int width, int height);
+	QVector<QPointF> &vertices() { return m_vertices; }
+	void verticesChanged() { update(boundingRect()); }
+
+protected:
+	int m_width;
+	int m_height;
+	QPen m_pen;
+	QVector<QPointF> m_vertices;
+};
+
+
 //
 // Abstract base class for displays. The inherited classes will differ
 // mainly through the updateData method
@@ -211,10 +248,27 @@ public:
 	virtual void updateData(int channel, double zoomx, double zoomy, bool freeze);
 	virtual void show();
 	virtual void hide();
+	// pretrigger is the part of the sweep before the trigger, 0 to 1
+	void setTrigger(int mode, int slope, double level, double hysteresis,
+					double holdoffMs, double pretrigger, bool interpolate);
+	void armTrigger() { m_trigger.arm(); }
 
 protected:
-	QPolygonF curveData;
-	QGraphicsPolygonItem *curve;
+	void extractChannel(int channel, int numChnls, int frames);
+	bool readTriggered(CsoundUserData *ud, int channel, int sweepFrames);
+	void drawTrace(const MYFLT *samples, int columns, int perColumn, double offset,
+				   double zoomy);
+
+	QVector<MYFLT> m_window; // Interleaved frames read from the output buffer
+	QVector<MYFLT> m_samples; // The displayed channel (or mix) of m_window
+	QVector<MYFLT> m_minimum; // Per pixel column
+	QVector<MYFLT> m_maximum;
+	ScopeTraceItem *curve;
+	ScopeTrigger m_trigger;
+	quint64 m_readPosition; // In the output buffer, for the trigger
+	int m_triggerChannel;
+	double m_holdoffMs;
+	double m_pretrigger;
 };
 
 
@@ -233,6 +287,7 @@ public:
 
 protected:
 	QPolygonF curveData;
+	QVector<MYFLT> m_window;
 	ScopeItem *curve;
 };
 
@@ -252,6 +307,7 @@ public:
 
 protected:
 	QPolygonF curveData;
+	QVector<MYFLT> m_window;
 	ScopeItem *curve;
 	double lastValue;  // holds the last ordinate value to become abcsissa value of the next pass
 };
@@ -76,6 +76,16 @@ void QuteSlider::setMidiValue(int value)
 	emit newValue(channelValue);
 }
 
+void QuteSlider::setMidiValue14(int value)
+{
+	double max = property("QCS_maximum").toDouble();
+	double min = property("QCS_minimum").toDouble();
+	double newval = min + ((value / 16383.0)* (max - min));
+	setValue(newval);
+	QPair<QString, double> channelValue(m_channel, newval);
+	emit newValue(channelValue);
+}
+
 void QuteSlider::refreshWidget()
 {
 #ifdef  USE_WIDGET_MUTEX
@@ -44,6 +44,7 @@ public:
 	//    void setInternalValue(double value);
 	virtual void setValue(double value);
 	virtual void setMidiValue(int value);
+	virtual void setMidiValue14(int value);
 	virtual bool acceptsMidi() {return true;}
 
 	virtual void refreshWidget();
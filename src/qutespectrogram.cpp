@@ -0,0 +1,502 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "qutespectrogram.h"
+#include <cmath>
+#include <cstring>
+
+SpectrogramAnalyzer::SpectrogramAnalyzer(QObject *parent) : SpectrumWorker(parent)
+{
+	m_rows = 0;
+	m_logFrequency = true;
+	m_minDb = -100;
+	m_maxDb = 0;
+	m_columnRows = 0;
+	m_written = 0;
+	m_firstValid = 0;
+	m_bins = 0;
+	m_sampleRate = 0;
+}
+
+SpectrogramAnalyzer::~SpectrogramAnalyzer()
+{
+	stop();
+}
+
+void SpectrogramAnalyzer::setDisplay(int rows, bool logFrequency, double minDb, double maxDb)
+{
+	QMutexLocker locker(&m_displayMutex);
+	m_rows = rows;
+	m_logFrequency = logFrequency;
+	m_minDb = minDb;
+	m_maxDb = maxDb > minDb ? maxDb : minDb + 1;
+}
+
+int SpectrogramAnalyzer::takeColumns(quint64 &position, uchar *levels, int maxColumns,
+									 int rows, int &bins, double &sampleRate)
+{
+	QMutexLocker locker(&m_columnMutex);
+	bins = m_bins;
+	sampleRate = m_sampleRate;
+	if (rows != m_columnRows || position >= m_written) {
+		position = m_written;
+		return 0;
+	}
+	quint64 first = qMax(position, m_firstValid);
+	if (m_written - first > QCS_SPECTROGRAM_FRAMES) {
+		first = m_written - QCS_SPECTROGRAM_FRAMES;  // The GUI fell behind
+	}
+	if (m_written - first > (quint64) maxColumns) {
+		first = m_written - maxColumns;
+	}
+	int count = (int) (m_written - first);
+	for (int i = 0; i < count; i++) {
+		int index = (int) ((first + i) & (QCS_SPECTROGRAM_FRAMES - 1));
+		memcpy(levels + i * rows, m_columns.constData() + index * rows, rows);
+	}
+	position = m_written;
+	return count;
+}
+
+void SpectrogramAnalyzer::processFrame(const double *power, int bins, double sampleRate,
+									   double seconds)
+{
+	Q_UNUSED(seconds);
+	m_displayMutex.lock();
+	int rows = m_rows;
+	bool logFrequency = m_logFrequency;
+	double minDb = m_minDb;
+	double maxDb = m_maxDb;
+	m_displayMutex.unlock();
+	if (rows <= 0) {
+		return;
+	}
+	m_scale.setup(rows, bins, sampleRate, logFrequency);
+	m_rowPower.resize(rows);
+	m_scale.map(power, m_rowPower.data());
+	// 10 * log10(p) mapped to 0-255 over the dB range
+	double scale = 255.0 / (maxDb - minDb);
+	const double floor = 1e-20;  // -200 dB
+
+	QMutexLocker locker(&m_columnMutex);
+	if (rows != m_columnRows || bins != m_bins || sampleRate != m_sampleRate) {
+		m_columns.resize(QCS_SPECTROGRAM_FRAMES * rows);
+		m_columnRows = rows;
+		m_bins = bins;
+		m_sampleRate = sampleRate;
+		m_firstValid = m_written;
+	}
+	uchar *column = m_columns.data() + (m_written & (QCS_SPECTROGRAM_FRAMES - 1)) * rows;
+	const double *value = m_rowPower.constData();
+	for (int i = 0; i < rows; i++) {
+		double level = (10 * std::log10(qMax(value[i], floor)) - minDb) * scale;
+		column[i] = (uchar) qBound(0.0, level, 255.0);
+	}
+	m_written++;
+}
+
+
+SpectrogramView::SpectrogramView(QWidget *parent) : QWidget(parent)
+{
+	m_writeColumn = 0;
+	m_history = 0;
+	m_scrollBack = 0;
+	m_frozen = false;
+	m_dragX = 0;
+	m_logFrequency = true;
+	setAttribute(Qt::WA_OpaquePaintEvent);
+	setColormap("viridis");
+}
+
+QStringList SpectrogramView::colormapNames()
+{
+	return QStringList() << "viridis" << "hot" << "gray";
+}
+
+void SpectrogramView::setColormap(QString name)
+{
+	// Colors at equally spaced levels, interpolated into the table
+	static const QRgb viridis[] = {0x440154, 0x3b528b, 0x21918c, 0x5ec962, 0xfde725};
+	static const QRgb hot[] = {0x000000, 0x800000, 0xff2000, 0xffa000, 0xffff60, 0xffffff};
+	static const QRgb gray[] = {0x000000, 0xffffff};
+	const QRgb *colors = viridis;
+	int count = 5;
+	if (name == "hot") {
+		colors = hot;
+		count = 6;
+	}
+	else if (name == "gray") {
+		colors = gray;
+		count = 2;
+	}
+	for (int i = 0; i < 256; i++) {
+		double position = i * (count - 1) / 255.0;
+		int index = qMin((int) position, count - 2);
+		double fraction = position - index;
+		QRgb a = colors[index];
+		QRgb b = colors[index + 1];
+		m_colormap[i] = qRgb(qRound(qRed(a) + fraction * (qRed(b) - qRed(a))),
+							 qRound(qGreen(a) + fraction * (qGreen(b) - qGreen(a))),
+							 qRound(qBlue(a) + fraction * (qBlue(b) - qBlue(a))));
+	}
+	update();
+}
+
+void SpectrogramView::setAxis(int bins, double sampleRate, bool logFrequency)
+{
+	m_logFrequency = logFrequency;
+	if (m_scale.setup(height(), bins, sampleRate, logFrequency)) {
+		update();
+	}
+}
+
+void SpectrogramView::addColumns(const uchar *levels, int columns, int rows)
+{
+	if (m_image.isNull() || rows != m_image.height()) {
+		return;
+	}
+	int width = m_image.width();
+	// Writing through the raw pointer avoids a detach check per pixel
+	int stride = m_image.bytesPerLine() / sizeof(QRgb);
+	QRgb *bits = reinterpret_cast<QRgb *>(m_image.bits());
+	for (int c = 0; c < columns; c++) {
+		const uchar *level = levels + c * rows;
+		QRgb *pixel = bits + m_writeColumn + (rows - 1) * stride; // Low frequencies at the bottom
+		for (int i = 0; i < rows; i++) {
+			*pixel = m_colormap[level[i]];
+			pixel -= stride;
+		}
+		m_writeColumn = (m_writeColumn + 1) % width;
+	}
+	m_history = qMin(m_history + columns, width);
+	update();
+}
+
+void SpectrogramView::scrollBack(int columns)
+{
+	int maximum = qMax(0, m_history - width());
+	m_scrollBack = qBound(0, m_scrollBack + columns, maximum);
+	update();
+}
+
+void SpectrogramView::paintAxis(QPainter *painter)
+{
+	if (!m_scale.isValid()) {
+		return;
+	}
+	QFont font = painter->font();
+	font.setPixelSize(9);
+	painter->setFont(font);
+	painter->setPen(QColor(220, 220, 220));
+	double nyquist = m_scale.frequencyAt(m_scale.pixels());
+	int h = height();
+	if (m_logFrequency) {
+		for (double f = 100; f < nyquist; f *= 10) {
+			int y = h - 1 - (int) m_scale.pixelAt(f);
+			painter->drawLine(0, y, 4, y);
+			painter->drawText(6, y + 4, f >= 1000 ? QString("%1k").arg(f / 1000) : QString::number(f));
+		}
+	}
+	else {
+		double step = nyquist > 10000 ? 5000 : 1000;
+		for (double f = step; f < nyquist; f += step) {
+			int y = h - 1 - (int) m_scale.pixelAt(f);
+			painter->drawLine(0, y, 4, y);
+			painter->drawText(6, y + 4, QString("%1k").arg(f / 1000));
+		}
+	}
+}
+
+void SpectrogramView::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event);
+	QPainter painter(this);
+	int w = width();
+	int imageWidth = m_image.width();
+	if (m_image.isNull() || w > imageWidth) {
+		painter.fillRect(rect(), Qt::black);
+		return;
+	}
+	// The newest visible column is drawn at the right edge. The visible part
+	// of the ring may wrap, in which case it is drawn in two parts
+	int end = (m_writeColumn - m_scrollBack + imageWidth) % imageWidth;
+	int start = (end - w + imageWidth) % imageWidth;
+	if (start + w <= imageWidth) {
+		painter.drawImage(0, 0, m_image, start, 0, w, m_image.height());
+	}
+	else {
+		int first = imageWidth - start;
+		painter.drawImage(0, 0, m_image, start, 0, first, m_image.height());
+		painter.drawImage(first, 0, m_image, 0, 0, w - first, m_image.height());
+	}
+	paintAxis(&painter);
+	if (m_frozen) {
+		painter.setPen(QColor(255, 255, 255));
+		QString text = m_scrollBack > 0 ? tr("frozen -%1").arg(m_scrollBack) : tr("frozen");
+		painter.drawText(rect().adjusted(0, 2, -4, 0), Qt::AlignRight | Qt::AlignTop, text);
+	}
+}
+
+void SpectrogramView::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+	// The history is lost when resized, its rows no longer match
+	m_image = QImage(qMax(1, width() * QCS_SPECTROGRAM_HISTORY), qMax(1, height()),
+					 QImage::Format_RGB32);
+	m_image.fill(m_colormap[0]);
+	m_writeColumn = 0;
+	m_history = 0;
+	m_scrollBack = 0;
+}
+
+void SpectrogramView::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() & Qt::LeftButton) {
+		m_frozen = !m_frozen;
+		m_scrollBack = 0;
+		m_dragX = event->x();
+		update();
+		emit frozenChanged(m_frozen);
+	}
+}
+
+void SpectrogramView::mouseMoveEvent(QMouseEvent *event)
+{
+	if (m_frozen && (event->buttons() & Qt::LeftButton)) {
+		scrollBack(event->x() - m_dragX);
+		m_dragX = event->x();
+	}
+}
+
+void SpectrogramView::wheelEvent(QWheelEvent *event)
+{
+	if (!m_frozen) {
+		event->ignore();
+		return;
+	}
+	scrollBack(event->angleDelta().y() / 4);
+}
+
+
+QuteSpectrogram::QuteSpectrogram(QWidget *parent) : QuteWidget(parent)
+{
+	SpectrogramView *view = new SpectrogramView(this);
+	m_widget = view;
+	m_widget->setContextMenuPolicy(Qt::NoContextMenu);
+	// Necessary to pass mouse tracking to widget panel for _MouseX channels
+	m_widget->setMouseTracking(true);
+	canFocus(false);
+	connect(view, SIGNAL(frozenChanged(bool)), this, SLOT(updateLabel()));
+	m_analyzer = new SpectrogramAnalyzer(this);
+	m_label = new QLabel(this);
+	QPalette palette = m_widget->palette();
+	palette.setColor(QPalette::WindowText, QColor(220, 220, 220));
+	m_label->setPalette(palette);
+	QFont font = m_label->font();
+	font.setPixelSize(11);
+	m_label->setFont(font);
+	m_label->move(40, 0);
+	m_label->resize(300, 20);
+	m_label->setAttribute(Qt::WA_TransparentForMouseEvents);
+	m_position = 0;
+	m_value = -255;
+
+	// Default properties
+	setProperty("QCS_randomizable", false);
+	setProperty("QCS_value", -255);
+	setProperty("QCS_fftsize", 1024);
+	setProperty("QCS_overlap", 75.0);
+	setProperty("QCS_logfreq", true);
+	setProperty("QCS_mindb", -100.0);
+	setProperty("QCS_maxdb", 0.0);
+	setProperty("QCS_colormap", "viridis");
+	updateLabel();
+}
+
+QuteSpectrogram::~QuteSpectrogram()
+{
+	m_analyzer->stop();
+}
+
+QString QuteSpectrogram::getWidgetXmlText()
+{
+	xmlText = "";
+	QXmlStreamWriter s(&xmlText);
+	createXmlWriter(s);
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+
+	s.writeTextElement("value", QString::number((int) m_value));
+	s.writeTextElement("fftsize", QString::number(property("QCS_fftsize").toInt()));
+	s.writeTextElement("overlap", QString::number(property("QCS_overlap").toDouble(), 'f', 8));
+	s.writeTextElement("logfreq", property("QCS_logfreq").toBool() ? "true" : "false");
+	s.writeTextElement("mindb", QString::number(property("QCS_mindb").toDouble(), 'f', 8));
+	s.writeTextElement("maxdb", QString::number(property("QCS_maxdb").toDouble(), 'f', 8));
+	s.writeTextElement("colormap", property("QCS_colormap").toString());
+
+	s.writeEndElement();
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+	return xmlText;
+}
+
+void QuteSpectrogram::setValue(double value)
+{
+	QuteWidget::setValue(value);
+	updateLabel();
+}
+
+void QuteSpectrogram::updateLabel()
+{
+	QString chan = (int) m_value < 0 ? tr("all", "meaning 'all' channels in spectrogram")
+									 : QString::number((int) m_value);
+	m_label->setText(tr("Spectrogram ch:") + chan);
+}
+
+void QuteSpectrogram::setCsoundUserData(CsoundUserData *ud)
+{
+	QuteWidget::setCsoundUserData(ud);
+	m_analyzer->setUserData(ud);
+}
+
+void QuteSpectrogram::updateDisplay()
+{
+	m_analyzer->setDisplay(m_widget->height(), property("QCS_logfreq").toBool(),
+						   property("QCS_mindb").toDouble(),
+						   property("QCS_maxdb").toDouble());
+}
+
+void QuteSpectrogram::applyInternalProperties()
+{
+	QuteWidget::applyInternalProperties();
+	setValue(property("QCS_value").toDouble());
+	// Loaded properties are strings, QVariant converts them
+	int channel = (int) m_value;
+	m_analyzer->setAnalysis(property("QCS_fftsize").toInt(),
+							property("QCS_overlap").toDouble() / 100.0,
+							channel > 0 ? channel : -1);
+	static_cast<SpectrogramView *>(m_widget)->setColormap(property("QCS_colormap").toString());
+	updateDisplay();
+}
+
+void QuteSpectrogram::setWidgetGeometry(int x, int y, int width, int height)
+{
+	QuteWidget::setWidgetGeometry(x, y, width, height);
+	updateDisplay();
+}
+
+void QuteSpectrogram::createPropertiesDialog()
+{
+	QuteWidget::createPropertiesDialog();
+	dialog->setWindowTitle(tr("Spectrogram"));
+	QLabel *label = new QLabel(dialog);
+	label->setText(tr("Channel"));
+	layout->addWidget(label, 6, 0, Qt::AlignRight|Qt::AlignVCenter);
+	channelBox = new QComboBox(dialog);
+	channelBox->addItem(tr("all"), QVariant((int) -255));
+	for (int i = 1; i <= 8; i++) {
+		channelBox->addItem(QString("Ch.%1").arg(i), QVariant(i));
+	}
+	layout->addWidget(channelBox, 6, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("FFT size"));
+	layout->addWidget(label, 6, 2, Qt::AlignRight|Qt::AlignVCenter);
+	fftSizeBox = new QComboBox(dialog);
+	for (int size = QCS_SPECTRUM_MIN_FFT_SIZE; size <= QCS_SPECTRUM_MAX_FFT_SIZE; size *= 2) {
+		fftSizeBox->addItem(QString::number(size), QVariant(size));
+	}
+	layout->addWidget(fftSizeBox, 6, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Overlap (%)"));
+	layout->addWidget(label, 7, 0, Qt::AlignRight|Qt::AlignVCenter);
+	overlapBox = new QDoubleSpinBox(dialog);
+	overlapBox->setRange(0, 95);
+	overlapBox->setToolTip(tr("Each analysis frame is one column, more overlap scrolls faster"));
+	layout->addWidget(overlapBox, 7, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Colormap"));
+	layout->addWidget(label, 7, 2, Qt::AlignRight|Qt::AlignVCenter);
+	colormapBox = new QComboBox(dialog);
+	colormapBox->addItems(SpectrogramView::colormapNames());
+	layout->addWidget(colormapBox, 7, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	logFrequencyCheckBox = new QCheckBox(tr("Logarithmic frequency"), dialog);
+	layout->addWidget(logFrequencyCheckBox, 8, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Range (dB)"));
+	layout->addWidget(label, 9, 0, Qt::AlignRight|Qt::AlignVCenter);
+	minDbBox = new QDoubleSpinBox(dialog);
+	minDbBox->setRange(-200, 0);
+	layout->addWidget(minDbBox, 9, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	maxDbBox = new QDoubleSpinBox(dialog);
+	maxDbBox->setRange(-199, 40);
+	layout->addWidget(maxDbBox, 9, 2, Qt::AlignLeft|Qt::AlignVCenter);
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+	channelBox->setCurrentIndex(qMax(0, channelBox->findData(QVariant((int) m_value))));
+	fftSizeBox->setCurrentIndex(qMax(0, fftSizeBox->findData(QVariant(property("QCS_fftsize").toInt()))));
+	overlapBox->setValue(property("QCS_overlap").toDouble());
+	colormapBox->setCurrentIndex(qMax(0, colormapBox->findText(property("QCS_colormap").toString())));
+	logFrequencyCheckBox->setChecked(property("QCS_logfreq").toBool());
+	minDbBox->setValue(property("QCS_mindb").toDouble());
+	maxDbBox->setValue(property("QCS_maxdb").toDouble());
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+}
+
+void QuteSpectrogram::applyProperties()
+{
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+	setProperty("QCS_value", channelBox->itemData(channelBox->currentIndex()).toInt());
+	setProperty("QCS_fftsize", fftSizeBox->itemData(fftSizeBox->currentIndex()).toInt());
+	setProperty("QCS_overlap", overlapBox->value());
+	setProperty("QCS_colormap", colormapBox->currentText());
+	setProperty("QCS_logfreq", logFrequencyCheckBox->isChecked());
+	setProperty("QCS_mindb", minDbBox->value());
+	setProperty("QCS_maxdb", maxDbBox->value());
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+	//Must be last to make sure the widgetChanged signal is last
+	QuteWidget::applyProperties();
+}
+
+void QuteSpectrogram::updateData()
+{
+	SpectrogramView *view = static_cast<SpectrogramView *>(m_widget);
+	int rows = view->height();
+	m_levels.resize(QCS_SPECTROGRAM_FRAMES * rows);
+	int bins;
+	double sampleRate;
+	int columns = m_analyzer->takeColumns(m_position, m_levels.data(), QCS_SPECTROGRAM_FRAMES,
+										  rows, bins, sampleRate);
+	view->setAxis(bins, sampleRate, property("QCS_logfreq").toBool());
+	// Columns are still taken while frozen, so the display resumes from now
+	if (columns > 0 && !view->isFrozen()) {
+		view->addColumns(m_levels.constData(), columns, rows);
+	}
+}
@@ -0,0 +1,168 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef QUTESPECTROGRAM_H
+#define QUTESPECTROGRAM_H
+
+#include "qutewidget.h"
+#include "spectrumworker.h"
+
+// Analysis frames kept for the GUI between refreshes, a power of two
+#define QCS_SPECTROGRAM_FRAMES 256
+// Width of the scroll-back history, in widget widths
+#define QCS_SPECTROGRAM_HISTORY 4
+
+//
+// Turns each analysis frame into a column of colormap levels (0 to 255),
+// one per pixel row, on the worker thread. Columns wait in a ring until the
+// GUI copies them with takeColumns(), so the GUI only does a table lookup
+// per pixel.
+//
+class SpectrogramAnalyzer : public SpectrumWorker
+{
+	Q_OBJECT
+public:
+	SpectrogramAnalyzer(QObject *parent = 0);
+	~SpectrogramAnalyzer();
+
+	void setDisplay(int rows, bool logFrequency, double minDb, double maxDb);
+	// Copies up to maxColumns columns newer than position to levels, which
+	// holds maxColumns * rows values. Returns the number of columns copied.
+	// Columns for a different number of rows are skipped
+	int takeColumns(quint64 &position, uchar *levels, int maxColumns, int rows,
+					int &bins, double &sampleRate);
+
+protected:
+	virtual void processFrame(const double *power, int bins, double sampleRate,
+							  double seconds);
+
+private:
+	QMutex m_displayMutex;
+	int m_rows;
+	bool m_logFrequency;
+	double m_minDb;
+	double m_maxDb;
+
+	// Worker thread only
+	SpectrumScale m_scale;
+	QVector<double> m_rowPower;
+
+	QMutex m_columnMutex;
+	QVector<uchar> m_columns; // QCS_SPECTROGRAM_FRAMES columns of m_columnRows levels
+	int m_columnRows;
+	quint64 m_written;
+	quint64 m_firstValid; // Older columns have a different layout
+	int m_bins;
+	double m_sampleRate;
+};
+
+//
+// Scrolling time-frequency display. Columns are written into a ring-wrapped
+// image as they arrive, so nothing is redrawn or moved when it scrolls:
+// painting is at most two unscaled blits of the ring. Clicking freezes the
+// display, and while frozen the wheel or dragging scrolls back through the
+// history.
+//
+class SpectrogramView : public QWidget
+{
+	Q_OBJECT
+public:
+	SpectrogramView(QWidget *parent);
+
+	void setColormap(QString name);
+	void setAxis(int bins, double sampleRate, bool logFrequency);
+	void addColumns(const uchar *levels, int columns, int rows);
+	bool isFrozen() { return m_frozen; }
+
+	static QStringList colormapNames();
+
+signals:
+	void frozenChanged(bool frozen);
+
+protected:
+	virtual void paintEvent(QPaintEvent *event);
+	virtual void resizeEvent(QResizeEvent *event);
+	virtual void mousePressEvent(QMouseEvent *event);
+	virtual void mouseMoveEvent(QMouseEvent *event);
+	virtual void wheelEvent(QWheelEvent *event);
+
+private:
+	void scrollBack(int columns);
+	void paintAxis(QPainter *painter);
+
+	QImage m_image;     // History ring, one column per analysis frame
+	int m_writeColumn;  // Next column to write in m_image
+	int m_history;      // Columns written, up to the image width
+	int m_scrollBack;   // Columns between the newest one and the right edge
+	bool m_frozen;
+	int m_dragX;
+	QRgb m_colormap[256];
+	SpectrumScale m_scale; // For the axis
+	bool m_logFrequency;
+};
+
+class QuteSpectrogram : public QuteWidget
+{
+	Q_OBJECT
+public:
+	QuteSpectrogram(QWidget *parent);
+	~QuteSpectrogram();
+
+	virtual QString getWidgetLine() { return QString(""); }
+	virtual QString getWidgetXmlText();
+	virtual QString getWidgetType() { return QString("BSBSpectrogram"); }
+	virtual void applyInternalProperties();
+	virtual void createPropertiesDialog();
+	virtual void setCsoundUserData(CsoundUserData *ud);
+	virtual void setWidgetGeometry(int x, int y, int width, int height);
+	void setValue(double value); // Channel, negative for all
+	// Run the analysis thread with the performance
+	void startAnalysis() { m_analyzer->startAnalysis(); }
+	void stopAnalysis() { m_analyzer->stop(); }
+
+public slots:
+	void updateData();
+
+protected:
+	virtual void applyProperties();
+
+	SpectrogramAnalyzer *m_analyzer;
+	QLabel *m_label;
+	QComboBox *channelBox;
+	QComboBox *fftSizeBox;
+	QDoubleSpinBox *overlapBox;
+	QCheckBox *logFrequencyCheckBox;
+	QDoubleSpinBox *minDbBox;
+	QDoubleSpinBox *maxDbBox;
+	QComboBox *colormapBox;
+
+protected slots:
+	void updateLabel();
+
+private:
+	void updateDisplay();
+
+	quint64 m_position;
+	QVector<uchar> m_levels;
+};
+
+#endif // QUTESPECTROGRAM_H
@@ -0,0 +1,496 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "qutespectrum.h"
+#include <cmath>
+#include <cstring>
+
+SpectrumAnalyzer::SpectrumAnalyzer(QObject *parent) : SpectrumWorker(parent)
+{
+	m_averagingMs = 0;
+	m_peakHold = false;
+	m_peakDecay = 0;
+	m_resetPeaks = false;
+	m_first = true;
+	m_resultSampleRate = 0;
+	m_resultFrame = 0;
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+	stop();
+}
+
+void SpectrumAnalyzer::setSmoothing(double averagingMs, bool peakHold, double peakDecay)
+{
+	QMutexLocker locker(&m_smoothingMutex);
+	m_averagingMs = averagingMs;
+	m_peakHold = peakHold;
+	m_peakDecay = peakDecay;
+}
+
+void SpectrumAnalyzer::resetPeaks()
+{
+	QMutexLocker locker(&m_smoothingMutex);
+	m_resetPeaks = true;
+}
+
+bool SpectrumAnalyzer::takeResult(quint64 &frame, QVector<double> &average,
+								  QVector<double> &peak, double &sampleRate)
+{
+	QMutexLocker locker(&m_resultMutex);
+	if (m_resultFrame == frame) {
+		return false;
+	}
+	frame = m_resultFrame;
+	// Copied rather than shared, so neither side reallocates on the next frame
+	average.resize(m_resultAverage.size());
+	memcpy(average.data(), m_resultAverage.constData(), m_resultAverage.size() * sizeof(double));
+	peak.resize(m_resultPeak.size());
+	memcpy(peak.data(), m_resultPeak.constData(), m_resultPeak.size() * sizeof(double));
+	sampleRate = m_resultSampleRate;
+	return true;
+}
+
+void SpectrumAnalyzer::analysisReset(int bins)
+{
+	m_average.fill(0, bins);
+	m_peak.fill(0, bins);
+	m_first = true;
+}
+
+void SpectrumAnalyzer::processFrame(const double *power, int bins, double sampleRate,
+									double seconds)
+{
+	m_smoothingMutex.lock();
+	double averagingMs = m_averagingMs;
+	bool peakHold = m_peakHold;
+	double peakDecay = m_peakDecay;
+	bool resetPeaks = m_resetPeaks;
+	m_resetPeaks = false;
+	m_smoothingMutex.unlock();
+
+	double *average = m_average.data();
+	double *peak = m_peak.data();
+	// Exponential average with a time constant, independent of the frame rate
+	double a = (averagingMs > 0 && !m_first) ? std::exp(-seconds * 1000.0 / averagingMs) : 0.0;
+	for (int i = 0; i < bins; i++) {
+		average[i] = a * average[i] + (1 - a) * power[i];
+	}
+	m_first = false;
+	if (peakHold) {
+		double decay = std::pow(10.0, -peakDecay * seconds / 10.0);
+		if (resetPeaks) {
+			decay = 0;
+		}
+		for (int i = 0; i < bins; i++) {
+			peak[i] = qMax(peak[i] * decay, average[i]);
+		}
+	}
+	m_resultMutex.lock();
+	m_resultAverage.resize(bins);
+	memcpy(m_resultAverage.data(), average, bins * sizeof(double));
+	if (peakHold) {
+		m_resultPeak.resize(bins);
+		memcpy(m_resultPeak.data(), peak, bins * sizeof(double));
+	}
+	else {
+		m_resultPeak.clear();
+	}
+	m_resultSampleRate = sampleRate;
+	m_resultFrame++;
+	m_resultMutex.unlock();
+}
+
+
+SpectrumView::SpectrumView(QWidget *parent) : QWidget(parent)
+{
+	m_logFrequency = true;
+	m_minDb = -90;
+	m_maxDb = 0;
+	m_color = QColor(80, 200, 255);
+	m_peakColor = QColor(255, 193, 3);
+	m_showPeak = false;
+	m_sampleRate = 0;
+	m_bins = 0;
+}
+
+void SpectrumView::setScale(bool logFrequency, double minDb, double maxDb)
+{
+	m_logFrequency = logFrequency;
+	m_minDb = minDb;
+	m_maxDb = maxDb > minDb ? maxDb : minDb + 1;
+	m_scale.setup(width(), m_bins, m_sampleRate, m_logFrequency);
+	update();
+}
+
+void SpectrumView::setColors(QColor color, QColor peakColor)
+{
+	m_color = color;
+	m_peakColor = peakColor;
+	update();
+}
+
+void SpectrumView::setSpectrum(const QVector<double> &average, const QVector<double> &peak,
+							   bool showPeak, double sampleRate)
+{
+	m_bins = average.size();
+	m_sampleRate = sampleRate;
+	m_scale.setup(width(), m_bins, m_sampleRate, m_logFrequency);
+	columnValues(average, m_points);
+	m_showPeak = showPeak && peak.size() == m_bins;
+	if (m_showPeak) {
+		columnValues(peak, m_peakPoints);
+	}
+	update();
+}
+
+void SpectrumView::clear()
+{
+	m_bins = 0;
+	m_points.clear();
+	m_peakPoints.clear();
+	m_showPeak = false;
+	update();
+}
+
+void SpectrumView::columnValues(const QVector<double> &power, QVector<QPointF> &points)
+{
+	int columns = m_scale.pixels();
+	points.resize(columns);
+	m_columnPower.resize(columns);
+	m_scale.map(power.constData(), m_columnPower.data());
+	const double *value = m_columnPower.constData();
+	QPointF *out = points.data();
+	double h = height();
+	double scale = h / (m_maxDb - m_minDb);
+	const double floor = 1e-20;  // -200 dB
+	for (int x = 0; x < columns; x++) {
+		double db = 10 * std::log10(qMax(value[x], floor));
+		double y = (m_maxDb - db) * scale;
+		out[x] = QPointF(x + 0.5, qBound(0.0, y, h));
+	}
+}
+
+void SpectrumView::paintGrid(QPainter *painter)
+{
+	int w = width();
+	int h = height();
+	QFont font = painter->font();
+	font.setPixelSize(9);
+	painter->setFont(font);
+	QPen gridPen(QColor(48, 48, 48), 0);
+	QPen textPen(QColor(150, 150, 150));
+	// Level lines every 10 or 20 dB
+	double range = m_maxDb - m_minDb;
+	double step = range > 80 ? 20 : 10;
+	for (double db = std::ceil(m_minDb / step) * step; db <= m_maxDb; db += step) {
+		int y = (int) ((m_maxDb - db) * h / range);
+		painter->setPen(gridPen);
+		painter->drawLine(0, y, w, y);
+		painter->setPen(textPen);
+		painter->drawText(2, qMax(y - 2, 10), QString::number(db));
+	}
+	if (!m_scale.isValid()) {
+		return;
+	}
+	double nyquist = m_sampleRate / 2;
+	QVector<double> frequencies;
+	if (m_logFrequency) {
+		for (double decade = 100; decade < nyquist; decade *= 10) {
+			for (int i = 1; i < 10; i++) {
+				frequencies << decade * i;
+			}
+		}
+	}
+	else {
+		double frequencyStep = nyquist > 10000 ? 2000 : 1000;
+		for (double f = frequencyStep; f < nyquist; f += frequencyStep) {
+			frequencies << f;
+		}
+	}
+	for (int i = 0; i < frequencies.size(); i++) {
+		double f = frequencies[i];
+		if (f >= nyquist) {
+			break;
+		}
+		int x = (int) m_scale.pixelAt(f);
+		bool major = !m_logFrequency || f == 100 || f == 1000 || f == 10000;
+		painter->setPen(major ? gridPen : QPen(QColor(32, 32, 32), 0));
+		painter->drawLine(x, 0, x, h);
+		if (major) {
+			painter->setPen(textPen);
+			painter->drawText(x + 2, h - 2, f >= 1000 ? QString("%1k").arg(f / 1000)
+													  : QString::number(f));
+		}
+	}
+}
+
+void SpectrumView::paintEvent(QPaintEvent *event)
+{
+	Q_UNUSED(event);
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	paintGrid(&painter);
+	if (m_bins < 2 || m_points.isEmpty()) {
+		return;
+	}
+	int columns = m_points.size();
+	// Filled area under the curve
+	m_fill.resize(columns + 2);
+	memcpy(m_fill.data(), m_points.constData(), columns * sizeof(QPointF));
+	m_fill[columns] = QPointF(columns, height());
+	m_fill[columns + 1] = QPointF(0, height());
+	QColor fillColor = m_color;
+	fillColor.setAlpha(64);
+	painter.setPen(Qt::NoPen);
+	painter.setBrush(fillColor);
+	painter.drawPolygon(m_fill.constData(), m_fill.size());
+	painter.setBrush(Qt::NoBrush);
+	painter.setPen(QPen(m_color, 0));
+	painter.drawPolyline(m_points.constData(), columns);
+	if (m_showPeak) {
+		painter.setPen(QPen(m_peakColor, 0));
+		painter.drawPolyline(m_peakPoints.constData(), m_peakPoints.size());
+	}
+}
+
+void SpectrumView::resizeEvent(QResizeEvent *event)
+{
+	QWidget::resizeEvent(event);
+	m_scale.setup(width(), m_bins, m_sampleRate, m_logFrequency);
+}
+
+void SpectrumView::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() & Qt::LeftButton) {
+		emit clicked();
+	}
+}
+
+
+QuteSpectrum::QuteSpectrum(QWidget *parent) : QuteWidget(parent)
+{
+	SpectrumView *view = new SpectrumView(this);
+	m_widget = view;
+	m_widget->setContextMenuPolicy(Qt::NoContextMenu);
+	// Necessary to pass mouse tracking to widget panel for _MouseX channels
+	m_widget->setMouseTracking(true);
+	canFocus(false);
+	m_analyzer = new SpectrumAnalyzer(this);
+	connect(view, SIGNAL(clicked()), m_analyzer, SLOT(resetPeaks()));
+	m_label = new QLabel(this);
+	QPalette palette = m_widget->palette();
+	palette.setColor(QPalette::WindowText, QColor(196, 196, 196));
+	m_label->setPalette(palette);
+	QFont font = m_label->font();
+	font.setPixelSize(11);
+	m_label->setFont(font);
+	m_label->move(30, 0);
+	m_label->resize(300, 20);
+	m_frame = 0;
+	m_value = -255;
+
+	// Default properties
+	setProperty("QCS_randomizable", false);
+	setProperty("QCS_value", -255);
+	setProperty("QCS_fftsize", 2048);
+	setProperty("QCS_overlap", 75.0);
+	setProperty("QCS_averaging", 100.0);
+	setProperty("QCS_peakhold", true);
+	setProperty("QCS_peakdecay", 10.0);
+	setProperty("QCS_logfreq", true);
+	setProperty("QCS_mindb", -90.0);
+	setProperty("QCS_maxdb", 0.0);
+	updateLabel();
+}
+
+QuteSpectrum::~QuteSpectrum()
+{
+	m_analyzer->stop();
+}
+
+QString QuteSpectrum::getWidgetXmlText()
+{
+	xmlText = "";
+	QXmlStreamWriter s(&xmlText);
+	createXmlWriter(s);
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+
+	s.writeTextElement("value", QString::number((int) m_value));
+	s.writeTextElement("fftsize", QString::number(property("QCS_fftsize").toInt()));
+	s.writeTextElement("overlap", QString::number(property("QCS_overlap").toDouble(), 'f', 8));
+	s.writeTextElement("averaging", QString::number(property("QCS_averaging").toDouble(), 'f', 8));
+	s.writeTextElement("peakhold", property("QCS_peakhold").toBool() ? "true" : "false");
+	s.writeTextElement("peakdecay", QString::number(property("QCS_peakdecay").toDouble(), 'f', 8));
+	s.writeTextElement("logfreq", property("QCS_logfreq").toBool() ? "true" : "false");
+	s.writeTextElement("mindb", QString::number(property("QCS_mindb").toDouble(), 'f', 8));
+	s.writeTextElement("maxdb", QString::number(property("QCS_maxdb").toDouble(), 'f', 8));
+
+	s.writeEndElement();
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+	return xmlText;
+}
+
+void QuteSpectrum::setValue(double value)
+{
+	QuteWidget::setValue(value);
+	updateLabel();
+}
+
+void QuteSpectrum::updateLabel()
+{
+	QString chan = (int) m_value < 0 ? tr("all", "meaning 'all' channels in spectrum")
+									 : QString::number((int) m_value);
+	m_label->setText(tr("Spectrum ch:") + chan);
+}
+
+void QuteSpectrum::setCsoundUserData(CsoundUserData *ud)
+{
+	QuteWidget::setCsoundUserData(ud);
+	m_analyzer->setUserData(ud);
+}
+
+void QuteSpectrum::applyInternalProperties()
+{
+	QuteWidget::applyInternalProperties();
+	setValue(property("QCS_value").toDouble());
+	// Loaded properties are strings, QVariant converts them
+	int channel = (int) m_value;
+	m_analyzer->setAnalysis(property("QCS_fftsize").toInt(),
+							property("QCS_overlap").toDouble() / 100.0,
+							channel > 0 ? channel : -1);
+	m_analyzer->setSmoothing(property("QCS_averaging").toDouble(),
+							 property("QCS_peakhold").toBool(),
+							 property("QCS_peakdecay").toDouble());
+	static_cast<SpectrumView *>(m_widget)->setScale(property("QCS_logfreq").toBool(),
+													property("QCS_mindb").toDouble(),
+													property("QCS_maxdb").toDouble());
+}
+
+void QuteSpectrum::createPropertiesDialog()
+{
+	QuteWidget::createPropertiesDialog();
+	dialog->setWindowTitle(tr("Spectrum Analyzer"));
+	QLabel *label = new QLabel(dialog);
+	label->setText(tr("Channel"));
+	layout->addWidget(label, 6, 0, Qt::AlignRight|Qt::AlignVCenter);
+	channelBox = new QComboBox(dialog);
+	channelBox->addItem(tr("all"), QVariant((int) -255));
+	for (int i = 1; i <= 8; i++) {
+		channelBox->addItem(QString("Ch.%1").arg(i), QVariant(i));
+	}
+	layout->addWidget(channelBox, 6, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("FFT size"));
+	layout->addWidget(label, 6, 2, Qt::AlignRight|Qt::AlignVCenter);
+	fftSizeBox = new QComboBox(dialog);
+	for (int size = QCS_SPECTRUM_MIN_FFT_SIZE; size <= QCS_SPECTRUM_MAX_FFT_SIZE; size *= 2) {
+		fftSizeBox->addItem(QString::number(size), QVariant(size));
+	}
+	layout->addWidget(fftSizeBox, 6, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Overlap (%)"));
+	layout->addWidget(label, 7, 0, Qt::AlignRight|Qt::AlignVCenter);
+	overlapBox = new QDoubleSpinBox(dialog);
+	overlapBox->setRange(0, 95);
+	layout->addWidget(overlapBox, 7, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Averaging (ms)"));
+	layout->addWidget(label, 7, 2, Qt::AlignRight|Qt::AlignVCenter);
+	averagingBox = new QDoubleSpinBox(dialog);
+	averagingBox->setRange(0, 10000);
+	averagingBox->setToolTip(tr("Time constant of the average, 0 shows every frame"));
+	layout->addWidget(averagingBox, 7, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	peakHoldCheckBox = new QCheckBox(tr("Peak hold"), dialog);
+	peakHoldCheckBox->setToolTip(tr("Click the analyzer to reset the peaks"));
+	layout->addWidget(peakHoldCheckBox, 8, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Peak decay (dB/s)"));
+	layout->addWidget(label, 8, 2, Qt::AlignRight|Qt::AlignVCenter);
+	peakDecayBox = new QDoubleSpinBox(dialog);
+	peakDecayBox->setRange(0, 200);
+	peakDecayBox->setToolTip(tr("0 holds the peaks until the analyzer is clicked"));
+	layout->addWidget(peakDecayBox, 8, 3, Qt::AlignLeft|Qt::AlignVCenter);
+	logFrequencyCheckBox = new QCheckBox(tr("Logarithmic frequency"), dialog);
+	layout->addWidget(logFrequencyCheckBox, 9, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	label = new QLabel(dialog);
+	label->setText(tr("Range (dB)"));
+	layout->addWidget(label, 10, 0, Qt::AlignRight|Qt::AlignVCenter);
+	minDbBox = new QDoubleSpinBox(dialog);
+	minDbBox->setRange(-200, 0);
+	layout->addWidget(minDbBox, 10, 1, Qt::AlignLeft|Qt::AlignVCenter);
+	maxDbBox = new QDoubleSpinBox(dialog);
+	maxDbBox->setRange(-199, 40);
+	layout->addWidget(maxDbBox, 10, 2, Qt::AlignLeft|Qt::AlignVCenter);
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+	channelBox->setCurrentIndex(qMax(0, channelBox->findData(QVariant((int) m_value))));
+	fftSizeBox->setCurrentIndex(qMax(0, fftSizeBox->findData(QVariant(property("QCS_fftsize").toInt()))));
+	overlapBox->setValue(property("QCS_overlap").toDouble());
+	averagingBox->setValue(property("QCS_averaging").toDouble());
+	peakHoldCheckBox->setChecked(property("QCS_peakhold").toBool());
+	peakDecayBox->setValue(property("QCS_peakdecay").toDouble());
+	logFrequencyCheckBox->setChecked(property("QCS_logfreq").toBool());
+	minDbBox->setValue(property("QCS_mindb").toDouble());
+	maxDbBox->setValue(property("QCS_maxdb").toDouble());
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+}
+
+void QuteSpectrum::applyProperties()
+{
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.lockForRead();
+#endif
+	setProperty("QCS_value", channelBox->itemData(channelBox->currentIndex()).toInt());
+	setProperty("QCS_fftsize", fftSizeBox->itemData(fftSizeBox->currentIndex()).toInt());
+	setProperty("QCS_overlap", overlapBox->value());
+	setProperty("QCS_averaging", averagingBox->value());
+	setProperty("QCS_peakhold", peakHoldCheckBox->isChecked());
+	setProperty("QCS_peakdecay", peakDecayBox->value());
+	setProperty("QCS_logfreq", logFrequencyCheckBox->isChecked());
+	setProperty("QCS_mindb", minDbBox->value());
+	setProperty("QCS_maxdb", maxDbBox->value());
+#ifdef  USE_WIDGET_MUTEX
+	widgetLock.unlock();
+#endif
+	//Must be last to make sure the widgetChanged signal is last
+	QuteWidget::applyProperties();
+}
+
+void QuteSpectrum::updateData()
+{
+	double sampleRate;
+	if (!m_analyzer->takeResult(m_frame, m_average, m_peak, sampleRate)) {
+		return;
+	}
+	static_cast<SpectrumView *>(m_widget)->setSpectrum(m_average, m_peak,
+													   property("QCS_peakhold").toBool(),
+													   sampleRate);
+}
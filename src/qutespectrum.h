@@ -0,0 +1,162 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef QUTESPECTRUM_H
+#define QUTESPECTRUM_H
+
+#include "qutewidget.h"
+#include "spectrumworker.h"
+
+//
+// Averaging and peak hold of the analysis frames. Runs on the worker thread
+// and publishes the last result for the GUI under a lock that is only held
+// for the copy.
+//
+class SpectrumAnalyzer : public SpectrumWorker
+{
+	Q_OBJECT
+public:
+	SpectrumAnalyzer(QObject *parent = 0);
+	~SpectrumAnalyzer();
+
+	// averagingMs is the time constant of the exponential average, 0 for none.
+	// peakDecay is in dB per second, 0 holds peaks until resetPeaks()
+	void setSmoothing(double averagingMs, bool peakHold, double peakDecay);
+	// Copies the latest spectrum if there is a newer one than frame.
+	// Values are power, bin 0 to bins - 1
+	bool takeResult(quint64 &frame, QVector<double> &average, QVector<double> &peak,
+					double &sampleRate);
+
+public slots:
+	void resetPeaks();
+
+protected:
+	virtual void processFrame(const double *power, int bins, double sampleRate,
+							  double seconds);
+	virtual void analysisReset(int bins);
+
+private:
+	QMutex m_smoothingMutex;
+	double m_averagingMs;
+	bool m_peakHold;
+	double m_peakDecay;
+	bool m_resetPeaks;
+
+	// Worker thread only
+	QVector<double> m_average;
+	QVector<double> m_peak;
+	bool m_first;
+
+	QMutex m_resultMutex;
+	QVector<double> m_resultAverage;
+	QVector<double> m_resultPeak;
+	double m_resultSampleRate;
+	quint64 m_resultFrame;
+};
+
+//
+// Draws the spectrum in dB on a linear or logarithmic frequency axis
+//
+class SpectrumView : public QWidget
+{
+	Q_OBJECT
+public:
+	SpectrumView(QWidget *parent);
+
+	void setScale(bool logFrequency, double minDb, double maxDb);
+	void setColors(QColor color, QColor peakColor);
+	void setSpectrum(const QVector<double> &average, const QVector<double> &peak,
+					 bool showPeak, double sampleRate);
+	void clear();
+
+signals:
+	void clicked();
+
+protected:
+	virtual void paintEvent(QPaintEvent *event);
+	virtual void resizeEvent(QResizeEvent *event);
+	virtual void mousePressEvent(QMouseEvent *event);
+
+private:
+	void columnValues(const QVector<double> &power, QVector<QPointF> &points);
+	void paintGrid(QPainter *painter);
+
+	bool m_logFrequency;
+	double m_minDb;
+	double m_maxDb;
+	QColor m_color;
+	QColor m_peakColor;
+	bool m_showPeak;
+	double m_sampleRate;
+	int m_bins;
+	SpectrumScale m_scale;
+	QVector<double> m_columnPower;
+	QVector<QPointF> m_points;
+	QVector<QPointF> m_peakPoints;
+	QVector<QPointF> m_fill;
+};
+
+class QuteSpectrum : public QuteWidget
+{
+	Q_OBJECT
+public:
+	QuteSpectrum(QWidget *parent);
+	~QuteSpectrum();
+
+	virtual QString getWidgetLine() { return QString(""); }
+	virtual QString getWidgetXmlText();
+	virtual QString getWidgetType() { return QString("BSBSpectrum"); }
+	virtual void applyInternalProperties();
+	virtual void createPropertiesDialog();
+	virtual void setCsoundUserData(CsoundUserData *ud);
+	void setValue(double value); // Channel, negative for all
+	// Run the analysis thread with the performance
+	void startAnalysis() { m_analyzer->startAnalysis(); }
+	void stopAnalysis() { m_analyzer->stop(); }
+
+public slots:
+	void updateData();
+
+protected:
+	virtual void applyProperties();
+
+	SpectrumAnalyzer *m_analyzer;
+	QLabel *m_label;
+	QComboBox *channelBox;
+	QComboBox *fftSizeBox;
+	QDoubleSpinBox *overlapBox;
+	QDoubleSpinBox *averagingBox;
+	QCheckBox *peakHoldCheckBox;
+	QDoubleSpinBox *peakDecayBox;
+	QCheckBox *logFrequencyCheckBox;
+	QDoubleSpinBox *minDbBox;
+	QDoubleSpinBox *maxDbBox;
+
+private:
+	void updateLabel();
+
+	quint64 m_frame;
+	QVector<double> m_average;
+	QVector<double> m_peak;
+};
+
+#endif // QUTESPECTRUM_H
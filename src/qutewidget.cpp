@@ -57,6 +57,8 @@ QuteWidget::QuteWidget(QWidget *parent):
 	setProperty("QCS_visible", true);
 	setProperty("QCS_midichan", 0);
 	setProperty("QCS_midicc", -3);
+	setProperty("QCS_smoothing", (int) ControlSmoother::None);
+	setProperty("QCS_smoothtime", 20.0);
 }
 
 QuteWidget::~QuteWidget()
@@ -121,6 +123,11 @@ void QuteWidget::setMidiValue2(int /* value */)
     qDebug() << "Not available for this widget." << this;
 }
 
+void QuteWidget::setMidiValue14(int value)
+{
+	setMidiValue(value >> 7);
+}
+
 void QuteWidget::widgetMessage(QString path, QString text)
 {
     qDebug() << text;
@@ -178,6 +185,13 @@ void QuteWidget::createXmlWriter(QXmlStreamWriter &s)
 	s.writeTextElement("visible", property("QCS_visible").toBool() ? "true":"false");
 	s.writeTextElement("midichan", QString::number(property("QCS_midichan").toInt()));
 	s.writeTextElement("midicc", QString::number(property("QCS_midicc").toInt()));
+	int smoothing = property("QCS_smoothing").toInt();
+	if (acceptsMidi() && smoothing != ControlSmoother::None) {
+		s.writeStartElement("smoothing");
+		s.writeAttribute("mode", ControlSmoother::modeName(smoothing));
+		s.writeCharacters(QString::number(property("QCS_smoothtime").toDouble()));
+		s.writeEndElement();
+	}
 }
 
 double QuteWidget::getValue()
@@ -471,6 +485,23 @@ void QuteWidget::createPropertiesDialog()
 
 		midiLearnButton = new QPushButton(tr("Midi learn"));
 		layout->addWidget(midiLearnButton,14,4, Qt::AlignLeft|Qt::AlignVCenter);
+
+		label = new QLabel(dialog);
+		label->setText(tr("Smoothing"));
+		layout->addWidget(label, 13, 0, Qt::AlignRight|Qt::AlignVCenter);
+		smoothingComboBox = new QComboBox(dialog);
+		smoothingComboBox->addItem(tr("None"), (int) ControlSmoother::None);
+		smoothingComboBox->addItem(tr("Linear ramp"), (int) ControlSmoother::Linear);
+		smoothingComboBox->addItem(tr("One pole"), (int) ControlSmoother::OnePole);
+		smoothingComboBox->setToolTip(tr("Smooths the values sent to Csound on every k-cycle. Takes effect on the next run"));
+		layout->addWidget(smoothingComboBox, 13, 1, Qt::AlignLeft|Qt::AlignVCenter);
+		label = new QLabel(dialog);
+		label->setText(tr("Time (ms) ="));
+		layout->addWidget(label, 13, 2, Qt::AlignRight|Qt::AlignVCenter);
+		smoothTimeSpinBox = new QDoubleSpinBox(dialog);
+		smoothTimeSpinBox->setRange(0, 10000);
+		smoothTimeSpinBox->setDecimals(1);
+		layout->addWidget(smoothTimeSpinBox, 13, 3, Qt::AlignLeft|Qt::AlignVCenter);
 	}
 	acceptButton = new QPushButton(tr("Ok"));
 	acceptButton->setDefault(true);
@@ -490,6 +521,8 @@ void QuteWidget::createPropertiesDialog()
 	if (acceptsMidi()) {
 		midiccSpinBox->setValue(this->m_midicc);
 		midichanSpinBox->setValue(this->m_midichan);
+		smoothingComboBox->setCurrentIndex(smoothingComboBox->findData(property("QCS_smoothing").toInt()));
+		smoothTimeSpinBox->setValue(property("QCS_smoothtime").toDouble());
 	}
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.unlock();
@@ -510,6 +543,8 @@ void QuteWidget::applyProperties()
 	if (acceptsMidi()) {
 		setProperty("QCS_midicc", midiccSpinBox->value());
 		setProperty("QCS_midichan", midichanSpinBox->value());
+		setProperty("QCS_smoothing", smoothingComboBox->itemData(smoothingComboBox->currentIndex()).toInt());
+		setProperty("QCS_smoothtime", smoothTimeSpinBox->value());
 	}
 #ifdef  USE_WIDGET_MUTEX
 	widgetLock.unlock();
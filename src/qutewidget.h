@@ -31,14 +31,13 @@
 #include <QtXml>
 
 #define QCS_CURRENT_XML_VERSION "2"
-#define QCS_CURVE_BUFFER_SIZE 256
 //#define USE_WIDGET_MUTEX
 
 #include "csoundengine.h"
 
 enum QuteWidgetType { UNKNOWN=0, SPINBOX=1, LINEEDIT, CHECKBOX, SLIDER, KNOB, SCROLLNUMBER,
                       BUTTON, DROPDOWN, CONTROLLER, GRAPH, SCOPE, CONSOLE,
-                      TABLEDISPLAY };
+                      TABLEDISPLAY, SPECTRUM, SPECTROGRAM };
 
 class QuteWidget : public QWidget
 {
@@ -53,6 +52,7 @@ public:
 	virtual void setValue(QString);
 	virtual void setMidiValue(int value);
 	virtual void setMidiValue2(int value);
+	virtual void setMidiValue14(int value); // 0-16383, from 14-bit controller pairs
 	virtual bool acceptsMidi() {return false;}
 	virtual void setLocked(bool locked) {m_locked = locked;}
 
@@ -100,6 +100,8 @@ protected:
 	QSpinBox *midiccSpinBox;
 	QSpinBox *midichanSpinBox;
 	QPushButton *midiLearnButton;
+	QComboBox *smoothingComboBox;
+	QDoubleSpinBox *smoothTimeSpinBox;
 	QWidget *m_widget;
 	QDialog *dialog;
 	QGridLayout *layout;  // For preference dialog
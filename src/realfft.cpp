@@ -0,0 +1,118 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "realfft.h"
+
+#include <cmath>
+
+void RealFft::setSize(int size)
+{
+	if (size == m_size) {
+		return;
+	}
+	m_size = size;
+	int half = size / 2;
+	m_re.resize(half);
+	m_im.resize(half);
+	m_cos.resize(half);
+	m_sin.resize(half);
+	const double twoPi = 6.283185307179586476925286766559;
+	for (int k = 0; k < half; k++) {
+		m_cos[k] = std::cos(twoPi * k / size);
+		m_sin[k] = -std::sin(twoPi * k / size);
+	}
+	m_bitReverse.resize(half);
+	int bits = 0;
+	while ((1 << bits) < half) {
+		bits++;
+	}
+	for (int i = 0; i < half; i++) {
+		int r = 0;
+		for (int b = 0; b < bits; b++) {
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		m_bitReverse[i] = r;
+	}
+}
+
+// In place radix 2 transform of m_re, m_im
+void RealFft::complexFft()
+{
+	int n = m_size / 2;
+	double *re = m_re.data();
+	double *im = m_im.data();
+	for (int i = 0; i < n; i++) {
+		int j = m_bitReverse[i];
+		if (j > i) {
+			qSwap(re[i], re[j]);
+			qSwap(im[i], im[j]);
+		}
+	}
+	const double *c = m_cos.constData();
+	const double *s = m_sin.constData();
+	for (int length = 2; length <= n; length <<= 1) {
+		int half = length / 2;
+		// The tables are for size (2 n), step through them accordingly
+		int step = m_size / length;
+		for (int start = 0; start < n; start += length) {
+			for (int k = 0; k < half; k++) {
+				double wr = c[k * step];
+				double wi = s[k * step];
+				int a = start + k;
+				int b = a + half;
+				double tr = re[b] * wr - im[b] * wi;
+				double ti = re[b] * wi + im[b] * wr;
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+}
+
+void RealFft::power(const double *input, double *output)
+{
+	int n = m_size / 2;
+	double *re = m_re.data();
+	double *im = m_im.data();
+	for (int i = 0; i < n; i++) {
+		re[i] = input[2 * i];
+		im[i] = input[2 * i + 1];
+	}
+	complexFft();
+	// Separate the spectra of the even and odd samples and combine them
+	output[0] = (re[0] + im[0]) * (re[0] + im[0]);
+	output[n] = (re[0] - im[0]) * (re[0] - im[0]);
+	for (int k = 1; k < n; k++) {
+		double ar = re[k], ai = im[k];
+		double br = re[n - k], bi = -im[n - k]; // conj(Z[n - k])
+		double evenRe = 0.5 * (ar + br);
+		double evenIm = 0.5 * (ai + bi);
+		double oddRe = 0.5 * (ai - bi);   // (Z[k] - conj(Z[n - k])) / 2i
+		double oddIm = -0.5 * (ar - br);
+		double wr = m_cos[k], wi = m_sin[k];
+		double xr = evenRe + oddRe * wr - oddIm * wi;
+		double xi = evenIm + oddRe * wi + oddIm * wr;
+		output[k] = xr * xr + xi * xi;
+	}
+}
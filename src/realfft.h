@@ -0,0 +1,55 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef REALFFT_H
+#define REALFFT_H
+
+#include <QVector>
+
+//
+// Forward FFT of real input, for the analysis widgets. The input is packed
+// into a complex FFT of half the size, so the cost is about that of a
+// complex FFT of size/2. Tables are computed by setSize(), transforms don't
+// allocate.
+//
+class RealFft
+{
+public:
+	RealFft() : m_size(0) {}
+
+	void setSize(int size); // A power of two, at least 4
+	int size() { return m_size; }
+	// Writes re*re + im*im of bins 0 to size/2 (size/2 + 1 values)
+	void power(const double *input, double *output);
+
+private:
+	void complexFft();
+
+	int m_size;
+	QVector<double> m_re; // size/2 points being transformed
+	QVector<double> m_im;
+	QVector<double> m_cos; // exp(-2 pi i k / size) for k < size/2
+	QVector<double> m_sin;
+	QVector<int> m_bitReverse;
+};
+
+#endif // REALFFT_H
@@ -0,0 +1,214 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "scopetrigger.h"
+
+ScopeTrigger::ScopeTrigger()
+{
+	m_mode = Free;
+	m_slope = Rising;
+	m_level = 0;
+	m_hysteresis = 0.01;
+	m_interpolate = false;
+	m_sweepFrames = 0;
+	m_pretriggerFrames = 0;
+	m_holdoffFrames = 0;
+	m_autoFrames = 0;
+	m_mask = 0;
+	m_state = Searching;
+	m_sweepStart = 0;
+	m_holdoffEnd = 0;
+	m_pendingOffset = 0;
+	m_pendingTriggered = false;
+	m_sweepOffset = 0;
+	m_sweepTriggered = false;
+	reset();
+}
+
+QString ScopeTrigger::modeName(int mode)
+{
+	switch (mode) {
+	case Auto:
+		return "auto";
+	case Normal:
+		return "normal";
+	case Single:
+		return "single";
+	default:
+		return "free";
+	}
+}
+
+int ScopeTrigger::modeFromName(QString name)
+{
+	if (name == "auto") {
+		return Auto;
+	}
+	else if (name == "normal") {
+		return Normal;
+	}
+	else if (name == "single") {
+		return Single;
+	}
+	return Free;
+}
+
+void ScopeTrigger::setMode(int mode, int slope, double level, double hysteresis, bool interpolate)
+{
+	if (mode != m_mode) {
+		m_mode = mode;
+		reset();
+	}
+	m_slope = slope;
+	m_level = (MYFLT) level;
+	m_hysteresis = (MYFLT) qAbs(hysteresis);
+	m_interpolate = interpolate;
+}
+
+void ScopeTrigger::setTiming(int sweepFrames, int pretriggerFrames, int holdoffFrames, int autoFrames)
+{
+	sweepFrames = qMax(1, sweepFrames);
+	pretriggerFrames = qBound(0, pretriggerFrames, sweepFrames - 1);
+	m_holdoffFrames = qMax(0, holdoffFrames);
+	m_autoFrames = qMax(sweepFrames, autoFrames);
+	if (sweepFrames == m_sweepFrames && pretriggerFrames == m_pretriggerFrames) {
+		return;
+	}
+	m_sweepFrames = sweepFrames;
+	m_pretriggerFrames = pretriggerFrames;
+	int size = 1;
+	while (size < sweepFrames + 1) {
+		size <<= 1;
+	}
+	m_history.fill(0, size);
+	m_mask = size - 1;
+	reset();
+}
+
+void ScopeTrigger::reset()
+{
+	m_count = 0;
+	m_first = 0;
+	m_previous = 0;
+	m_armed = false;
+	m_autoDeadline = m_autoFrames;
+	m_state = (m_state == Stopped && m_mode == Single) ? Stopped : Searching;
+}
+
+void ScopeTrigger::arm()
+{
+	if (m_state == Stopped) {
+		m_first = m_count;
+		m_armed = false;
+		m_autoDeadline = m_count + m_autoFrames;
+		m_state = Searching;
+	}
+}
+
+bool ScopeTrigger::process(const MYFLT *samples, int count)
+{
+	bool completed = false;
+	if (m_history.isEmpty() || m_mode == Free) {
+		return false;
+	}
+	MYFLT *history = m_history.data();
+	for (int i = 0; i < count; i++) {
+		MYFLT x = samples[i];
+		quint64 n = m_count;
+		history[n & m_mask] = x;
+		if (m_state == Holdoff && n >= m_holdoffEnd) {
+			m_state = Searching;
+			m_autoDeadline = n + m_autoFrames;
+		}
+		if (m_state == Searching) {
+			bool crossed = false;
+			if (m_slope == Rising) {
+				if (x <= m_level - m_hysteresis) {
+					m_armed = true;
+				}
+				else if (m_armed && x >= m_level && n > m_first) {
+					crossed = true;
+				}
+			}
+			else {
+				if (x >= m_level + m_hysteresis) {
+					m_armed = true;
+				}
+				else if (m_armed && x <= m_level && n > m_first) {
+					crossed = true;
+				}
+			}
+			if (crossed && n - m_first >= (quint64) m_pretriggerFrames) {
+				double offset = 0;
+				if (m_interpolate && x != m_previous) {
+					// Fraction of the frame between the crossing and sample n
+					offset = (double) (x - m_level) / (double) (x - m_previous);
+				}
+				m_armed = false;
+				startSweep(n - m_pretriggerFrames, offset, true);
+			}
+			else if (m_mode == Auto && n >= m_autoDeadline
+					 && n + 1 - m_first >= (quint64) m_sweepFrames) {
+				// No trigger for a while: show the latest audio
+				startSweep(n + 1 - m_sweepFrames, 0, false);
+			}
+		}
+		if (m_state == Capturing && n + 1 >= m_sweepStart + m_sweepFrames) {
+			finishSweep(n);
+			completed = true;
+		}
+		m_previous = x;
+		m_count++;
+	}
+	return completed;
+}
+
+void ScopeTrigger::startSweep(quint64 start, double offset, bool triggered)
+{
+	m_sweepStart = start;
+	m_pendingOffset = offset;
+	m_pendingTriggered = triggered;
+	m_state = Capturing;
+}
+
+void ScopeTrigger::finishSweep(quint64 index)
+{
+	m_sweep.resize(m_sweepFrames);
+	MYFLT *sweep = m_sweep.data();
+	const MYFLT *history = m_history.constData();
+	for (int i = 0; i < m_sweepFrames; i++) {
+		sweep[i] = history[(m_sweepStart + i) & m_mask];
+	}
+	m_sweepOffset = m_pendingOffset;
+	m_sweepTriggered = m_pendingTriggered;
+	if (m_mode == Single && m_sweepTriggered) {
+		m_state = Stopped;
+	}
+	else if (m_holdoffFrames > 0) {
+		m_holdoffEnd = index + 1 + m_holdoffFrames;
+		m_state = Holdoff;
+	}
+	else {
+		m_state = Searching;
+		m_autoDeadline = index + 1 + m_autoFrames;
+	}
+}
@@ -0,0 +1,117 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef SCOPETRIGGER_H
+#define SCOPETRIGGER_H
+
+#include <QString>
+#include <QVector>
+
+#include "types.h"
+
+//
+// Trigger for the oscilloscope. Samples are fed as they arrive from the
+// output buffer (process()), the search runs incrementally over them and
+// only complete sweeps are handed to the display, so periodic waveforms
+// stand still whatever the refresh rate.
+// A sweep starts pretrigger frames before the trigger. The level must be
+// crossed after the signal has gone past level -/+ hysteresis, so noise
+// around the level doesn't retrigger. After a sweep, triggers are ignored
+// for holdoff frames.
+//
+class ScopeTrigger
+{
+public:
+	enum Mode {
+		Free = 0,   // No trigger, the display shows the latest audio
+		Auto = 1,   // Free runs when there is no trigger for a while
+		Normal = 2, // Only triggered sweeps, the last one is kept
+		Single = 3  // Stops after one sweep until arm()
+	};
+	enum Slope {
+		Rising = 0,
+		Falling = 1
+	};
+
+	ScopeTrigger();
+
+	static QString modeName(int mode);
+	static int modeFromName(QString name);
+
+	void setMode(int mode, int slope, double level, double hysteresis, bool interpolate);
+	// Resets the trigger when the sweep length changes
+	void setTiming(int sweepFrames, int pretriggerFrames, int holdoffFrames, int autoFrames);
+	int mode() { return m_mode; }
+	void reset(); // Forgets the history, after a gap in the input
+	void arm();   // Waits for a new sweep in single mode
+	bool isStopped() { return m_state == Stopped; }
+
+	// Returns true if a sweep was completed. Only the latest is kept
+	bool process(const MYFLT *samples, int count);
+
+	const MYFLT *sweep() const { return m_sweep.constData(); }
+	int sweepFrames() { return m_sweep.size(); }
+	// Where the trigger crossed the level, in frames before the pretrigger
+	// sample. Non zero only with interpolation
+	double sweepOffset() { return m_sweepOffset; }
+	bool sweepTriggered() { return m_sweepTriggered; }
+
+private:
+	enum State {
+		Holdoff,
+		Searching,
+		Capturing,
+		Stopped
+	};
+
+	void startSweep(quint64 start, double offset, bool triggered);
+	void finishSweep(quint64 index);
+
+	int m_mode;
+	int m_slope;
+	MYFLT m_level;
+	MYFLT m_hysteresis;
+	bool m_interpolate;
+	int m_sweepFrames;
+	int m_pretriggerFrames;
+	int m_holdoffFrames;
+	int m_autoFrames;
+
+	QVector<MYFLT> m_history; // Power of two
+	quint64 m_mask;
+	quint64 m_count;  // Samples processed, the index of the next one
+	quint64 m_first;  // Index of the first sample after the last reset
+	MYFLT m_previous;
+	State m_state;
+	bool m_armed;     // The signal went past the hysteresis band
+	quint64 m_sweepStart;
+	quint64 m_holdoffEnd;
+	quint64 m_autoDeadline;
+	double m_pendingOffset;
+	bool m_pendingTriggered;
+
+	QVector<MYFLT> m_sweep;
+	double m_sweepOffset;
+	bool m_sweepTriggered;
+};
+
+#endif // SCOPETRIGGER_H
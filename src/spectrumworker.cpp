@@ -0,0 +1,276 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "spectrumworker.h"
+#include "csoundengine.h"
+#include "tracer.h"
+
+#include <cmath>
+#include <cstring>
+
+// Frames read from the output buffer at a time
+#define QCS_SPECTRUM_CHUNK_FRAMES 4096
+
+SpectrumWorker::SpectrumWorker(QObject *parent) : QThread(parent)
+{
+	m_ud = 0;
+	m_fftSize = 2048;
+	m_overlap = 0.5;
+	m_channel = -1;
+	m_settingsChanged = true;
+	m_currentUd = 0;
+	m_size = 0;
+	m_hop = 1;
+	m_channelIndex = -1;
+	m_position = 0;
+	m_filled = 0;
+}
+
+SpectrumWorker::~SpectrumWorker()
+{
+	stop();
+}
+
+void SpectrumWorker::setUserData(CsoundUserData *ud)
+{
+	if (ud == 0) {
+		stop();
+	}
+	m_settingsMutex.lock();
+	m_ud = ud;
+	m_settingsChanged = true;
+	m_settingsMutex.unlock();
+	if (ud != 0 && ud->perfThread != 0) {  // Created during a performance
+		startAnalysis();
+	}
+}
+
+void SpectrumWorker::startAnalysis()
+{
+	QMutexLocker locker(&m_settingsMutex);
+	if (m_ud != 0 && !isRunning()) {
+		m_settingsChanged = true;  // Channels and rate may have changed
+		start(QThread::LowPriority);
+	}
+}
+
+void SpectrumWorker::setAnalysis(int fftSize, double overlap, int channel)
+{
+	int size = QCS_SPECTRUM_MIN_FFT_SIZE;
+	while (size < fftSize && size < QCS_SPECTRUM_MAX_FFT_SIZE) {
+		size <<= 1;
+	}
+	QMutexLocker locker(&m_settingsMutex);
+	m_fftSize = size;
+	m_overlap = qBound(0.0, overlap, 0.95);
+	m_channel = channel;
+	m_settingsChanged = true;
+}
+
+void SpectrumWorker::stop()
+{
+	requestInterruption();
+	wait();
+	m_currentUd = 0;
+}
+
+bool SpectrumWorker::applySettings()
+{
+	QMutexLocker locker(&m_settingsMutex);
+	if (!m_settingsChanged) {
+		return m_currentUd != 0;
+	}
+	m_settingsChanged = false;
+	m_currentUd = m_ud;
+	m_channelIndex = m_channel < 0 ? -1 : m_channel - 1;
+	if (m_fftSize != m_size) {
+		m_size = m_fftSize;
+		m_fft.setSize(m_size);
+		m_window.resize(m_size);
+		// Hann window, scaled so that a full scale sine has a power of 1
+		const double twoPi = 6.283185307179586476925286766559;
+		double gain = 4.0 / m_size;
+		for (int i = 0; i < m_size; i++) {
+			m_window[i] = gain * 0.5 * (1 - std::cos(twoPi * i / m_size));
+		}
+		m_input.resize(m_size);
+		m_windowed.resize(m_size);
+		m_power.resize(m_size / 2 + 1);
+	}
+	m_hop = qMax(1, (int) (m_size * (1 - m_overlap)));
+	m_filled = 0;
+	locker.unlock();
+	analysisReset(m_size / 2 + 1);
+	return m_currentUd != 0;
+}
+
+void SpectrumWorker::run()
+{
+	QCS_TRACE_THREAD("Spectrum analysis");
+	while (!isInterruptionRequested()) {
+		if (!applySettings()) {
+			msleep(50);
+			continue;
+		}
+		int channels = m_currentUd->numChnls;
+		double sampleRate = m_currentUd->sampleRate;
+		if (channels <= 0 || sampleRate <= 0 || m_channelIndex >= channels) {
+			msleep(50);
+			continue;
+		}
+		m_chunk.resize(QCS_SPECTRUM_CHUNK_FRAMES * channels);
+		bool skipped;
+		long count = m_currentUd->audioOutputBuffer.copySince(m_position, m_chunk.data(),
+															  m_chunk.size(), channels,
+															  &skipped);
+		if (skipped && m_filled > 0) {
+			m_filled = 0;  // Don't join audio across a gap
+			analysisReset(m_size / 2 + 1);
+		}
+		if (count == 0) {
+			msleep(10);
+			continue;
+		}
+		QCS_TRACE_SCOPE("spectrum");
+		int frames = count / channels;
+		const MYFLT *in = m_chunk.constData();
+		double *input = m_input.data();
+		for (int i = 0; i < frames; i++) {
+			double sample;
+			if (m_channelIndex < 0) {
+				sample = 0;
+				for (int k = 0; k < channels; k++) {
+					sample += in[i * channels + k];
+				}
+				sample /= channels;
+			}
+			else {
+				sample = in[i * channels + m_channelIndex];
+			}
+			input[m_filled++] = sample;
+			if (m_filled == m_size) {
+				for (int j = 0; j < m_size; j++) {
+					m_windowed[j] = input[j] * m_window[j];
+				}
+				m_fft.power(m_windowed.constData(), m_power.data());
+				processFrame(m_power.constData(), m_power.size(), sampleRate,
+							 m_hop / sampleRate);
+				memmove(input, input + m_hop, (m_size - m_hop) * sizeof(double));
+				m_filled = m_size - m_hop;
+			}
+		}
+	}
+}
+
+
+SpectrumScale::SpectrumScale()
+{
+	m_bins = 0;
+	m_sampleRate = 0;
+	m_logFrequency = false;
+}
+
+bool SpectrumScale::setup(int pixels, int bins, double sampleRate, bool logFrequency)
+{
+	if (pixels == m_firstBin.size() && bins == m_bins && sampleRate == m_sampleRate
+			&& logFrequency == m_logFrequency) {
+		return false;
+	}
+	m_bins = bins;
+	m_sampleRate = sampleRate;
+	m_logFrequency = logFrequency;
+	m_firstBin.resize(pixels);
+	m_lastBin.resize(pixels);
+	m_fraction.resize(pixels);
+	if (!isValid()) {
+		m_firstBin.fill(0);
+		m_lastBin.fill(0);
+		return true;
+	}
+	double binWidth = m_sampleRate / (2.0 * (m_bins - 1));
+	for (int x = 0; x < pixels; x++) {
+		double low = frequencyAt(x) / binWidth;
+		double high = frequencyAt(x + 1) / binWidth;
+		int first = (int) std::ceil(low);
+		int last = qMin((int) std::floor(high), m_bins - 1);
+		if (last >= first) {
+			m_firstBin[x] = first;
+			m_lastBin[x] = last;
+		}
+		else {  // No bin inside the pixel, interpolate at its center
+			double center = qMin((low + high) / 2, m_bins - 1.0);
+			int bin = qMin((int) center, m_bins - 2);
+			m_firstBin[x] = bin;
+			m_lastBin[x] = -1;
+			m_fraction[x] = center - bin;
+		}
+	}
+	return true;
+}
+
+double SpectrumScale::frequencyAt(double pixel)
+{
+	double nyquist = m_sampleRate / 2;
+	double position = pixel / qMax(1, pixels());
+	if (m_logFrequency) {
+		return QCS_SPECTRUM_MIN_FREQUENCY * std::pow(nyquist / QCS_SPECTRUM_MIN_FREQUENCY, position);
+	}
+	return nyquist * position;
+}
+
+double SpectrumScale::pixelAt(double frequency)
+{
+	double nyquist = m_sampleRate / 2;
+	if (m_logFrequency) {
+		return pixels() * std::log(frequency / QCS_SPECTRUM_MIN_FREQUENCY)
+				/ std::log(nyquist / QCS_SPECTRUM_MIN_FREQUENCY);
+	}
+	return pixels() * frequency / nyquist;
+}
+
+void SpectrumScale::map(const double *power, double *out)
+{
+	int count = pixels();
+	const int *firstBin = m_firstBin.constData();
+	const int *lastBin = m_lastBin.constData();
+	const double *fraction = m_fraction.constData();
+	if (!isValid()) {
+		for (int x = 0; x < count; x++) {
+			out[x] = 0;
+		}
+		return;
+	}
+	for (int x = 0; x < count; x++) {
+		int bin = firstBin[x];
+		double value;
+		if (lastBin[x] >= bin) {
+			value = power[bin];
+			for (bin++; bin <= lastBin[x]; bin++) {
+				value = qMax(value, power[bin]);
+			}
+		}
+		else {
+			value = power[bin] + fraction[x] * (power[bin + 1] - power[bin]);
+		}
+		out[x] = value;
+	}
+}
@@ -0,0 +1,134 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef SPECTRUMWORKER_H
+#define SPECTRUMWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QVector>
+
+#include "types.h"
+#include "realfft.h"
+
+struct CsoundUserData;
+
+// Lowest frequency of logarithmic scales
+#define QCS_SPECTRUM_MIN_FREQUENCY 20.0
+// FFT sizes offered by the spectrum widgets, powers of two
+#define QCS_SPECTRUM_MIN_FFT_SIZE 256
+#define QCS_SPECTRUM_MAX_FFT_SIZE 32768
+
+//
+// Maps FFT bins to pixels on a linear or logarithmic frequency axis, pixel 0
+// being the lowest frequency. A pixel takes the largest bin it covers, or
+// is interpolated between bins where pixels are narrower than bins. The
+// table is only rebuilt when the size, scale or analysis changes.
+//
+class SpectrumScale
+{
+public:
+	SpectrumScale();
+
+	// Returns true if the table was rebuilt
+	bool setup(int pixels, int bins, double sampleRate, bool logFrequency);
+	int pixels() { return m_firstBin.size(); }
+	bool isValid() { return m_bins >= 2 && m_sampleRate > 0; }
+	double frequencyAt(double pixel);
+	double pixelAt(double frequency);
+	// power has the bins given to setup(), out one value per pixel
+	void map(const double *power, double *out);
+
+private:
+	int m_bins;
+	double m_sampleRate;
+	bool m_logFrequency;
+	// First and last bin of each pixel, or the bin to interpolate from when
+	// the last is -1
+	QVector<int> m_firstBin;
+	QVector<int> m_lastBin;
+	QVector<double> m_fraction;
+};
+
+//
+// Computes windowed power spectra of the engine output for the analysis
+// widgets. It runs on its own thread and reads the samples that the
+// performance thread already copies to audioOutputBuffer, so analysis costs
+// nothing on the audio thread and needs nothing in the csd.
+// Derived classes receive each spectrum in processFrame(), on the worker
+// thread, and publish what they need to the GUI.
+//
+class SpectrumWorker : public QThread
+{
+	Q_OBJECT
+public:
+	SpectrumWorker(QObject *parent = 0);
+	// Derived classes must call stop() in their destructor, processFrame()
+	// can't be called once they are destroyed
+	~SpectrumWorker();
+
+	// The thread only runs during performances of ud, between
+	// startAnalysis() and stop(). A null ud stops it.
+	void setUserData(CsoundUserData *ud);
+	void startAnalysis();
+	// channel is 1 based, negative for the mix of all channels.
+	// overlap is the part of each frame shared with the next one, 0 to 0.95
+	void setAnalysis(int fftSize, double overlap, int channel);
+	// Waits for the thread, the user data is not read after this returns
+	void stop();
+
+protected:
+	virtual void run();
+	// Power of bins 0 to bins - 1, scaled so that a full scale sine is 1.
+	// seconds is the time between frames
+	virtual void processFrame(const double *power, int bins, double sampleRate,
+							  double seconds) = 0;
+	// Called on the worker thread when the analysis size changes or the
+	// audio is interrupted
+	virtual void analysisReset(int bins) { Q_UNUSED(bins); }
+
+private:
+	bool applySettings();
+
+	QMutex m_settingsMutex; // Protects the settings below and m_ud
+	CsoundUserData *m_ud;
+	int m_fftSize;
+	double m_overlap;
+	int m_channel;
+	bool m_settingsChanged;
+
+	// Worker thread only
+	CsoundUserData *m_currentUd;
+	int m_size;
+	int m_hop;
+	int m_channelIndex;
+	quint64 m_position; // In the output buffer
+	RealFft m_fft;
+	QVector<double> m_window;
+	QVector<double> m_input;
+	QVector<double> m_windowed;
+	QVector<double> m_power;
+	QVector<MYFLT> m_chunk;
+	int m_filled;
+};
+
+#endif // SPECTRUMWORKER_H
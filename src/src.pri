@@ -81,6 +81,25 @@ HEADERS = "src/about.h" \
     src/debugpanel.h \
     src/livecodeeditor.h \
     src/newbreakpointdialog.h \
+    src/tracer.h \
+    src/memorydialog.h \
+    src/diskrecorder.h \
+    src/midiqueue.h \
+    src/midiroutingdialog.h \
+    src/midifile.h \
+    src/midiplayerdialog.h \
+    src/midiclock.h \
+    src/virtualmidiinput.h \
+    src/hostinput.h \
+    src/controlsmoother.h \
+    src/scopetrigger.h \
+    src/realfft.h \
+    src/spectrumworker.h \
+    src/qutespectrum.h \
+    src/qutespectrogram.h \
+    src/tablepyramid.h \
+    src/graphbuffer.h \
+    src/tablechanges.h \
     #$$PWD/CsoundHtmlOnlyWrapper.h
 
 SOURCES = "src/about.cpp" \
@@ -141,6 +160,22 @@ SOURCES = "src/about.cpp" \
     src/debugpanel.cpp \
     src/livecodeeditor.cpp \
     src/newbreakpointdialog.cpp \
+    src/tracer.cpp \
+    src/memorydialog.cpp \
+    src/diskrecorder.cpp \
+    src/midiqueue.cpp \
+    src/midiroutingdialog.cpp \
+    src/midifile.cpp \
+    src/midiplayerdialog.cpp \
+    src/midiclock.cpp \
+    src/virtualmidiinput.cpp \
+    src/controlsmoother.cpp \
+    src/scopetrigger.cpp \
+    src/realfft.cpp \
+    src/spectrumworker.cpp \
+    src/qutespectrum.cpp \
+    src/qutespectrogram.cpp \
+    src/tablepyramid.cpp \
     #src/csoundhtmlview.cpp \
     #$$PWD/CsoundHtmlOnlyWrapper.cpp
 
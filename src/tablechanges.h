@@ -0,0 +1,102 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef TABLECHANGES_H
+#define TABLECHANGES_H
+
+#include <QHash>
+#include <QMutex>
+#include <climits>
+
+// Changes remembered per table, older ones are reported as a whole table change
+#define QCS_TABLE_CHANGES_KEPT 16
+
+//
+// Which parts of the function tables changed, for the widgets that display
+// them. Writers (host table writes, "@update" messages) mark index ranges
+// and each change gets a new version of its table. Every reader remembers
+// the last version it saw and asks for the span changed since then, so any
+// number of widgets can follow the same table.
+// Only used from non realtime threads, as it locks and allocates. "@update"
+// messages from the performance thread are queued by QuteTable and marked
+// here on the GUI thread.
+//
+class TableChanges
+{
+public:
+	TableChanges() {}
+
+	void markDirty(int table, int first, int last = INT_MAX)
+	{
+		QMutexLocker locker(&m_mutex);
+		Table &changes = m_tables[table];
+		changes.version++;
+		Change &change = changes.changes[changes.version % QCS_TABLE_CHANGES_KEPT];
+		change.version = changes.version;
+		change.first = first;
+		change.last = last;
+	}
+
+	quint64 version(int table)
+	{
+		QMutexLocker locker(&m_mutex);
+		return m_tables.value(table).version;
+	}
+
+	// Range of indexes changed after version since (inclusive, last can be
+	// INT_MAX for the whole table). Returns the current version, which is
+	// since if nothing changed
+	quint64 changedRange(int table, quint64 since, int *first, int *last)
+	{
+		QMutexLocker locker(&m_mutex);
+		const Table changes = m_tables.value(table);
+		*first = INT_MAX;
+		*last = -1;
+		if (changes.version > since + QCS_TABLE_CHANGES_KEPT) {
+			*first = 0;
+			*last = INT_MAX;
+			return changes.version;
+		}
+		for (quint64 v = since + 1; v <= changes.version; v++) {
+			const Change &change = changes.changes[v % QCS_TABLE_CHANGES_KEPT];
+			*first = qMin(*first, change.first);
+			*last = qMax(*last, change.last);
+		}
+		return changes.version;
+	}
+
+private:
+	struct Change {
+		quint64 version;
+		int first, last;
+	};
+	struct Table {
+		Table() : version(0) {}
+		quint64 version;
+		Change changes[QCS_TABLE_CHANGES_KEPT];
+	};
+
+	QMutex m_mutex;
+	QHash<int, Table> m_tables;
+};
+
+#endif // TABLECHANGES_H
@@ -0,0 +1,142 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "tablepyramid.h"
+
+#include <cmath>
+
+void TablePyramid::setData(const QVector<MYFLT> &data)
+{
+	int size = data.size();
+	if (size != m_data.size() || m_minimum.isEmpty()) {
+		m_data = data;
+		m_minimum.clear();
+		m_maximum.clear();
+		if (size == 0) {
+			return;
+		}
+		int blocks = (size + QCS_TABLE_PYRAMID_BLOCK - 1) / QCS_TABLE_PYRAMID_BLOCK;
+		while (true) {
+			m_minimum.append(QVector<MYFLT>(blocks));
+			m_maximum.append(QVector<MYFLT>(blocks));
+			if (blocks == 1) {
+				break;
+			}
+			blocks = (blocks + 1) / 2;
+		}
+		build(0, m_minimum[0].size() - 1);
+		return;
+	}
+	const MYFLT *oldData = m_data.constData();
+	const MYFLT *newData = data.constData();
+	int first = 0;
+	while (first < size && oldData[first] == newData[first]) {
+		first++;
+	}
+	if (first == size) {
+		return;
+	}
+	int last = size - 1;
+	while (last > first && oldData[last] == newData[last]) {
+		last--;
+	}
+	m_data = data;
+	build(first / QCS_TABLE_PYRAMID_BLOCK, last / QCS_TABLE_PYRAMID_BLOCK);
+}
+
+// Recomputes blocks firstBlock to lastBlock of level 0 and their parents
+void TablePyramid::build(int firstBlock, int lastBlock)
+{
+	const MYFLT *data = m_data.constData();
+	int size = m_data.size();
+	MYFLT *minimum = m_minimum[0].data();
+	MYFLT *maximum = m_maximum[0].data();
+	for (int block = firstBlock; block <= lastBlock; block++) {
+		int start = block * QCS_TABLE_PYRAMID_BLOCK;
+		int end = qMin(start + QCS_TABLE_PYRAMID_BLOCK, size);
+		MYFLT low = data[start];
+		MYFLT high = data[start];
+		for (int i = start + 1; i < end; i++) {
+			low = qMin(low, data[i]);
+			high = qMax(high, data[i]);
+		}
+		minimum[block] = low;
+		maximum[block] = high;
+	}
+	for (int level = 1; level < m_minimum.size(); level++) {
+		firstBlock /= 2;
+		lastBlock /= 2;
+		const MYFLT *childMinimum = m_minimum[level - 1].constData();
+		const MYFLT *childMaximum = m_maximum[level - 1].constData();
+		int children = m_minimum[level - 1].size();
+		minimum = m_minimum[level].data();
+		maximum = m_maximum[level].data();
+		for (int block = firstBlock; block <= lastBlock; block++) {
+			int child = 2 * block;
+			if (child + 1 < children) {
+				minimum[block] = qMin(childMinimum[child], childMinimum[child + 1]);
+				maximum[block] = qMax(childMaximum[child], childMaximum[child + 1]);
+			}
+			else {
+				minimum[block] = childMinimum[child];
+				maximum[block] = childMaximum[child];
+			}
+		}
+	}
+}
+
+void TablePyramid::columnRange(double first, double samplesPerColumn, int columns,
+							   MYFLT *minimum, MYFLT *maximum) const
+{
+	int size = m_data.size();
+	if (size == 0) {
+		return;
+	}
+	// The coarsest level with at least four blocks per column, or the
+	// samples themselves for narrow columns
+	int level = -1;
+	double blockSize = 1;
+	while (level + 1 < m_minimum.size()
+		   && 4 * QCS_TABLE_PYRAMID_BLOCK * std::ldexp(1.0, level + 1) <= samplesPerColumn) {
+		level++;
+		blockSize = QCS_TABLE_PYRAMID_BLOCK * std::ldexp(1.0, level);
+	}
+	const MYFLT *low = level < 0 ? m_data.constData() : m_minimum[level].constData();
+	const MYFLT *high = level < 0 ? m_data.constData() : m_maximum[level].constData();
+	int count = level < 0 ? size : m_minimum[level].size();
+	double position = first / blockSize;
+	double step = samplesPerColumn / blockSize;
+	int start = qBound(0, (int) std::floor(position + 0.5), count - 1);
+	for (int c = 0; c < columns; c++) {
+		position += step;
+		int end = qBound(start + 1, (int) std::floor(position + 0.5), count);
+		MYFLT columnMinimum = low[start];
+		MYFLT columnMaximum = high[start];
+		for (int i = start + 1; i < end; i++) {
+			columnMinimum = qMin(columnMinimum, low[i]);
+			columnMaximum = qMax(columnMaximum, high[i]);
+		}
+		minimum[c] = columnMinimum;
+		maximum[c] = columnMaximum;
+		start = qMin(end, count - 1);
+	}
+}
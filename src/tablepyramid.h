@@ -0,0 +1,67 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef TABLEPYRAMID_H
+#define TABLEPYRAMID_H
+
+#include <QVector>
+
+#include "types.h"
+
+// Samples per block in the finest level
+#define QCS_TABLE_PYRAMID_BLOCK 16
+
+//
+// Minimum and maximum of a table at several resolutions, for drawing tables
+// of any length at any zoom. Level 0 holds blocks of QCS_TABLE_PYRAMID_BLOCK
+// samples and each level halves the number of blocks, so a pixel column
+// is always covered by a handful of blocks of a single level.
+// The pyramid keeps its own copy of the table. Copies share their data, so
+// a pyramid can be updated on a worker thread while the GUI draws from the
+// previous one.
+//
+class TablePyramid
+{
+public:
+	TablePyramid() {}
+
+	// Only the blocks containing samples that differ from the current data
+	// are recomputed, unless the size changed
+	void setData(const QVector<MYFLT> &data);
+	int size() const { return m_data.size(); }
+	bool isEmpty() const { return m_data.isEmpty(); }
+	const MYFLT *data() const { return m_data.constData(); }
+	// Range of each of columns spans of samplesPerColumn samples (at least 1)
+	// starting at sample first. Column edges are rounded to the nearest
+	// block, at most an eighth of a column
+	void columnRange(double first, double samplesPerColumn, int columns,
+					 MYFLT *minimum, MYFLT *maximum) const;
+
+private:
+	void build(int firstBlock, int lastBlock);
+
+	QVector<MYFLT> m_data;
+	QVector<QVector<MYFLT> > m_minimum; // Per level
+	QVector<QVector<MYFLT> > m_maximum;
+};
+
+#endif // TABLEPYRAMID_H
@@ -0,0 +1,184 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#include "tracer.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+#include <cstring>
+
+Tracer *Tracer::instance()
+{
+	static Tracer tracer;
+	return &tracer;
+}
+
+Tracer::Tracer() : m_running(false), m_generation(0), m_buffers(nullptr), m_threadCount(0)
+{
+	m_clock.start();
+}
+
+void Tracer::start()
+{
+	stop();
+	// Threads may still be recording, each one drops its old events itself
+	m_generation.fetch_add(1, std::memory_order_relaxed);
+	m_running.store(true, std::memory_order_release);
+	setThreadName("GUI");  // start() is called from the GUI thread
+}
+
+void Tracer::stop()
+{
+	m_running.store(false, std::memory_order_release);
+}
+
+// Releases the thread's buffer when the thread exits
+struct Tracer::ThreadSlot {
+	ThreadBuffer *buffer = nullptr;
+	~ThreadSlot()
+	{
+		if (buffer != nullptr) {
+			buffer->inUse.store(false, std::memory_order_release);
+		}
+	}
+};
+
+Tracer::ThreadSlot &Tracer::threadSlot()
+{
+	static thread_local ThreadSlot slot;
+	return slot;
+}
+
+// Buffers are claimed the first time a thread records an event or sets its
+// name (this is the only allocation on the recording path). A named thread
+// takes the buffer of an exited thread with the same name, so successive
+// performance or analysis threads continue on the same timeline. An unnamed
+// thread takes any free buffer with no events in the current recording.
+Tracer::ThreadBuffer *Tracer::claimBuffer(const char *name)
+{
+	ThreadBuffer *buffer = m_buffers.load(std::memory_order_acquire);
+	for (; buffer != nullptr; buffer = buffer->next) {
+		bool reusable = name != nullptr
+				? buffer->name != nullptr && strcmp(buffer->name, name) == 0
+				: !hasEvents(buffer);
+		bool inUse = false;
+		if (reusable && buffer->inUse.compare_exchange_strong(inUse, true,
+															  std::memory_order_acq_rel)) {
+			buffer->name = name;
+			return buffer;
+		}
+	}
+	buffer = new ThreadBuffer;
+	buffer->events = new TraceEvent[QCS_TRACE_BUFFER_SIZE];
+	buffer->count.store(0, std::memory_order_relaxed);
+	buffer->generation.store(0, std::memory_order_relaxed);
+	buffer->inUse.store(true, std::memory_order_relaxed);
+	buffer->tid = m_threadCount.fetch_add(1) + 1;
+	buffer->name = name;
+	buffer->next = m_buffers.load(std::memory_order_relaxed);
+	while (!m_buffers.compare_exchange_weak(buffer->next, buffer,
+											std::memory_order_release,
+											std::memory_order_relaxed)) {
+	}
+	return buffer;
+}
+
+// Events of earlier recordings are ignored until the thread resets them
+bool Tracer::hasEvents(ThreadBuffer *buffer)
+{
+	return buffer->count.load(std::memory_order_acquire) > 0
+			&& buffer->generation.load(std::memory_order_relaxed)
+			== m_generation.load(std::memory_order_relaxed);
+}
+
+Tracer::ThreadBuffer *Tracer::threadBuffer()
+{
+	ThreadSlot &slot = threadSlot();
+	if (slot.buffer == nullptr) {
+		slot.buffer = claimBuffer(nullptr);
+	}
+	return slot.buffer;
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 end)
+{
+	ThreadBuffer *buffer = threadBuffer();
+	quint64 generation = m_generation.load(std::memory_order_relaxed);
+	quint64 count = buffer->count.load(std::memory_order_relaxed);
+	if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+		count = 0;  // First event of a new recording
+		buffer->generation.store(generation, std::memory_order_relaxed);
+	}
+	TraceEvent &event = buffer->events[count & (QCS_TRACE_BUFFER_SIZE - 1)];
+	event.name = name;
+	event.start = start;
+	event.duration = end - start;
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const char *name)
+{
+	ThreadSlot &slot = threadSlot();
+	if (slot.buffer == nullptr) {
+		slot.buffer = claimBuffer(name);
+	}
+	else {
+		slot.buffer->name = name;
+	}
+}
+
+bool Tracer::exportJson(QString fileName)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		qDebug() << "Tracer::exportJson can't open" << fileName;
+		return false;
+	}
+	QTextStream s(&file);
+	s << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	ThreadBuffer *buffer = m_buffers.load(std::memory_order_acquire);
+	while (buffer != nullptr) {
+		quint64 count = hasEvents(buffer) ? buffer->count.load(std::memory_order_acquire) : 0;
+		if (count > 0) {
+			QString threadName = buffer->name != nullptr ? QString(buffer->name)
+														 : QString("Thread %1").arg(buffer->tid);
+			s << (first ? "" : ",\n")
+			  << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+			  << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+			first = false;
+		}
+		quint64 firstEvent = count > QCS_TRACE_BUFFER_SIZE ? count - QCS_TRACE_BUFFER_SIZE : 0;
+		for (quint64 i = firstEvent; i < count; i++) {
+			const TraceEvent &event = buffer->events[i & (QCS_TRACE_BUFFER_SIZE - 1)];
+			// Timestamps are in microseconds
+			s << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"qcs\",\"ph\":\"X\",\"pid\":1"
+			  << ",\"tid\":" << buffer->tid
+			  << ",\"ts\":" << QString::number(event.start / 1000.0, 'f', 3)
+			  << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3) << "}";
+		}
+		buffer = buffer->next;
+	}
+	s << "\n]}\n";
+	return true;
+}
@@ -0,0 +1,119 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QElapsedTimer>
+#include <atomic>
+
+// Events kept per thread. When a buffer is full the oldest events are overwritten
+#define QCS_TRACE_BUFFER_SIZE (1 << 16)
+
+//
+// Lightweight timeline tracer. Trace points (QCS_TRACE_SCOPE) write complete
+// events into a buffer owned by the calling thread, so recording never
+// locks or contends with other threads. When not recording a trace point
+// costs a single atomic load. The buffers are read when exporting, which
+// should be done after stop().
+// The export uses the Chrome trace event format, which can be opened in
+// Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+class Tracer
+{
+public:
+	static Tracer *instance();
+
+	void start();
+	void stop();
+	bool isRunning() { return m_running.load(std::memory_order_relaxed); }
+	bool exportJson(QString fileName);
+
+	qint64 now() { return m_clock.nsecsElapsed(); }
+	void record(const char *name, qint64 start, qint64 end);
+	void setThreadName(const char *name);
+
+private:
+	Tracer();
+
+	struct TraceEvent {
+		const char *name;
+		qint64 start;
+		qint64 duration;
+	};
+
+	struct ThreadBuffer {
+		TraceEvent *events;
+		std::atomic<quint64> count;
+		// Recording the events belong to. Only the owning thread resets count,
+		// when it records the first event of a new recording
+		std::atomic<quint64> generation;
+		std::atomic<bool> inUse;  // Owned by a running thread
+		int tid;
+		const char *name;
+		ThreadBuffer *next;
+	};
+	struct ThreadSlot;
+
+	static ThreadSlot &threadSlot();
+	ThreadBuffer *threadBuffer();
+	ThreadBuffer *claimBuffer(const char *name);
+	bool hasEvents(ThreadBuffer *buffer);
+
+	std::atomic<bool> m_running;
+	std::atomic<quint64> m_generation; // Incremented by start()
+	// Lock free list. Buffers are never freed, but a buffer is reused once its
+	// thread exits, so the list only grows with the number of live threads
+	std::atomic<ThreadBuffer *> m_buffers;
+	std::atomic<int> m_threadCount;
+	QElapsedTimer m_clock;
+};
+
+class TraceScope
+{
+public:
+	TraceScope(const char *name) : m_name(name)
+	{
+		Tracer *tracer = Tracer::instance();
+		m_start = tracer->isRunning() ? tracer->now() : -1;
+	}
+	~TraceScope()
+	{
+		if (m_start >= 0) {
+			Tracer *tracer = Tracer::instance();
+			tracer->record(m_name, m_start, tracer->now());
+		}
+	}
+
+private:
+	const char *m_name;
+	qint64 m_start;
+};
+
+#define QCS_TRACE_CONCAT_(a, b) a##b
+#define QCS_TRACE_CONCAT(a, b) QCS_TRACE_CONCAT_(a, b)
+// name must be a string literal (only the pointer is stored)
+#define QCS_TRACE_SCOPE(name) TraceScope QCS_TRACE_CONCAT(qcsTraceScope, __LINE__)(name)
+#define QCS_TRACE_THREAD(name) \
+	if (Tracer::instance()->isRunning()) Tracer::instance()->setThreadName(name)
+
+#endif // TRACER_H
@@ -24,9 +24,11 @@
 #define TYPES_H
 
 #include <QMutex>
+#include <QVector>
 #include <QtGlobal>
 #include <QDebug>
 #include <csound.h>
+#include <cstring>
 
 #define QCS_VERSION "0.9.8"
 
@@ -37,9 +39,6 @@
 // Maximum undo history depth for widget panel and event sheet
 #define QCS_MAX_UNDO 256
 
-// Maximum MIDI message queue size for internal control
-#define QCS_MAX_MIDI_QUEUE 128
-
 #ifdef Q_OS_LINUX
 #define DEFAULT_HTML_DIR "/usr/share/doc/csound-doc/html"
 #define DEFAULT_TERM_EXECUTABLE "/usr/bin/xterm"
@@ -117,17 +116,20 @@ class RingBuffer
 public:
     RingBuffer() {
         // size = 8192*4;
-        size = 1024 * 4;
+        // Enough for a few GUI refreshes, so triggered scopes see every sample
+        size = 1024 * 64;
 		resize(size);
 		currentPos = 0;
 		currentReadPos = 0;
+		written = 0;
 		//       lock = false;
 	}
 	~RingBuffer() {}
 	//     bool lock;
-	QList<MYFLT> buffer;
+	QVector<MYFLT> buffer;
 	long currentPos;
 	long currentReadPos;
+	quint64 written; // Total values put, so readers can find frame boundaries
 	int size;
 	QMutex mutex;
 
@@ -156,6 +158,7 @@ public:
         // qDebug() << "RingBuffer::put currentPos " << currentPos << " value " << value;
 		buffer[currentPos] = value;
 		currentPos++;
+		written++;
         // if (currentPos == currentReadPos) {
         //     qDebug("RingBuffer: Buffer overflow!");
         // }
@@ -176,6 +179,7 @@ public:
             buffer[currentPos] = data[i];
             currentPos = (currentPos + 1) % size;
         }
+        written += dataSize;
         mutex.unlock();
     }
 
@@ -190,6 +194,7 @@ public:
             buffer[currentPos] = data[i] * scaleFactor;
             currentPos = (currentPos + 1) % size;
         }
+        written += dataSize;
         mutex.unlock();
     }
 
@@ -213,16 +218,60 @@ public:
 		return true;
 	}
 
-	void resize(int size) {
+	// Copies the last count values put, oldest first, without consuming them.
+	// Only the window is copied, so this is cheap for displays that show the
+	// latest audio. Returns false if fewer than count values have been put
+	bool copyLatest(MYFLT *data, long count) {
+		mutex.lock();
+		if (count > size || (quint64) count > written) {
+			mutex.unlock();
+			return false;
+		}
+		long start = (long) ((written - count) % size);
+		long first = qMin(count, size - start);
+		memcpy(data, buffer.constData() + start, first * sizeof(MYFLT));
+		memcpy(data + first, buffer.constData(), (count - first) * sizeof(MYFLT));
+		mutex.unlock();
+		return true;
+	}
+
+	// Copies up to count values put since position (a value of written), in
+	// whole multiples of align, and advances position. If some of them were
+	// already overwritten, position skips ahead and skipped is set
+	long copySince(quint64 &position, MYFLT *data, long count, int align, bool *skipped) {
 		mutex.lock();
-		buffer.clear();
-		for (int i = 0; i< size; i++) {
-			buffer.append(0.0);
+		*skipped = false;
+		if (position > written) {  // Restarted
+			position = written;
+			*skipped = true;
+		}
+		else if (written - position > (quint64) size) {
+			position = written - (size - size % align);
+			*skipped = true;
 		}
+		long n = (long) qMin((quint64) count, written - position);
+		n -= n % align;
+		long start = (long) (position % size);
+		long first = qMin(n, size - start);
+		memcpy(data, buffer.constData() + start, first * sizeof(MYFLT));
+		memcpy(data + first, buffer.constData(), (n - first) * sizeof(MYFLT));
+		position += n;
+		mutex.unlock();
+		return n;
+	}
+
+	void resize(int size) {
+		mutex.lock();
+		buffer.fill(0.0, size);
 		currentPos = 0;
+		written = 0;
 		mutex.unlock();
 	}
 
+	qint64 memoryUsage() {
+		return buffer.capacity() * sizeof(MYFLT);
+	}
+
 	void  allZero() {
 		mutex.lock();
 		for (int i = 0; i< buffer.size(); i++) {
@@ -230,6 +279,7 @@ public:
 		}
 		currentReadPos = 0;
 		currentPos = 0;
+		written = 0;
 		mutex.unlock();
 	}
 };
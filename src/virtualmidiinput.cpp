@@ -0,0 +1,69 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#include "virtualmidiinput.h"
+#include "qutecsound.h"
+#include "csoundengine.h"
+
+VirtualMidiInput::VirtualMidiInput(CsoundQt *qcs, QObject *parent) :
+	QObject(parent), m_qcs(qcs)
+{
+}
+
+void VirtualMidiInput::noteOn(int channel, int note, int velocity)
+{
+	send(0x90, channel, note, velocity);
+}
+
+void VirtualMidiInput::noteOff(int channel, int note)
+{
+	send(0x80, channel, note, 0);
+}
+
+void VirtualMidiInput::controlChange(int channel, int cc, int value)
+{
+	send(0xB0, channel, cc, value);
+}
+
+QString VirtualMidiInput::latencyText()
+{
+	CsoundEngine *engine = m_qcs->getEngine();
+	if (engine == nullptr || !engine->isRunning() || engine->virtualMidiLatency() <= 0) {
+		return tr("Latency: -");
+	}
+	return tr("Latency: %1 ms to Csound, %2 ms to output")
+			.arg(engine->virtualMidiLatency() / 1e6, 0, 'f', 1)
+			.arg(engine->virtualMidiOutputLatency() / 1e6, 0, 'f', 1);
+}
+
+void VirtualMidiInput::send(int status, int channel, int data1, int data2)
+{
+	CsoundEngine *engine = m_qcs->getEngine();
+	if (engine == nullptr) {
+		return;
+	}
+	unsigned char message[3];
+	message[0] = status | ((channel - 1) & 0x0F);
+	message[1] = data1 & 0x7F;
+	message[2] = data2 & 0x7F;
+	engine->queueVirtualMidiIn(message, 3);
+}
@@ -0,0 +1,52 @@
+/*
+	Copyright (C) 2026 CsoundQt contributors
+
+	This file is part of CsoundQt.
+
+	CsoundQt is free software; you can redistribute it
+	and/or modify it under the terms of the GNU Lesser General Public
+	License as published by the Free Software Foundation; either
+	version 2.1 of the License, or (at your option) any later version.
+
+	CsoundQt is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU Lesser General Public License for more details.
+
+	You should have received a copy of the GNU Lesser General Public
+	License along with Csound; if not, write to the Free Software
+	Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+	02111-1307 USA
+*/
+
+
+#ifndef VIRTUALMIDIINPUT_H
+#define VIRTUALMIDIINPUT_H
+
+#include <QObject>
+
+class CsoundQt;
+
+// Lets the QML virtual keyboard send straight to the current document's
+// engine, instead of through queued signals and QVariants. Messages go into
+// the engine's virtual MIDI queue, which Csound reads without locking on its
+// next k-cycle.
+class VirtualMidiInput : public QObject
+{
+	Q_OBJECT
+public:
+	VirtualMidiInput(CsoundQt *qcs, QObject *parent = 0);
+
+	Q_INVOKABLE void noteOn(int channel, int note, int velocity);
+	Q_INVOKABLE void noteOff(int channel, int note);
+	Q_INVOKABLE void controlChange(int channel, int cc, int value);
+	// Measured for the last message: until Csound read it, and until its audio is heard
+	Q_INVOKABLE QString latencyText();
+
+private:
+	void send(int status, int channel, int data1, int data2);
+
+	CsoundQt *m_qcs;
+};
+
+#endif // VIRTUALMIDIINPUT_H
@@ -37,8 +37,11 @@
 #include "quteconsole.h"
 #include "qutegraph.h"
 #include "qutescope.h"
+#include "qutespectrum.h"
+#include "qutespectrogram.h"
 #include "qutedummy.h"
 #include "framewidget.h"
+#include "tracer.h"
 
 #include "qutecsound.h" // For passing the actions from button reserved channels
 
@@ -62,15 +65,14 @@ WidgetLayout::WidgetLayout(QWidget* parent) : QWidget(parent)
 	mouseRelX = mouseRelY = 0;
 	m_contained = false;
 
-	midiWriteCounter = 0;
-	midiReadCounter = 0;
-	midiQueue.resize(QCS_MAX_MIDI_QUEUE);
-	for (int i = 0; i <QCS_MAX_MIDI_QUEUE; i++ ) {
-		midiQueue[i].resize(3);
-	}
-
-	curveUpdateBuffer.resize(QCS_CURVE_BUFFER_SIZE);
-	curveUpdateBufferCount = 0;
+	m_midiQueue = 0;
+	m_hostInput = 0;
+	m_midiPending = 0;
+	m_midiDispatch.resize(16 * 128);
+	m_midiDispatchDirty = false;
+	memset(m_midiMsb, 0, sizeof(m_midiMsb));
+	newGraphBuffers.store(nullptr, std::memory_order_relaxed);
+	memset(m_midiMsbSeen, 0, sizeof(m_midiMsbSeen));
 
     createSliderAct = new QAction(tr("Slider"),this);
 	connect(createSliderAct, SIGNAL(triggered()), this, SLOT(createNewSlider()));
@@ -107,6 +109,12 @@ WidgetLayout::WidgetLayout(QWidget* parent) : QWidget(parent)
     createTableDisplayAct = new QAction(tr("Table Plot"), this);
     connect(createTableDisplayAct, SIGNAL(triggered()), this, SLOT(createNewTableDisplay()));
 
+	createSpectrumAct = new QAction(tr("Spectrum Analyzer"), this);
+	connect(createSpectrumAct, SIGNAL(triggered()), this, SLOT(createNewSpectrum()));
+
+	createSpectrogramAct = new QAction(tr("Spectrogram"), this);
+	connect(createSpectrogramAct, SIGNAL(triggered()), this, SLOT(createNewSpectrogram()));
+
 	propertiesAct = new QAction(tr("Properties"),this);
 	connect(propertiesAct, SIGNAL(triggered()), this, SLOT(propertiesDialog()));
 
@@ -191,6 +199,8 @@ WidgetLayout::WidgetLayout(QWidget* parent) : QWidget(parent)
     m_widgetNameToType["BSBScope"] = QuteWidgetType::SCOPE;
     m_widgetNameToType["BSBConsole"] = QuteWidgetType::CONSOLE;
     m_widgetNameToType["BSBTableDisplay"] = QuteWidgetType::TABLEDISPLAY;
+	m_widgetNameToType["BSBSpectrum"] = QuteWidgetType::SPECTRUM;
+	m_widgetNameToType["BSBSpectrogram"] = QuteWidgetType::SPECTROGRAM;
 }
 
 WidgetLayout::~WidgetLayout()
@@ -602,21 +612,6 @@ double WidgetLayout::getValueForChannel(QString channelName, bool *modified)
 	return 0.0;
 }
 
-void WidgetLayout::getMouseValues(QVector<double> *values)
-{
-	// values must have size of 6 for _MouseX _MouseY _MouseRelX _MouseRelY MouseBut1 and MouseBut2
-	if (this->isEnabled()) {
-		mouseLock.lockForRead();
-		(*values)[0] = getMouseX();
-		(*values)[1] = getMouseY();
-		(*values)[2] = getMouseRelX();
-		(*values)[3] = getMouseRelY();
-		(*values)[4] = getMouseBut1();
-		(*values)[5] = getMouseBut2();
-		mouseLock.unlock();
-	}
-}
-
 int WidgetLayout::getMouseX()
 {
     Q_ASSERT(mouseX >= 0 && mouseX < 4096);
@@ -761,8 +756,8 @@ int WidgetLayout::newXmlWidget(QDomNode mainnode, bool offset, bool newId)
 		widget = static_cast<QuteWidget *>(w);
         connect(widget, SIGNAL(newValue(QPair<QString,double>)),
                 this, SLOT(newValue(QPair<QString,double>)));
-        connect(w, SIGNAL(requestUpdateCurve(Curve*)),
-                this, SLOT(processUpdateCurve(Curve*)));
+        connect(w, SIGNAL(showingCurve(QuteGraph*,Curve*)),
+                this, SLOT(graphShowingCurve(QuteGraph*,Curve*)));
 
 		for (int i = 0; i < curves.size(); i++) {
 			w->addCurve(curves[i]);
@@ -785,8 +780,21 @@ int WidgetLayout::newXmlWidget(QDomNode mainnode, bool offset, bool newId)
     else if (type == "BSBTableDisplay") {
         auto w = new QuteTable(this);
         widget = static_cast<QuteWidget *>(w);
+        tableWidgets.append(w);
         emit requestCsoundUserData(w);
 	}
+	else if (type == "BSBSpectrum") {
+		QuteSpectrum *w = new QuteSpectrum(this);
+		widget = static_cast<QuteWidget *>(w);
+		spectrumWidgets.append(w);
+		emit requestCsoundUserData(w);
+	}
+	else if (type == "BSBSpectrogram") {
+		QuteSpectrogram *w = new QuteSpectrogram(this);
+		widget = static_cast<QuteWidget *>(w);
+		spectrogramWidgets.append(w);
+		emit requestCsoundUserData(w);
+	}
 	else {
 		qDebug() << type << " not implemented";
 		//    QuteDummy *w = new QuteDummy(this);
@@ -855,6 +863,11 @@ int WidgetLayout::newXmlWidget(QDomNode mainnode, bool offset, bool newId)
 			widget->setProperty(nodeName.toLocal8Bit(), n.nodeValue().toInt());
 			registerWidgetController(widget, n.nodeValue().toInt());
 		}
+		else if (nodeName == "smoothing") {
+			QDomNode n = node.firstChild();
+			widget->setProperty("QCS_smoothing", ControlSmoother::modeFromName(node.attribute("mode")));
+			widget->setProperty("QCS_smoothtime", n.nodeValue().toDouble());
+		}
 		else if (nodeName == "randomizable" || nodeName == "selected"
 				 || nodeName == "visible" ) {  // BOOL type
 			QDomNode n = node.firstChild();
@@ -1047,6 +1060,26 @@ void WidgetLayout::engineStopped()
 	flushGraphBuffer();
 }
 
+void WidgetLayout::startAnalysis()
+{
+	for (int i = 0; i < spectrumWidgets.size(); i++) {
+		spectrumWidgets[i]->startAnalysis();
+	}
+	for (int i = 0; i < spectrogramWidgets.size(); i++) {
+		spectrogramWidgets[i]->startAnalysis();
+	}
+}
+
+void WidgetLayout::stopAnalysis()
+{
+	for (int i = 0; i < spectrumWidgets.size(); i++) {
+		spectrumWidgets[i]->stopAnalysis();
+	}
+	for (int i = 0; i < spectrogramWidgets.size(); i++) {
+		spectrogramWidgets[i]->stopAnalysis();
+	}
+}
+
 void WidgetLayout::showWidgetTooltips(bool show)
 {
 	m_tooltips = show;
@@ -1154,28 +1187,32 @@ void WidgetLayout::setWidgetsLocked(bool lock)
 
 void WidgetLayout::appendCurve(WINDAT *windat)
 {
-	// Called from the Csound callback, creates a curve and queues it for processing
-    // Csound itself deletes the WINDAT structures, that's why we retain a copy of
-    // the data for when Csound stops
+	// Called from the Csound callback, creates a curve and the buffer that
+	// carries its frames to the GUI, and queues them for processing without
+	// waiting for the GUI, which holds layoutMutex while drawing.
+	// Csound itself deletes the WINDAT structures, that's why we retain a copy of
+	// the data for when Csound stops
 	// It would be nice if Csound used a single windat for every f-table, but it reuses them...
-    //  for (int i = 0; i < curves.size(); i++) {
-    //    // Check if windat is already handled by one of the existing curves
-	//    if (windat == curves[i]->getOriginal()) {
-	//      return;
-	//    }
-	//  }
-    for (int i = 0; i < curves.size(); i++) {
-        // Check if caption is already present to replace curve rather than create a new one.
-        if (curves[i]->get_caption() == windat->caption) {
-            windat->windid = (uintptr_t) curves[i];
-            return;
-        }
-    }
-	if (curves.size() > QCS_CURVE_BUFFER_MAX) {
+	windat->caption[CAPSIZE - 1] = 0; // Just in case...
+	// Check if caption is already present to replace curve rather than create a new one.
+	QString caption(windat->caption);
+	GraphBuffer *existing = graphBuffersByCaption.value(caption, nullptr);
+	if (existing != nullptr) {
+		if (existing->capacity() < windat->npts) {
+			// Larger than before, only happens when a run defines a table again with a new size
+			existing = new GraphBuffer(existing->curve(), windat->npts);
+			graphBuffersByCaption.insert(caption, existing);
+			curvesById.insert((uintptr_t) existing, existing->curve());
+			pushGraphBuffer(existing, false);
+		}
+		windat->windid = (uintptr_t) existing;
+		return;
+	}
+	if (graphBuffersByCaption.size() > QCS_CURVE_BUFFER_MAX) {
+		windat->windid = 0;
 		qDebug() << "WidgetLayout::appendCurve curve size exceeded. Curve discarded!";
 		return;
 	}
-	windat->caption[CAPSIZE - 1] = 0; // Just in case...
 	Polarity polarity;
 	switch (windat->polarity) {
 	case NEGPOL:
@@ -1190,33 +1227,30 @@ void WidgetLayout::appendCurve(WINDAT *windat)
 	default:
 		polarity = POLARITY_NOPOL;
 	}
-	int indexInBuffer = -1;
-	//This is not working... makes fft graphs ge ignored...
-	//  for (int i = 0; i < newCurveBuffer.size(); i++) {
-	//    if (strcmp(newCurveBuffer[i]->getOriginal()->caption,windat->caption) && strlen(newCurveBuffer[i]->getOriginal()->caption) > 0) {
-	//      indexInBuffer = i;
-	//      break;
-	//    }
-	//  }
-	if (indexInBuffer < 0) {
-        auto curve = new Curve(windat->fdata,
-                               (size_t)windat->npts,
-                               windat->caption,
-                               polarity,
-                               windat->max,
-                               windat->min,
-                               windat->absmax,
-                               windat->oabsmax,
-                               windat->danflag,
-                               windat);  //FIXME delete these when starting a new run
-		windat->windid = (uintptr_t) curve;
-		newCurveBuffer.append(curve);
-        // qDebug() << "WidgetLayout::appendCurve " << curve << "__--__" << windat;
-	}
-	else {
-        qDebug() << "WidgetLayout::appendCurve reusing curve buffer " << indexInBuffer;
-		newCurveBuffer[indexInBuffer]->set_data(windat->fdata);
-		newCurveBuffer[indexInBuffer]->setOriginal(windat);
+	auto curve = new Curve(windat->fdata,
+						   (size_t)windat->npts,
+						   windat->caption,
+						   polarity,
+						   windat->max,
+						   windat->min,
+						   windat->absmax,
+						   windat->oabsmax,
+						   windat->danflag,
+						   windat);  //FIXME delete these when starting a new run
+	GraphBuffer *buffer = new GraphBuffer(curve, windat->npts);
+	windat->windid = (uintptr_t) buffer;
+	graphBuffersByCaption.insert(caption, buffer);
+	curvesById.insert(windat->windid, curve);
+	pushGraphBuffer(buffer, true);
+}
+
+void WidgetLayout::pushGraphBuffer(GraphBuffer *buffer, bool newCurve)
+{
+	buffer->firstOfCurve = newCurve;
+	buffer->nextPending = newGraphBuffers.load(std::memory_order_relaxed);
+	while (!newGraphBuffers.compare_exchange_weak(buffer->nextPending, buffer,
+												  std::memory_order_release,
+												  std::memory_order_relaxed)) {
 	}
 }
 
@@ -1224,7 +1258,9 @@ void WidgetLayout::killCurve(WINDAT *windat)
 {
 	qDebug() << "WidgetLayout::killCurve()";
 	Curve *curve = (Curve *) getCurveById(windat->windid);
-    curve->setOriginal(nullptr);
+	if (curve != nullptr) {
+		curve->setOriginal(nullptr);
+	}
 }
 
 void WidgetLayout::newCurve(Curve* curve)
@@ -1246,8 +1282,27 @@ void WidgetLayout::newCurve(Curve* curve)
 void WidgetLayout::setCurveData(Curve *curve)
 {
 	//  qDebug() << "WidgetPanel::setCurveData" <<curve;
-	for (int i = 0; i < graphWidgets.size(); i++) {
-		graphWidgets[i]->setCurveData(curve);
+	foreach (QuteGraph *graph, curveSubscribers.value(curve)) {
+		graph->setCurveData(curve);
+	}
+}
+
+void WidgetLayout::graphShowingCurve(QuteGraph *graph, Curve *curve)
+{
+	Curve *previous = graphSubscriptions.value(graph, nullptr);
+	if (previous != nullptr) {
+		QList<QuteGraph *> &subscribers = curveSubscribers[previous];
+		subscribers.removeOne(graph);
+		if (subscribers.isEmpty()) {
+			curveSubscribers.remove(previous);
+		}
+	}
+	if (curve != nullptr) {
+		curveSubscribers[curve].append(graph);
+		graphSubscriptions.insert(graph, curve);
+	}
+	else {
+		graphSubscriptions.remove(graph);
 	}
 }
 
@@ -1256,32 +1311,23 @@ void WidgetLayout::setCurveData(Curve *curve)
 //  m_clipboard = text;
 //}
 
+// id is the window id given to Csound (windat->windid). Only for the
+// performance thread while running
 uintptr_t WidgetLayout::getCurveById(uintptr_t id)
 {
-	//  qDebug() << "WidgetLayout::getCurveById ";
-	foreach (Curve *thisCurve, curves) {
-        // qDebug() << "WidgetLayout::getCurveById " << (uintptr_t)thisCurve << "id" << id;
-		if ((uintptr_t) thisCurve == id)
-			return (uintptr_t) thisCurve;
-	}
-	return 0;
+	return (uintptr_t) curvesById.value(id, nullptr);
 }
 
 void WidgetLayout::updateCurve(WINDAT *windat)
 {
-	//  qDebug() << "WidgetLayout::updateCurve(WINDAT *windat) " << windat->windid;
-	if (curveUpdateBufferCount+1 < QCS_CURVE_BUFFER_SIZE) {
-		curveUpdateBufferCount++;
-		curveUpdateBuffer[curveUpdateBufferCount] = *windat;
+	// Called from the performance thread, only copies the frame. Frames not
+	// drawn yet are replaced by newer ones
+	GraphBuffer *buffer = (GraphBuffer *) windat->windid;
+	if (buffer != nullptr) {
+		buffer->write(windat);
 	}
 }
 
-void WidgetLayout::processUpdateCurve(Curve *curve) {
-    WINDAT *orig = curve->getOriginal();
-    qDebug() << "processUpdateCurve" << orig->npts << orig->caption;
-    this->updateCurve(orig);
-}
-
 
 int WidgetLayout::killCurves(CSOUND * /*csound*/)
 {
@@ -1315,44 +1361,67 @@ void WidgetLayout::clearGraphs()
 	for (int i = 0; i < graphWidgets.size(); i++) {
 		graphWidgets[i]->clearCurves();
 	}
+	layoutMutex.lock();
 	while (curves.size() > 0) {
 		Curve * c = curves.takeFirst();
 		delete c;
 	}
+	qDeleteAll(graphBuffers);
+	graphBuffers.clear();
+	GraphBuffer *pending = newGraphBuffers.exchange(nullptr, std::memory_order_acquire);
+	while (pending != nullptr) {
+		GraphBuffer *next = pending->nextPending;
+		if (pending->firstOfCurve) {
+			delete pending->curve();
+		}
+		delete pending;
+		pending = next;
+	}
+	graphBuffersByCaption.clear();
+	curvesById.clear();
+	curveSubscribers.clear();
+	graphSubscriptions.clear();
+	layoutMutex.unlock();
 	//  qDebug() << "WidgetLayout::clearGraphs() done";
 }
 
+qint64 WidgetLayout::curvesMemoryUsage()
+{
+	qint64 bytes = 0;
+	layoutMutex.lock();
+	foreach (Curve *curve, curves) {
+		bytes += sizeof(Curve) + curve->get_size() * sizeof(MYFLT);
+	}
+	foreach (GraphBuffer *buffer, graphBuffers) {
+		bytes += buffer->memoryUsage();
+	}
+	// Only the GUI removes buffers from the stack, so it can be walked here
+	GraphBuffer *pending = newGraphBuffers.load(std::memory_order_acquire);
+	for (; pending != nullptr; pending = pending->nextPending) {
+		if (pending->firstOfCurve) {
+			bytes += sizeof(Curve) + pending->curve()->get_size() * sizeof(MYFLT);
+		}
+		bytes += pending->memoryUsage();
+	}
+	layoutMutex.unlock();
+	return bytes;
+}
+
+// Drops the frames not drawn yet. Curves waiting to be registered are kept,
+// as Csound may still be writing to their buffers
 void WidgetLayout::flushGraphBuffer()
 {
 	layoutMutex.lock();
-	while (newCurveBuffer.size() > 0) {
-		Curve * c = newCurveBuffer.takeFirst();
-		delete c;
+	foreach (GraphBuffer *buffer, graphBuffers) {
+		buffer->read();
 	}
-	curveUpdateBufferCount = 0;
 	layoutMutex.unlock();
 }
 
 void WidgetLayout::refreshWidgets()
 {
-    while (midiReadCounter != midiWriteCounter) {
-        // TODO it is inefficient to have this per layout (when more than one
-        // layout is available)
-		int index =midiReadCounter;
-		int status = midiQueue[index][0];
-		if (status & 176) { // MIDI control change
-			int channel = (status ^ 176) + 1;
-			for (int i = 0; i < registeredControllers.size(); i++) {
-				if (registeredControllers[i].cc == midiQueue[index][1]) {
-					if (/*registeredControllers[i].chan == 0 || */ channel == registeredControllers[i].chan) { // not sure if this comment-out will not break anything but likely not. tarmo.
-						registeredControllers[i].widget->setMidiValue(midiQueue[index][2]);
-					}
-				}
-			}
-		}
-		midiReadCounter++;
-		midiReadCounter = midiReadCounter%QCS_MAX_MIDI_QUEUE;
-	}
+	QCS_TRACE_SCOPE("refreshWidgets");
+	processMidiQueue(); // In case a posted call is still pending
 	widgetsMutex.lock();
 	for (int i=0; i < m_widgets.size(); i++) {
 		if (m_widgets[i]->m_valueChanged || m_widgets[i]->m_value2Changed) {
@@ -1544,6 +1613,8 @@ void WidgetLayout::addCreateWidgetActionsToMenu(QMenu &menu) {
     menu.addAction(createGraphAct);
     menu.addAction(createScopeAct);
     menu.addAction(createTableDisplayAct);
+	menu.addAction(createSpectrumAct);
+	menu.addAction(createSpectrogramAct);
 }
 
 void WidgetLayout::createContextMenu(QContextMenuEvent *event)
@@ -2025,6 +2096,50 @@ QString WidgetLayout::createNewTableDisplay(int x, int y, QString channel)
     return uuid;
 }
 
+QString WidgetLayout::createNewSpectrum(int x, int y, QString channel)
+{
+	QString uuid;
+	bool dialog;
+	int posx = x >= 0 ? x : currentPosition.x();
+	int posy = y >= 0 ? y : currentPosition.y();
+	deselectAll();
+	if (channel.isEmpty()) {
+		channel = "spectrum" + QString::number(m_widgets.size());
+		dialog = true;
+	} else {
+		dialog = false;
+	}
+	uuid = createSpectrum(posx, posy, 350, 150, channel);
+	widgetChanged();
+	if (dialog && getOpenProperties()) {
+		m_widgets.last()->openProperties();
+	}
+	markHistory();
+	return uuid;
+}
+
+QString WidgetLayout::createNewSpectrogram(int x, int y, QString channel)
+{
+	QString uuid;
+	bool dialog;
+	int posx = x >= 0 ? x : currentPosition.x();
+	int posy = y >= 0 ? y : currentPosition.y();
+	deselectAll();
+	if (channel.isEmpty()) {
+		channel = "spectrogram" + QString::number(m_widgets.size());
+		dialog = true;
+	} else {
+		dialog = false;
+	}
+	uuid = createSpectrogram(posx, posy, 400, 200, channel);
+	widgetChanged();
+	if (dialog && getOpenProperties()) {
+		m_widgets.last()->openProperties();
+	}
+	markHistory();
+	return uuid;
+}
+
 QString WidgetLayout::createNewScope(int x, int y, QString channel)
 {
 	QString uuid;
@@ -2069,7 +2184,13 @@ void WidgetLayout::clearWidgetLayout()
 	editWidgets.clear();
 	consoleWidgets.clear();
 	graphWidgets.clear();
+	curveSubscribers.clear();
+	graphSubscriptions.clear();
 	scopeWidgets.clear();
+	spectrumWidgets.clear();
+	spectrogramWidgets.clear();
+	tableWidgets.clear();
+	clearWidgetControllers();
 	widgetsMutex.unlock();
 }
 
@@ -2171,6 +2292,7 @@ void WidgetLayout::applyProperties()
     setBackground(bgCheckBox->isChecked(), color);
 	widgetChanged();
 	mouseBut2 = 0;  // Button un clicked is not propagated after opening the edit dialog. Do it artificially here
+	publishMouse(QApplication::keyboardModifiers());
 }
 
 void WidgetLayout::selectBgColor()
@@ -2503,6 +2625,9 @@ void WidgetLayout::alignCenterHorizontal()
 void WidgetLayout::keyPressEvent(QKeyEvent *event)
 {
     int key = event->key();
+    if (m_hostInput != 0) {
+        m_hostInput->setModifiers(hostModifiers(event->modifiers()));
+    }
     if(m_editMode) {
         switch(key) {
         case Qt::Key_Left:
@@ -2599,6 +2724,9 @@ void WidgetLayout::keyPressEvent(QKeyEvent *event)
 
 void WidgetLayout::keyReleaseEvent(QKeyEvent *event)
 {
+	if (m_hostInput != 0) {
+		m_hostInput->setModifiers(hostModifiers(event->modifiers()));
+	}
     if (!event->isAutoRepeat() || m_repeatKeys) {
 		QString keyText = event->text();
 		int key = -1;
@@ -2627,10 +2755,15 @@ void WidgetLayout::widgetChanged(QuteWidget* widget)
 		}
 		setWidgetToolTip(widget, m_tooltips);
 		//    widgetsMutex.unlock();
-		int cc = widget->property("QCS_midicc").toInt();  // Is it safe to query these here?
-		int chan = widget->property("QCS_midichan").toInt();
-		registerWidgetController(widget, cc);
-		registerWidgetChannel(widget, chan);
+		if (index >= 0) {
+			int cc = widget->property("QCS_midicc").toInt();  // Is it safe to query these here?
+			int chan = widget->property("QCS_midichan").toInt();
+			registerWidgetController(widget, cc);
+			registerWidgetChannel(widget, chan);
+		}
+		else { // Widget has been deleted
+			unregisterWidgetController(widget);
+		}
 		setModified(true);
 	}
 	adjustLayoutSize();
@@ -2649,12 +2782,11 @@ void WidgetLayout::mousePressEvent(QMouseEvent *event)
 			deselectAll();
 		}
 	}
-    mouseLock.lockForWrite();
 	if (event->button() == Qt::LeftButton)
 		mouseBut1 = 1;
 	else if (event->button() == Qt::RightButton)
 		mouseBut2 = 1;
-	mouseLock.unlock();
+	publishMouse(event->modifiers());
 	//  QWidget::mousePressEvent(event);
 }
 
@@ -2677,12 +2809,11 @@ void WidgetLayout::mouseMoveEvent(QMouseEvent *event)
 		selectionChanged(QRect(x - xOffset, y - yOffset, width, height));
 	}
 	//  qDebug() << "WidgetPanel::mouseMoveEvent " << event->y();
-	mouseLock.lockForWrite();
 	mouseX = event->globalX();
 	mouseY = event->globalY();
 	mouseRelX = event->x() + xOffset;
 	mouseRelY = event->y() + yOffset;
-	mouseLock.unlock();
+	publishMouse(event->modifiers());
 }
 
 void WidgetLayout::mouseReleaseEvent(QMouseEvent *event)
@@ -2691,14 +2822,13 @@ void WidgetLayout::mouseReleaseEvent(QMouseEvent *event)
 		selectionFrame->hide();
 	}
 	//  qDebug() << "WidgetPanel::mouseMoveEvent " << event->x();
-	mouseLock.lockForWrite();
 	if (event->button() == Qt::LeftButton)
 		mouseBut1 = 0;
 	else if (event->button() == Qt::RightButton) {
 		emit deselectAll();
 		mouseBut2 = 0;
 	}
-	mouseLock.unlock();
+	publishMouse(event->modifiers());
 	markHistory();
 	//  QWidget::mouseReleaseEvent(event);
 }
@@ -3167,6 +3297,8 @@ QString WidgetLayout::createGraph(int x, int y, int width, int height, QString w
 		channelName.chop(1);  //remove last space
 		widget->setProperty("QCS_objectName", channelName);
 	}
+	connect(widget, SIGNAL(showingCurve(QuteGraph*,Curve*)),
+			this, SLOT(graphShowingCurve(QuteGraph*,Curve*)));
 	for (int i = 0; i < curves.size(); i++) {
 		widget->addCurve(curves[i]);
 	}
@@ -3247,12 +3379,43 @@ QString WidgetLayout::createTableDisplay(int x, int y, int width, int height, QS
     widget->setProperty("QCS_height", height);
     widget->setProperty("QCS_tableNumber", 0);
 
+    tableWidgets.append(widget);
     emit requestCsoundUserData(widget);
     registerWidget(widget);
     widget->applyInternalProperties();
     return widget->getUuid();
 }
 
+QString WidgetLayout::createSpectrum(int x, int y, int width, int height, QString channel)
+{
+	QuteSpectrum *widget = new QuteSpectrum(this);
+	widget->setProperty("QCS_x", x);
+	widget->setProperty("QCS_y", y);
+	widget->setProperty("QCS_width", width);
+	widget->setProperty("QCS_height", height);
+	widget->setProperty("QCS_objectName", channel);
+	emit requestCsoundUserData(widget);
+	spectrumWidgets.append(widget);
+	registerWidget(widget);
+	widget->applyInternalProperties();
+	return widget->getUuid();
+}
+
+QString WidgetLayout::createSpectrogram(int x, int y, int width, int height, QString channel)
+{
+	QuteSpectrogram *widget = new QuteSpectrogram(this);
+	widget->setProperty("QCS_x", x);
+	widget->setProperty("QCS_y", y);
+	widget->setProperty("QCS_width", width);
+	widget->setProperty("QCS_height", height);
+	widget->setProperty("QCS_objectName", channel);
+	emit requestCsoundUserData(widget);
+	spectrogramWidgets.append(widget);
+	registerWidget(widget);
+	widget->applyInternalProperties();
+	return widget->getUuid();
+}
+
 void WidgetLayout::setBackground(bool bg, QColor bgColor)
 {
 	//qDebug() << "WidgetLayout::setBackground " << bg << "--" << bgColor;
@@ -3296,10 +3459,12 @@ void WidgetLayout::registerWidgetController(QuteWidget *widget, int cc)
 	for (int i = 0; i < registeredControllers.size(); i++) {
 		if (registeredControllers[i].widget == widget) {
 			registeredControllers[i].cc = cc;
+			m_midiDispatchDirty = true;
 			return;
 		}
 	}
 	registeredControllers << RegisteredController(widget, 0, cc); // right orfer of parameters: RegisteredController(QuteWidget * _widget, int _chan,int  _cc)
+	m_midiDispatchDirty = true;
 }
 
 void WidgetLayout::registerWidgetChannel(QuteWidget *widget, int chan)
@@ -3310,10 +3475,12 @@ void WidgetLayout::registerWidgetChannel(QuteWidget *widget, int chan)
 	for (int i = 0; i < registeredControllers.size(); i++) {
 		if (registeredControllers[i].widget == widget) {
 			registeredControllers[i].chan = chan;
+			m_midiDispatchDirty = true;
 			return;
 		}
 	}
 	registeredControllers << RegisteredController(widget, chan, 1); // correct order of parameters: RegisteredController(QuteWidget * _widget, int _chan,int  _cc)
+	m_midiDispatchDirty = true;
 }
 
 void WidgetLayout::unregisterWidgetController(QuteWidget *widget)
@@ -3321,6 +3488,7 @@ void WidgetLayout::unregisterWidgetController(QuteWidget *widget)
 	for (int i = 0; i < registeredControllers.size(); i++) {
 		if (registeredControllers[i].widget == widget) {
 			registeredControllers.removeAt(i);
+			m_midiDispatchDirty = true;
 			return;
 		}
 	}
@@ -3329,6 +3497,115 @@ void WidgetLayout::unregisterWidgetController(QuteWidget *widget)
 void WidgetLayout::clearWidgetControllers()
 {
 	registeredControllers.clear();
+	m_midiDispatchDirty = true;
+}
+
+// One list of widgets per channel and controller, so incoming control
+// changes don't need to search registeredControllers
+void WidgetLayout::rebuildMidiDispatch()
+{
+	for (int i = 0; i < m_midiDispatch.size(); i++) {
+		m_midiDispatch[i].clear();
+	}
+	for (int i = 0; i < registeredControllers.size(); i++) {
+		const RegisteredController &controller = registeredControllers[i];
+		// Channel 0 means no MIDI control
+		if (controller.chan >= 1 && controller.chan <= 16
+				&& controller.cc >= 0 && controller.cc < 128) {
+			m_midiDispatch[(controller.chan - 1) * 128 + controller.cc] << controller.widget;
+		}
+	}
+	m_midiDispatchDirty = false;
+}
+
+void WidgetLayout::setMidiQueue(MidiQueue *queue)
+{
+	m_midiQueue = queue;
+	m_midiReader = queue->reader();
+}
+
+void WidgetLayout::setHostInput(HostInput *input)
+{
+	m_hostInput = input;
+	publishMouse(QApplication::keyboardModifiers());
+}
+
+int WidgetLayout::hostModifiers(Qt::KeyboardModifiers modifiers)
+{
+	int mask = 0;
+	if (modifiers & Qt::ShiftModifier) {
+		mask |= HostInput::ShiftModifier;
+	}
+	if (modifiers & Qt::ControlModifier) {
+		mask |= HostInput::ControlModifier;
+	}
+	if (modifiers & Qt::AltModifier) {
+		mask |= HostInput::AltModifier;
+	}
+	if (modifiers & Qt::MetaModifier) {
+		mask |= HostInput::MetaModifier;
+	}
+	return mask;
+}
+
+void WidgetLayout::publishMouse(Qt::KeyboardModifiers modifiers)
+{
+	// The engine reads these directly on the performance thread
+	if (m_hostInput == 0 || !this->isEnabled()) {
+		return;
+	}
+	m_hostInput->setPosition(getMouseX(), getMouseY(), getMouseRelX(), getMouseRelY());
+	m_hostInput->setButton(HostInput::LeftButton, mouseBut1 != 0);
+	m_hostInput->setButton(HostInput::RightButton, mouseBut2 != 0);
+	m_hostInput->setModifiers(hostModifiers(modifiers));
+}
+
+void WidgetLayout::midiQueued()
+{
+	// Only one call is posted however many messages arrive before it runs
+	if (m_midiPending.testAndSetOrdered(0, 1)) {
+		QMetaObject::invokeMethod(this, "processMidiQueue", Qt::QueuedConnection);
+	}
+}
+
+void WidgetLayout::processMidiQueue()
+{
+	m_midiPending.fetchAndStoreOrdered(0);
+	if (m_midiQueue == 0) {
+		return;
+	}
+	if (m_midiDispatchDirty) {
+		rebuildMidiDispatch();
+	}
+	MidiEvent event;
+	while (m_midiQueue->read(m_midiReader, event)) {
+		if ((event.data[0] & 0xF0) != 0xB0 || event.size != 3) { // MIDI control change
+			continue;
+		}
+		int channel = event.data[0] & 0x0F;
+		int cc = event.data[1] & 0x7F;
+		int value = event.data[2] & 0x7F;
+		const QVector<QuteWidget *> &widgets = m_midiDispatch[channel * 128 + cc];
+		if (cc < 32) {
+			// MSB of a 14-bit pair. Repeating the value in the low bits maps
+			// 0-127 to the full 14-bit range for controllers that send no LSB
+			m_midiMsb[channel][cc] = value;
+			m_midiMsbSeen[channel][cc] = true;
+			for (int i = 0; i < widgets.size(); i++) {
+				widgets[i]->setMidiValue14((value << 7) | value);
+			}
+			continue;
+		}
+		for (int i = 0; i < widgets.size(); i++) {
+			widgets[i]->setMidiValue(value);
+		}
+		if (cc < 64 && m_midiMsbSeen[channel][cc - 32]) { // LSB of controller cc - 32
+			const QVector<QuteWidget *> &coarse = m_midiDispatch[channel * 128 + cc - 32];
+			for (int i = 0; i < coarse.size(); i++) {
+				coarse[i]->setMidiValue14((m_midiMsb[channel][cc - 32] << 7) | value);
+			}
+		}
+	}
 }
 
 void WidgetLayout::setModified(bool mod)
@@ -3352,6 +3629,27 @@ void WidgetLayout::clearHistory()
 	m_historyIndex = 0;
 }
 
+void WidgetLayout::trimHistory()
+{
+	if (m_history.isEmpty()) {
+		return;
+	}
+	QString current = m_history[qBound(0, m_historyIndex, m_history.size() - 1)];
+	m_history.clear();
+	m_history << current;
+	m_history.squeeze();
+	m_historyIndex = 0;
+}
+
+qint64 WidgetLayout::historyMemoryUsage()
+{
+	qint64 bytes = m_history.capacity() * sizeof(QString);
+	foreach (const QString &text, m_history) {
+		bytes += text.capacity() * sizeof(QChar);
+	}
+	return bytes;
+}
+
 int WidgetLayout::getPresetIndex(int number)
 {
 	int index = -1;
@@ -3853,11 +4151,22 @@ void WidgetLayout::deleteWidget(QuteWidget *widget)
 		consoleWidgets.remove(index);
 	}
 	index = graphWidgets.indexOf(dynamic_cast<QuteGraph *>(widget));
-	if (index >= 0)
+	if (index >= 0) {
+		graphShowingCurve(graphWidgets[index], nullptr);
 		graphWidgets.remove(index);
+	}
 	index = scopeWidgets.indexOf(dynamic_cast<QuteScope *>(widget));
 	if (index >= 0)
 		scopeWidgets.remove(index);
+	index = spectrumWidgets.indexOf(dynamic_cast<QuteSpectrum *>(widget));
+	if (index >= 0)
+		spectrumWidgets.remove(index);
+	index = spectrogramWidgets.indexOf(dynamic_cast<QuteSpectrogram *>(widget));
+	if (index >= 0)
+		spectrogramWidgets.remove(index);
+	index = tableWidgets.indexOf(dynamic_cast<QuteTable *>(widget));
+	if (index >= 0)
+		tableWidgets.remove(index);
 	m_activeWidgets = m_widgets.size();  // Allow all widgets again
 	widgetsMutex.unlock();
 	widgetChanged(widget);
@@ -4123,43 +4432,66 @@ void WidgetLayout::updateData()
 		return;
 	}
 
-	refreshWidgets();
     int const refresh_rate = m_updateRate;
 	int const msec = 1000 / refresh_rate;
-	if (!layoutMutex.tryLock(1)) {
+	if (!updateFrame()) {
 		updateTimer.singleShot(msec, this, SLOT(updateData()));
 		return;
 	}
-	while (!newCurveBuffer.isEmpty()) {
-		Curve * curve = newCurveBuffer.takeFirst();
-        newCurve(curve);  // Register new curve
-    }
-	// Check for graph updates after creating new curves
-	while (curveUpdateBufferCount > 0) {
-		WINDAT * curveData = &curveUpdateBuffer[curveUpdateBufferCount--];
-		Curve *curve = (Curve *) getCurveById(curveData->windid);
-        qDebug() << "WidgetLayout::updateData" << "size: " << curveUpdateBuffer.size()
-                 << " ---" << curveData->windid << curveData->npts;
-        if (curve != nullptr && curveData != nullptr) {
-            curve->set_size(curveData->npts);    // number of points
-			curve->set_data(curveData->fdata);
-            curve->set_caption(QString(curveData->caption));
-            // curve->set_polarity(windat->polarity);
-            curve->set_max(curveData->max);
-            curve->set_min(curveData->min);
-            curve->set_absmax(curveData->absmax);
-            // Y axis scaling factor
-            // curve->set_y_scale(windat->y_scale);
+	closing = 0;
+	updateTimer.singleShot(msec, this, SLOT(updateData()));
+}
+
+bool WidgetLayout::updateFrame()
+{
+	QCS_TRACE_SCOPE("updateData");
+	refreshWidgets();
+	if (!layoutMutex.tryLock(1)) {
+		return false;
+	}
+	GraphBuffer *pending = newGraphBuffers.exchange(nullptr, std::memory_order_acquire);
+	if (pending != nullptr) {
+		QList<GraphBuffer *> created; // The stack has the newest first
+		for (; pending != nullptr; pending = pending->nextPending) {
+			created.prepend(pending);
+		}
+		foreach (GraphBuffer *buffer, created) {
+			if (buffer->firstOfCurve) {
+				newCurve(buffer->curve());  // Register new curve
+			}
+			graphBuffers.append(buffer);
+		}
+	}
+	// Only the newest frame of each graph is drawn
+	foreach (GraphBuffer *buffer, graphBuffers) {
+		const GraphFrame *frame = buffer->read();
+		if (frame != nullptr) {
+			Curve *curve = buffer->curve();
+			curve->set_size(frame->npts);    // number of points
+			curve->set_data(frame->data);
+			// curve->set_polarity(windat->polarity);
+			curve->set_max(frame->max);
+			curve->set_min(frame->min);
+			curve->set_absmax(frame->absmax);
+			// Y axis scaling factor
+			// curve->set_y_scale(windat->y_scale);
 			setCurveData(curve);
 		}
-        // delete curveData; //FIXME don't do this deleting here...
 	}
 	for (int i = 0; i < scopeWidgets.size(); i++) {
 		scopeWidgets[i]->updateData();
 	}
+	for (int i = 0; i < spectrumWidgets.size(); i++) {
+		spectrumWidgets[i]->updateData();
+	}
+	for (int i = 0; i < spectrogramWidgets.size(); i++) {
+		spectrogramWidgets[i]->updateData();
+	}
+	for (int i = 0; i < tableWidgets.size(); i++) {
+		tableWidgets[i]->updateData();
+	}
 	layoutMutex.unlock();
-	closing = 0;
-	updateTimer.singleShot(msec, this, SLOT(updateData()));
+	return true;
 }
 
 void WidgetLayout::widgetSelected(QuteWidget *widget)
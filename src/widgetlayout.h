@@ -30,7 +30,10 @@
 
 #include "qutewidget.h"
 #include "curve.h"
+#include "graphbuffer.h"
 #include "widgetpreset.h"
+#include "midiqueue.h"
+#include "hostinput.h"
 
 class QuteConsole;
 class QuteGraph;
@@ -38,6 +41,8 @@ class QuteScope;
 class QuteButton;
 class FrameWidget;
 class QuteTable;
+class QuteSpectrum;
+class QuteSpectrogram;
 
 class RegisteredController {
 public:
@@ -81,7 +86,6 @@ public:
 	void setValue(int index, QString value);
 	QString getStringForChannel(QString channelName, bool *modified = 0);
 	double getValueForChannel(QString channelName, bool *modified = 0);
-	void getMouseValues(QVector<double> *values);
 	int getMouseX();
 	int getMouseY();
 	int getMouseRelX();
@@ -119,12 +123,17 @@ public:
 	QString newMacWidget(QString widgetLine, bool offset = false);  // Offset is used when pasting duplicated widgets
 	void registerWidget(QuteWidget *widget);
 
-	QVector<QVector<int> > midiQueue;
-	int midiWriteCounter;
-	int midiReadCounter;
+	// MIDI in for learned controllers
+	void setMidiQueue(MidiQueue *queue);
+	void setHostInput(HostInput *input); // Receives mouse and modifier state for the engine
+	void midiQueued(); // Thread safe, called after pushing to the queue
 
 	// Notifiations
 	void engineStopped(); // To let the widgets know engine has stopped (to free unused curve buffers)
+	// Analysis threads read the engine's user data, the engine stops them
+	// before the performance is cleaned up
+	void startAnalysis();
+	void stopAnalysis();
 
 	// Preset methods
 	void setPresetName(int num, QString name);
@@ -142,8 +151,14 @@ public:
 	int killCurves(CSOUND *csound);
 	void clearGraphs(); // This also frees the memory allocated by curves.
 	void flushGraphBuffer();
+	qint64 curvesMemoryUsage();
+
+	// Undo history
+	void trimHistory(); // Keep only the current state
+	qint64 historyMemoryUsage();
 
 	void refreshWidgets();
+	bool updateFrame(); // One GUI refresh (widgets, curves, scopes). False if the layout was busy
 	bool isModified();
 	//    void passWidgetClipboard(QString text);
 
@@ -176,6 +191,8 @@ public:
 	QAction *createGraphAct;
 	QAction *createScopeAct;
     QAction *createTableDisplayAct;
+	QAction *createSpectrumAct;
+	QAction *createSpectrogramAct;
 
 	// Alignment Actions
 	QAction *alignLeftAct;
@@ -200,7 +217,6 @@ public:
 	QHash<QString, QString> newStringValues;
 	QMutex valueMutex;
 	QMutex stringValueMutex;
-	QReadWriteLock mouseLock;
 
     QString getQml();
 
@@ -223,6 +239,8 @@ public slots:
 	QString createNewGraph(int x = -1, int y = -1, QString channel = QString());
 	QString createNewScope(int x = -1, int y = -1, QString channel = QString());
     QString createNewTableDisplay(int x= -1, int y= -1, QString channel = QString());
+	QString createNewSpectrum(int x = -1, int y = -1, QString channel = QString());
+	QString createNewSpectrogram(int x = -1, int y = -1, QString channel = QString());
 
 	void clearWidgets();
 	void clearWidgetLayout();
@@ -295,9 +313,10 @@ public slots:
 	void newValue(QPair<QString, double> channelValue);
 	void newValue(QPair<QString, QString> channelValue);
 	void processNewValues();
+	void processMidiQueue(); // Passes MIDI in to learned controllers
 	void queueEvent(QString eventLine);
 
-    void processUpdateCurve(Curve *curve);
+	void graphShowingCurve(QuteGraph *graph, Curve *curve);
 	// Messages
 	void appendMessage(QString message);
 
@@ -313,13 +332,24 @@ protected:
 	int startx, starty;
 
 private:
+	static int hostModifiers(Qt::KeyboardModifiers modifiers);
+	void publishMouse(Qt::KeyboardModifiers modifiers);
+	void pushGraphBuffer(GraphBuffer *buffer, bool newCurve);
 
 	QMutex widgetsMutex;
 	QMutex layoutMutex;
-	QList<Curve *> newCurveBuffer;  // To store curves from Csound for widget panel Graph widgets
-	QVector<WINDAT> curveUpdateBuffer; // FIXME move these buffers to documentpage to avoid duplication when having multiple panels
-	int curveUpdateBufferCount;
+	// Graph windows created by Csound, waiting to be registered by updateFrame().
+	// A lock free stack linked by GraphBuffer::nextPending, pushed by the
+	// performance thread and taken whole by the GUI
+	std::atomic<GraphBuffer *> newGraphBuffers; // FIXME move these buffers to documentpage to avoid duplication when having multiple panels
+	QList<GraphBuffer *> graphBuffers;    // One per graph window, windat->windid points to it
+	// Only used by the performance thread while running, and by the GUI when stopped
+	QHash<QString, GraphBuffer *> graphBuffersByCaption; // Newest buffer for each caption
+	QHash<uintptr_t, Curve *> curvesById; // By window id, registered or not
 	QList<Curve *> curves;
+	// Graph widgets showing each curve, only these are updated when it changes
+	QHash<Curve *, QList<QuteGraph *> > curveSubscribers;
+	QHash<QuteGraph *, Curve *> graphSubscriptions;
 	QTimer updateTimer;
 
 	unsigned long m_ksmpscount;  // Ksmps counter for Csound engine (Really needed here?)
@@ -359,6 +389,16 @@ private:
 	int m_currentPreset; // If -1 no current preset
 
 	QList<RegisteredController> registeredControllers;
+	MidiQueue *m_midiQueue;
+	HostInput *m_hostInput;
+	MidiQueue::Reader m_midiReader;
+	QAtomicInt m_midiPending; // A processMidiQueue() call has been posted
+	QVector<QVector<QuteWidget *> > m_midiDispatch; // 16 channels * 128 controllers
+	bool m_midiDispatchDirty; // registeredControllers changed since the last rebuild
+	unsigned char m_midiMsb[16][32]; // Last MSB of 14-bit controllers, per channel
+	// Controllers 32-63 are only taken as the LSB of controller n - 32 once
+	// its MSB has been received, otherwise they are ordinary controllers
+	bool m_midiMsbSeen[16][32];
 
 	// Contained Widgets
 	QVector<QuteWidget *> m_widgets;
@@ -370,6 +410,9 @@ private:
 	QVector<QuteConsole *> consoleWidgets;
 	QVector<QuteGraph *> graphWidgets;
 	QVector<QuteScope *> scopeWidgets;
+	QVector<QuteSpectrum *> spectrumWidgets;
+	QVector<QuteSpectrogram *> spectrogramWidgets;
+	QVector<QuteTable *> tableWidgets;
 	int m_activeWidgets; // Keeps a number of widgets that can be currently accessed by value callbacks (e.g. set to 0 during paste). This is done to avoid locking the callbacks, which are called from a realtime thread
 
 	int parseXmlNode(QDomNode node);
@@ -388,6 +431,8 @@ private:
 	QString createScope(int x, int y, int width, int height, QString widgetLine);
 	QString createDummy(int x, int y, int width, int height, QString widgetLine);
     QString createTableDisplay(int x, int y, int width, int height, QString widgetLine);
+	QString createSpectrum(int x, int y, int width, int height, QString channel);
+	QString createSpectrogram(int x, int y, int width, int height, QString channel);
 
 
 	void setBackground(bool bg, QColor bgColor);
@@ -397,6 +442,7 @@ private:
 	void registerWidgetChannel(QuteWidget *widget, int chan);
 	void unregisterWidgetController(QuteWidget *widget);
 	void clearWidgetControllers();
+	void rebuildMidiDispatch();
 
 	//Undo history
 	void clearHistory();